@@ -105,6 +105,10 @@ SOURCE=..\LASzip\src\arithmeticmodel.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\bytestreamout_async.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\fopen_compressed.cpp
 # End Source File
 # Begin Source File
@@ -113,6 +117,14 @@ SOURCE=..\LASzip\src\integercompressor.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\lascatalog.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\laschunkcopier.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\lasfilter.cpp
 # End Source File
 # Begin Source File
@@ -125,6 +137,22 @@ SOURCE=.\src\lasinterval.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\lasoctree.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\laspipeline.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\laspointfast.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\laspointraw.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\lasquadtree.cpp
 # End Source File
 # Begin Source File
@@ -145,6 +173,10 @@ SOURCE=.\src\lasreader_bin.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\lasreader_col.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\lasreader_dtm.cpp
 # End Source File
 # Begin Source File
@@ -173,6 +205,10 @@ SOURCE=.\src\lasreadermerged.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\lasreaderoctree.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\lasreaderpipeon.cpp
 # End Source File
 # Begin Source File
@@ -189,10 +225,22 @@ SOURCE=..\LASzip\src\lasreadpoint.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\lasrtree.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\lassharedpipe.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\lasspatial.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\lasthread.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\lastransform.cpp
 # End Source File
 # Begin Source File
@@ -229,6 +277,10 @@ SOURCE=.\src\laswriter_bin.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\laswriter_col.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\laswriter_las.cpp
 # End Source File
 # Begin Source File
@@ -281,6 +333,10 @@ SOURCE=..\LASzip\src\bytestreamout.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\inc\bytestreamout_async.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\LASzip\src\bytestreamout_file.hpp
 # End Source File
 # Begin Source File
@@ -301,6 +357,14 @@ SOURCE=.\inc\lasdefinitions.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\inc\lascatalog.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\inc\laschunkcopier.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\inc\lasfilter.hpp
 # End Source File
 # Begin Source File
@@ -313,6 +377,22 @@ SOURCE=.\inc\lasinterval.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\inc\lasoctree.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\inc\laspipeline.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\inc\laspointfast.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\inc\laspointraw.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\inc\lasquadtree.hpp
 # End Source File
 # Begin Source File
@@ -333,6 +413,10 @@ SOURCE=.\inc\lasreader_bin.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\inc\lasreader_col.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\inc\lasreader_dtm.hpp
 # End Source File
 # Begin Source File
@@ -361,6 +445,10 @@ SOURCE=.\inc\lasreadermerged.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\inc\lasreaderoctree.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\inc\lasreaderpipeon.hpp
 # End Source File
 # Begin Source File
@@ -385,10 +473,26 @@ SOURCE=..\LASzip\src\lasreadpoint.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\inc\lasrtree.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\inc\lasscan.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\inc\lassharedpipe.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\inc\lasspatial.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\inc\lasthread.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\inc\lastransform.hpp
 # End Source File
 # Begin Source File
@@ -433,6 +537,10 @@ SOURCE=.\inc\laswriter_bin.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\inc\laswriter_col.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\inc\laswriter_las.hpp
 # End Source File
 # Begin Source File
@@ -26,6 +26,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- '-threaded' modifies and writes points on their own threads
     3 January 2011 -- created while too homesick to go to Salzburg with Silke
   
 ===============================================================================
@@ -38,6 +39,7 @@
 
 #include "lasreader.hpp"
 #include "laswriter.hpp"
+#include "laspipeline.hpp"
 
 void usage(bool wait=false)
 {
@@ -45,6 +47,7 @@ void usage(bool wait=false)
   fprintf(stderr,"lasexample in.las out.las\n");
   fprintf(stderr,"lasexample -i in.las -o out.las -verbose\n");
   fprintf(stderr,"lasexample -ilas -olas < in.las > out.las\n");
+  fprintf(stderr,"lasexample -i in.laz -o out.laz -threaded\n");
   fprintf(stderr,"lasexample -h\n");
   if (wait)
   {
@@ -64,6 +67,19 @@ static void byebye(bool error=false, bool wait=false)
   exit(error);
 }
 
+class LASexampleStage : public LASpipelineStage
+{
+public:
+  bool process(LASpoint* point)
+  {
+    point->set_point_source_ID(1020);
+    point->set_user_data(42);
+    if (point->get_classification() == 12) point->set_classification(1);
+    point->set_Z(point->get_Z() + 10);
+    return TRUE;
+  };
+};
+
 static double taketime()
 {
   return (double)(clock())/CLOCKS_PER_SEC;
@@ -73,6 +89,7 @@ int main(int argc, char *argv[])
 {
   int i;
   bool verbose = false;
+  bool threaded = false;
   double start_time = 0.0;
 
   LASreadOpener lasreadopener;
@@ -109,6 +126,10 @@ int main(int argc, char *argv[])
     {
       verbose = true;
     }
+    else if (strcmp(argv[i],"-threaded") == 0)
+    {
+      threaded = true;
+    }
     else if (i == argc - 2 && !lasreadopener.active() && !laswriteopener.active())
     {
       lasreadopener.set_file_name(argv[i]);
@@ -168,10 +189,24 @@ int main(int argc, char *argv[])
   if (verbose) fprintf(stderr, "reading %lld points from '%s' and writing them modified to '%s'.\n", lasreader->npoints, lasreadopener.get_file_name(), laswriteopener.get_file_name());
 #endif
 
+  if (threaded)
+  {
+    // reading, modifying, and writing happen on three threads
+    LASexampleStage lasexamplestage;
+    LASpipeline laspipeline;
+    laspipeline.add_stage(&lasexamplestage);
+    laspipeline.add_writer(laswriter);
+    if (laspipeline.run(lasreader) < 0)
+    {
+      fprintf(stderr, "ERROR: pipeline failed\n");
+      byebye(true, argc==1);
+    }
+  }
+
   // loop over points and modify them
 
   // where there is a point to read
-  while (lasreader->read_point())
+  while (!threaded && lasreader->read_point())
   {
     // modify the point
     lasreader->point.set_point_source_ID(1020);
@@ -0,0 +1,346 @@
+/*
+===============================================================================
+
+  FILE:  lasindexinfo.cpp
+
+  CONTENTS:
+
+    This tool answers point counts, coverage (occupancy) and coarse density
+    questions for one or many LAS/LAZ files only by looking at their LAX
+    spatial indices. Not a single point is read (or decompressed) so that
+    the extent and the density of huge archives can be explored in seconds.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created for planning jobs over very large archives
+
+===============================================================================
+*/
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lasreader.hpp"
+#include "lasindex.hpp"
+#include "lasspatial.hpp"
+#include "lasinterval.hpp"
+
+void usage(bool wait=false)
+{
+  fprintf(stderr,"usage:\n");
+  fprintf(stderr,"lasindexinfo -i tiles\\*.laz\n");
+  fprintf(stderr,"lasindexinfo -i tiles\\*.laz -count 630000 4830000 631000 4831000\n");
+  fprintf(stderr,"lasindexinfo -i tiles\\*.laz -step 100 -o density.asc\n");
+  fprintf(stderr,"lasindexinfo -i lidar.las -level 6 -occupancy -o occupancy.asc\n");
+  fprintf(stderr,"lasindexinfo -lof file_list.txt -step 500 -counts -o counts.asc\n");
+  fprintf(stderr,"lasindexinfo -h\n");
+  fprintf(stderr,"lasindexinfo -i tiles\\*.laz -auto_index_cache lax_cache -step 100 -o density.asc\n");
+  fprintf(stderr,"only the (external) LAX files are read. files without LAX are reported.\n");
+  if (wait)
+  {
+    fprintf(stderr,"<press ENTER>\n");
+    getc(stdin);
+  }
+  exit(1);
+}
+
+static void byebye(bool error=false, bool wait=false)
+{
+  if (wait)
+  {
+    fprintf(stderr,"<press ENTER>\n");
+    getc(stdin);
+  }
+  exit(error);
+}
+
+static double taketime()
+{
+  return (double)(clock())/CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+  int i;
+  bool verbose = false;
+  double start_time = 0.0;
+  F64* count_rectangle = 0;
+  F64 step = 0.0;
+  I32 level = -1;
+  bool occupancy = false;
+  bool counts_only = false;
+  const char* file_name_out = 0;
+
+  LASreadOpener lasreadopener;
+
+  if (argc == 1)
+  {
+    fprintf(stderr,"lasindexinfo.exe is better run in the command line\n");
+    char file_name[256];
+    fprintf(stderr,"enter input file: "); fgets(file_name, 256, stdin);
+    file_name[strlen(file_name)-1] = '\0';
+    lasreadopener.set_file_name(file_name);
+  }
+  else
+  {
+    lasreadopener.parse(argc, argv);
+  }
+
+  for (i = 1; i < argc; i++)
+  {
+    if (argv[i][0] == '\0')
+    {
+      continue;
+    }
+    else if (strcmp(argv[i],"-h") == 0 || strcmp(argv[i],"-help") == 0)
+    {
+      usage();
+    }
+    else if (strcmp(argv[i],"-v") == 0 || strcmp(argv[i],"-verbose") == 0)
+    {
+      verbose = true;
+    }
+    else if (strcmp(argv[i],"-count") == 0)
+    {
+      if ((i+4) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 4 arguments: min_x min_y max_x max_y\n", argv[i]);
+        byebye(true);
+      }
+      count_rectangle = new F64[4];
+      count_rectangle[0] = atof(argv[i+1]);
+      count_rectangle[1] = atof(argv[i+2]);
+      count_rectangle[2] = atof(argv[i+3]);
+      count_rectangle[3] = atof(argv[i+4]);
+      i+=4;
+    }
+    else if (strcmp(argv[i],"-step") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: size\n", argv[i]);
+        byebye(true);
+      }
+      step = atof(argv[i+1]);
+      i++;
+    }
+    else if (strcmp(argv[i],"-level") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: level\n", argv[i]);
+        byebye(true);
+      }
+      level = atoi(argv[i+1]);
+      i++;
+    }
+    else if (strcmp(argv[i],"-occupancy") == 0)
+    {
+      occupancy = true;
+    }
+    else if (strcmp(argv[i],"-counts") == 0)
+    {
+      counts_only = true;
+    }
+    else if (strcmp(argv[i],"-o") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: file_name\n", argv[i]);
+        byebye(true);
+      }
+      file_name_out = argv[i+1];
+      i++;
+    }
+    else if (i == argc - 1 && !lasreadopener.active())
+    {
+      lasreadopener.set_file_name(argv[i]);
+    }
+    else
+    {
+      fprintf(stderr, "ERROR: cannot understand argument '%s'\n", argv[i]);
+      usage();
+    }
+  }
+
+  if (verbose) start_time = taketime();
+
+  // check input
+
+  if (!lasreadopener.active())
+  {
+    fprintf(stderr,"ERROR: no input specified\n");
+    usage(argc == 1);
+  }
+
+  if ((step < 0.0) || (level > 20))
+  {
+    fprintf(stderr,"ERROR: step %g or level %d out of range\n", step, level);
+    byebye(true, argc == 1);
+  }
+
+  // first pass over all LAX files: totals, extent, and rectangle counts
+
+  U32 f, file_number = lasreadopener.get_file_name_number();
+  U32 indexed = 0;
+  F64 total = 0.0;
+  F64 lower = 0.0;
+  F64 upper = 0.0;
+  F64 min_x = 0.0, min_y = 0.0, max_x = 0.0, max_y = 0.0;
+  F64 level_step = 0.0;
+
+  for (f = 0; f < file_number; f++)
+  {
+    LASindex lasindex;
+    if (!lasindex.read(lasreadopener.get_file_name(f), lasreadopener.get_auto_index_directory()))
+    {
+      fprintf(stderr,"WARNING: no LAX file for '%s'\n", lasreadopener.get_file_name(f));
+      continue;
+    }
+    LASspatial* lasspatial = lasindex.get_spatial();
+    if (indexed == 0)
+    {
+      min_x = lasspatial->get_min_x();
+      min_y = lasspatial->get_min_y();
+      max_x = lasspatial->get_max_x();
+      max_y = lasspatial->get_max_y();
+    }
+    else
+    {
+      if (lasspatial->get_min_x() < min_x) min_x = lasspatial->get_min_x();
+      if (lasspatial->get_min_y() < min_y) min_y = lasspatial->get_min_y();
+      if (lasspatial->get_max_x() > max_x) max_x = lasspatial->get_max_x();
+      if (lasspatial->get_max_y() > max_y) max_y = lasspatial->get_max_y();
+    }
+    // with files of different extents the finest cell size of the level is used
+    if (level >= 0)
+    {
+      F64 file_step = (lasspatial->get_max_x() - lasspatial->get_min_x())/(1 << level);
+      if ((level_step == 0.0) || (file_step < level_step)) level_step = file_step;
+    }
+    U32 count = lasindex.count_points();
+    total += count;
+    if (count_rectangle)
+    {
+      U32 file_lower, file_upper;
+      if (lasindex.count_rectangle(count_rectangle[0], count_rectangle[1], count_rectangle[2], count_rectangle[3], &file_lower, &file_upper))
+      {
+        lower += file_lower;
+        upper += file_upper;
+        if (verbose) fprintf(stderr,"'%s' has between %u and %u of its %u points in rectangle\n", lasreadopener.get_file_name(f), file_lower, file_upper, count);
+      }
+    }
+    else if (verbose)
+    {
+      fprintf(stderr,"'%s' has %u points in %u cells\n", lasreadopener.get_file_name(f), count, lasindex.get_interval()->get_number_cells());
+    }
+    indexed++;
+  }
+
+  if (indexed == 0)
+  {
+    fprintf(stderr,"ERROR: none of the %u files has a LAX file\n", file_number);
+    byebye(true, argc == 1);
+  }
+
+  fprintf(stdout, "%u of %u files indexed with %.0f points in extent %.2f %.2f %.2f %.2f\n", indexed, file_number, total, min_x, min_y, max_x, max_y);
+  if (count_rectangle)
+  {
+    fprintf(stdout, "between %.0f and %.0f points in rectangle %g %g %g %g\n", lower, upper, count_rectangle[0], count_rectangle[1], count_rectangle[2], count_rectangle[3]);
+  }
+
+  // second pass: accumulate the counts of all LAX files into one raster
+
+  if (level >= 0) step = level_step;
+
+  if (step > 0.0)
+  {
+    if (file_name_out == 0)
+    {
+      fprintf(stderr,"ERROR: no output raster specified\n");
+      byebye(true, argc == 1);
+    }
+    F64 cols = (max_x - min_x)/step + 1;
+    F64 rows = (max_y - min_y)/step + 1;
+    if ((cols*rows*sizeof(F32)) >= (F64)U32_MAX)
+    {
+      fprintf(stderr,"ERROR: raster of %.0f by %.0f is too large for cell size %g\n", cols, rows, step);
+      byebye(true, argc == 1);
+    }
+    U32 ncols = (U32)cols;
+    U32 nrows = (U32)rows;
+    F32* counts = (F32*)malloc(sizeof(F32)*ncols*nrows);
+    if (counts == 0)
+    {
+      fprintf(stderr,"ERROR: cannot allocate raster of %u by %u\n", ncols, nrows);
+      byebye(true, argc == 1);
+    }
+    memset(counts, 0, sizeof(F32)*ncols*nrows);
+    for (f = 0; f < file_number; f++)
+    {
+      LASindex lasindex;
+      if (lasindex.read(lasreadopener.get_file_name(f), lasreadopener.get_auto_index_directory()))
+      {
+        lasindex.raster_counts(min_x, min_y, step, ncols, nrows, counts);
+      }
+    }
+    FILE* file = fopen(file_name_out, "w");
+    if (file == 0)
+    {
+      fprintf(stderr,"ERROR: cannot open '%s' for write\n", file_name_out);
+      free(counts);
+      byebye(true, argc == 1);
+    }
+    // ESRI ASCII grid with the top row first
+    fprintf(file, "ncols %u\n", ncols);
+    fprintf(file, "nrows %u\n", nrows);
+    fprintf(file, "xllcorner %.10g\n", min_x);
+    fprintf(file, "yllcorner %.10g\n", min_y);
+    fprintf(file, "cellsize %.10g\n", step);
+    fprintf(file, "NODATA_value -9999\n");
+    U32 col, row = nrows;
+    while (row)
+    {
+      row--;
+      for (col = 0; col < ncols; col++)
+      {
+        F32 value = counts[row*ncols+col];
+        if (occupancy)
+          fprintf(file, "%d ", (value > 0.0f ? 1 : 0));
+        else if (counts_only)
+          fprintf(file, "%.0f ", value);
+        else
+          fprintf(file, "%g ", value/(step*step));
+      }
+      fprintf(file, "\n");
+    }
+    fclose(file);
+    free(counts);
+    if (verbose) fprintf(stderr,"wrote %u by %u raster with cell size %g to '%s'\n", ncols, nrows, step, file_name_out);
+  }
+
+  if (count_rectangle) delete [] count_rectangle;
+
+  if (verbose) fprintf(stderr,"total time: %g sec for %u LAX files\n", taketime()-start_time, indexed);
+
+  byebye(false, argc==1);
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+/*
+===============================================================================
+
+  FILE:  bytestreamout_async.hpp
+
+  CONTENTS:
+
+    A ByteStreamOut for files that collects the bytes in large blocks and
+    hands full blocks to a separate I/O thread. The caller only waits when
+    all blocks are in flight. Write errors are remembered and reported by
+    flush() so that the writer can surface them at close().
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the COPYING file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created so that compressing points never waits on the disk
+
+===============================================================================
+*/
+#ifndef BYTE_STREAM_OUT_ASYNC_HPP
+#define BYTE_STREAM_OUT_ASYNC_HPP
+
+#include "bytestreamout.hpp"
+#include "lasthread.hpp"
+
+#include <stdio.h>
+
+class ByteStreamOutFileAsync : public ByteStreamOut
+{
+public:
+  ByteStreamOutFileAsync(FILE* file, U32 buffer_size=262144, U32 number_buffers=4);
+/* replace a closed FILE* with a reopened FILE* in "ab" mode */
+  bool refile(FILE* file);
+/* write a single byte                                       */
+  bool putByte(U8 byte);
+/* write an array of bytes                                   */
+  bool putBytes(const U8* bytes, U32 num_bytes);
+/* is the stream seekable (e.g. standard out is not)         */
+  bool isSeekable() const;
+/* get current position of stream                            */
+  I64 tell() const;
+/* seek to this position in the stream                       */
+  bool seek(const I64 position);
+/* seek to the end of the file                               */
+  bool seekEnd();
+/* wait until all bytes are on disk and report any failures  */
+  bool flush();
+/* destructor                                                */
+  ~ByteStreamOutFileAsync();
+protected:
+  bool queue_current();
+  static void write_buffers(void* data);
+  FILE* file;
+  U8** buffers;
+  U32* sizes;
+  U32 buffer_size;
+  U32 number_buffers;
+  U32 head;
+  U32 count;
+  U32 current;
+  I64 position;
+  bool failed;
+  bool stop;
+  LASmutex mutex;
+  LAScondition filled;
+  LAScondition emptied;
+  LASthread thread;
+};
+
+class ByteStreamOutFileAsyncLE : public ByteStreamOutFileAsync
+{
+public:
+  ByteStreamOutFileAsyncLE(FILE* file, U32 buffer_size=262144, U32 number_buffers=4);
+/* write 16 bit low-endian field                             */
+  bool put16bitsLE(const U8* bytes);
+/* write 32 bit low-endian field                             */
+  bool put32bitsLE(const U8* bytes);
+/* write 64 bit low-endian field                             */
+  bool put64bitsLE(const U8* bytes);
+/* write 16 bit big-endian field                             */
+  bool put16bitsBE(const U8* bytes);
+/* write 32 bit big-endian field                             */
+  bool put32bitsBE(const U8* bytes);
+/* write 64 bit big-endian field                             */
+  bool put64bitsBE(const U8* bytes);
+private:
+  U8 swapped[8];
+};
+
+class ByteStreamOutFileAsyncBE : public ByteStreamOutFileAsync
+{
+public:
+  ByteStreamOutFileAsyncBE(FILE* file, U32 buffer_size=262144, U32 number_buffers=4);
+/* write 16 bit low-endian field                             */
+  bool put16bitsLE(const U8* bytes);
+/* write 32 bit low-endian field                             */
+  bool put32bitsLE(const U8* bytes);
+/* write 64 bit low-endian field                             */
+  bool put64bitsLE(const U8* bytes);
+/* write 16 bit big-endian field                             */
+  bool put16bitsBE(const U8* bytes);
+/* write 32 bit big-endian field                             */
+  bool put32bitsBE(const U8* bytes);
+/* write 64 bit big-endian field                             */
+  bool put64bitsBE(const U8* bytes);
+private:
+  U8 swapped[8];
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*
+===============================================================================
+
+  FILE:  lascatalog.hpp
+  
+  CONTENTS:
+  
+    A catalog (or virtual dataset) of many LAS/LAZ files that remembers what
+    the merged header and the bounding box pruning need from every file: its
+    bounding box, point counts, point format, scale and offset, and its
+    modification time. No file is touched while the merged header is built.
+    An entry is checked against the modification time of its file once it
+    is first used for pruning (where a changed file is peeked into again)
+    or for reading (where a change can only be reported). Whether a file
+    has a LAX is not remembered since a LAX may be written at any time.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  
+  CHANGE HISTORY:
+  
+    19 October 2026 -- created for archives with hundreds of thousands of tiles
+  
+===============================================================================
+*/
+#ifndef LAS_CATALOG_HPP
+#define LAS_CATALOG_HPP
+
+#include "mydefs.hpp"
+
+class LASreader;
+
+class LAScatalogEntry
+{
+public:
+  I64 mtime;
+  bool valid;
+  bool buffered;
+  I64 npoints;
+  U32 number_of_point_records;
+  U32 number_of_points_by_return[5];
+  U8 point_data_format;
+  U16 point_data_record_length;
+  F64 min_x, min_y, min_z;
+  F64 max_x, max_y, max_z;
+  F64 x_scale_factor, y_scale_factor, z_scale_factor;
+  F64 x_offset, y_offset, z_offset;
+
+  // copy from or to the header of an opened (or peeked) reader
+  void set(const LASreader* lasreader);
+  void get(LASreader* lasreader) const;
+
+  LAScatalogEntry();
+};
+
+class LAScatalog
+{
+public:
+  bool read(const CHAR* file_name);
+  bool write(const CHAR* file_name) const;
+
+  U32 add_entry(const CHAR* file_name, const LAScatalogEntry* entry);
+  I32 find_entry(const CHAR* file_name) const;
+  inline U32 get_number_entries() const { return number_entries; };
+  inline const CHAR* get_file_name(U32 i) const { return file_names[i]; };
+  inline const LAScatalogEntry* get_entry(U32 i) const { return &entries[i]; };
+
+  // an entry is current while the modification time of its file is unchanged
+  // (this stat()s the file so it is only asked once the entry is first used)
+  bool is_current(U32 i) const;
+
+  static I64 get_mtime(const CHAR* file_name);
+
+  LAScatalog();
+  ~LAScatalog();
+
+private:
+  void clean();
+  U32 number_entries;
+  U32 alloc_entries;
+  CHAR** file_names;
+  LAScatalogEntry* entries;
+  void* lookup;
+};
+
+#endif
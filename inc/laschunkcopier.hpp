@@ -0,0 +1,79 @@
+/*
+===============================================================================
+
+  FILE:  laschunkcopier.hpp
+
+  CONTENTS:
+
+    Merges chunked LAZ files into one LAZ file by appending their compressed
+    chunks verbatim instead of decompressing and recompressing every point.
+    With a clip rectangle the chunks that are completely inside are still
+    copied verbatim and only those straddling the boundary are re-encoded.
+    Chunks that the LAX file puts completely outside are never decoded.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created to turn merging LAZ tiles into pure I/O
+
+===============================================================================
+*/
+#ifndef LAS_CHUNK_COPIER_HPP
+#define LAS_CHUNK_COPIER_HPP
+
+#include "lasdefinitions.hpp"
+
+class LASreadOpener;
+class LASreaderLAS;
+class LASwriterLAS;
+
+class LASchunkcopier
+{
+public:
+  // all files of the opener must be chunked LAZ with the point layout, scale,
+  // and offset of the first one and the opener may only ask for a rectangle.
+  // returns the number of points written or -1 when the files do not qualify
+  // and nothing was written so that the caller can read the points instead.
+  // a copy that fails midway also returns -1 and removes its output file.
+  I64 copy(LASreadOpener* lasreadopener, const CHAR* file_name_out);
+
+  inline U32 get_chunks_copied() const { return chunks_copied; };
+  inline U32 get_chunks_recoded() const { return chunks_recoded; };
+  inline U32 get_chunks_skipped() const { return chunks_skipped; };
+
+  LASchunkcopier();
+  ~LASchunkcopier();
+
+private:
+  bool qualifies(const LASheader* header) const;
+  bool copy_file(LASreaderLAS* lasreaderlas, const CHAR* file_name);
+  bool copy_chunk(LASreaderLAS* lasreaderlas, U32 chunk);
+  bool clip_chunk(LASreaderLAS* lasreaderlas, U32 chunk, I64 first_point);
+  bool reserve_bytes(U32 number_bytes);
+  const LASheader* first;
+  LASwriterLAS* laswriterlas;
+  LASzip* laszip;
+  bool clip;
+  F64 r_min_x, r_min_y, r_max_x, r_max_y;
+  U8* bytes;
+  U32 alloc_bytes;
+  U32 chunks_copied;
+  U32 chunks_recoded;
+  U32 chunks_skipped;
+};
+
+#endif
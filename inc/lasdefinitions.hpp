@@ -31,6 +31,8 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LAS_TOOLS_FORMAT_LAC for columnar files with chunk statistics
+    19 October 2026 -- LAS_TOOLS_FORMAT_LAF for LAS files with fast compressed points
     9 December 2013 -- bug fix and improved writing of new LAS 1.4 point types
     21 December 2011 -- (limited) support for LAS 1.4 and attributed extra bytes 
     10 January 2011 -- licensing change for LGPL release and liblas integration
@@ -67,6 +69,8 @@
 #define LAS_TOOLS_FORMAT_BIL     9
 #define LAS_TOOLS_FORMAT_FLT    10
 #define LAS_TOOLS_FORMAT_DTM    11
+#define LAS_TOOLS_FORMAT_LAF    12
+#define LAS_TOOLS_FORMAT_LAC    13
 
 class LASwavepacket
 {
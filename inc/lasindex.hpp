@@ -27,6 +27,10 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- preview queries read a fraction of every cell up to a point budget
+    19 October 2026 -- optional read-ahead and coalescing of the intervals of a query
+    19 October 2026 -- point counts and density rasters computed from the LAX alone
+    19 October 2026 -- optional cache directory for LAX files of read-only data
     29 April 2011 -- created after cable outage during the royal wedding (-:
   
 ===============================================================================
@@ -53,10 +57,10 @@ public:
   bool add(const LASpoint* point, const U32 index);
   void complete(U32 minimum_points=100000, I32 maximum_intervals=-1);
 
-  // read from file or write to file
-  bool read(const char* file_name);
+  // read from file or write to file (optionally falling back to a cache directory)
+  bool read(const char* file_name, const char* directory=0);
   bool append(const char* file_name) const;
-  bool write(const char* file_name) const;
+  bool write(const char* file_name, const char* directory=0) const;
   bool read(ByteStreamIn* stream);
   bool write(ByteStreamOut* stream) const;
 
@@ -65,6 +69,11 @@ public:
   bool intersect_tile(const F32 ll_x, const F32 ll_y, const F32 size);
   bool intersect_circle(const F64 center_x, const F64 center_y, const F64 radius);
 
+  // index-only queries that never read (or decompress) a single point
+  U32 count_points();
+  bool count_rectangle(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, U32* lower, U32* upper);
+  bool raster_counts(const F64 ll_x, const F64 ll_y, const F64 step, const U32 ncols, const U32 nrows, F32* counts);
+
   // access the intersected intervals
   bool get_intervals();
   bool has_intervals();
@@ -75,6 +84,14 @@ public:
   U32 total;
   U32 cells;
 
+  // let the reader prefetch upcoming intervals and read through small gaps
+  void set_read_ahead(const U32 intervals, const U32 coalesce_bytes=0);
+
+  // a preview reads only the first points of each interval of each intersected
+  // cell so that about 'point_budget' points spread evenly over the query (0 = off)
+  void set_preview(const U32 point_budget);
+  inline U32 get_preview() const { return preview; };
+
   // read or seek next interval point
   bool read_next(LASreader* lasreader);
   bool seek_next(LASreader* lasreader);
@@ -88,10 +105,22 @@ public:
 
 private:
   bool merge_intervals();
+  bool get_next_range(LASreader* lasreader);
+  bool get_preview_ranges(const U32 gap);
 
   LASspatial* spatial;
   LASinterval* interval;
   bool have_interval;
+
+  U32 read_ahead;
+  U32 coalesce_bytes;
+  U32* ranges;
+  U32 ranges_alloc;
+  U32 ranges_number;
+  U32 ranges_current;
+  U32 ranges_advised;
+  bool ranges_valid;
+  U32 preview;
 };
 
 #endif
@@ -0,0 +1,112 @@
+/*
+===============================================================================
+
+  FILE:  lasoctree.hpp
+
+  CONTENTS:
+
+    Reorganizes the points of a LAS or LAZ file into an octree for level-of-
+    detail access in the spirit of cloud-optimized point clouds. The root
+    cube is split into a grid of 128 x 128 x 128 cells of which each keeps
+    only the first point that falls into it. Points finding their cell taken
+    move on to the next finer level, whose nodes have cells half the size,
+    until the deepest level takes all remaining points. The nodes are then
+    written level by level (and in Morton order within a level) with each
+    node becoming one LAZ chunk, so that reading the first levels of a file
+    gives an evenly thinned preview and reading a region down to a level
+    needs only a few seeks.
+
+    The hierarchy is stored in VLRs: one with the cube and the number of
+    nodes and as many pages of 28 bytes per node as needed, since this LAS
+    writer does not write EVLRs. The pages are VLRs with consecutive record
+    IDs starting at LAS_OCTREE_PAGE_RECORD_ID. All of them have their own
+    user ID so that no VLRs of other software are mistaken for pages.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created for level-of-detail reads from a single file
+
+===============================================================================
+*/
+#ifndef LAS_OCTREE_HPP
+#define LAS_OCTREE_HPP
+
+#include "lasdefinitions.hpp"
+
+class LASreader;
+
+#define LAS_OCTREE_USER_ID "LASoctree"
+#define LAS_OCTREE_RECORD_ID 41
+#define LAS_OCTREE_PAGE_RECORD_ID 1000
+#define LAS_OCTREE_VERSION 1
+
+// each node has (1 << LAS_OCTREE_CELLS_LOG2) cells along each axis
+#define LAS_OCTREE_CELLS_LOG2 7
+// so that the cell coordinates of the deepest level fit into 20 bits
+#define LAS_OCTREE_MAX_LEVEL 13
+
+#define LAS_OCTREE_NODE_SIZE 28
+#define LAS_OCTREE_NODES_PER_PAGE 2340
+
+class LASoctreeNode
+{
+public:
+  I32 level;
+  I32 x, y, z;
+  I64 first;
+  U32 number;
+};
+
+class LASoctree
+{
+public:
+  // the root cube
+  F64 center_x, center_y, center_z;
+  F64 halfsize;
+  // the distance between the cells of the root
+  F64 spacing;
+  I32 max_level;
+  // in the order of the points in the file
+  U32 number_nodes;
+  LASoctreeNode* nodes;
+
+  // the deepest level that build() creates (-1 picks one from the number of points)
+  void set_max_level(const I32 max_level);
+
+  // reads all points of the reader into memory and writes them in octree order
+  // to a LAZ file (or a LAS file if the name ends in '.las'). the VLRs with the
+  // hierarchy are added to a copy of the header of the reader. returns the
+  // number of points written or -1 on failure.
+  I64 build(LASreader* lasreader, const CHAR* file_name);
+
+  bool write_vlrs(LASheader* header) const;
+  bool read_vlrs(const LASheader* header);
+  void remove_vlrs(LASheader* header) const;
+  static bool is_octree_vlr(const LASvlr* vlr);
+
+  void get_bounding_box(const LASoctreeNode* node, F64* min, F64* max) const;
+
+  LASoctree();
+  ~LASoctree();
+
+private:
+  void clean();
+  I32 requested_max_level;
+};
+
+#endif
@@ -0,0 +1,85 @@
+/*
+===============================================================================
+
+  FILE:  laspipeline.hpp
+
+  CONTENTS:
+
+    Runs the stages of a typical LASlib tool - reading, filtering, transforming,
+    user-defined processing, and writing - each on its own thread within one
+    process. Stages hand over blocks of points via bounded queues so that a
+    slow stage (often the LAZ writer) throttles the reader and the points are
+    written in the same order in which they were read.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created to use all cores without the '-pipe_on' detour
+
+===============================================================================
+*/
+#ifndef LAS_PIPELINE_HPP
+#define LAS_PIPELINE_HPP
+
+#include "lasdefinitions.hpp"
+
+class LASreader;
+class LASwriter;
+class LASfilter;
+class LAStransform;
+class LASpipelineStep;
+class LASpipelineShared;
+
+class LASpipelineStage
+{
+public:
+  // return FALSE to drop the point from all later stages
+  virtual bool process(LASpoint* point) = 0;
+  virtual ~LASpipelineStage(){};
+};
+
+class LASpipeline
+{
+public:
+
+  void set_block_size(U32 points_per_block);
+  void set_number_blocks(U32 number_blocks);
+
+  // stages run in the order in which they were added
+  void add_filter(LASfilter* lasfilter);
+  void add_transform(LAStransform* lastransform);
+  void add_stage(LASpipelineStage* stage);
+  void add_writer(LASwriter* laswriter, bool update_inventory=TRUE);
+
+  // returns the number of points that reached the last stage or -1 on error
+  I64 run(LASreader* lasreader);
+
+  LASpipeline();
+  ~LASpipeline();
+
+private:
+  void add_step(LASpipelineStep* step);
+  static bool process_block(LASpipelineStep* step, LASpoint* points, U32* number);
+  static void run_step(void* data);
+  U32 points_per_block;
+  U32 number_blocks;
+  U32 number_steps;
+  U32 alloc_steps;
+  LASpipelineStep** steps;
+};
+
+#endif
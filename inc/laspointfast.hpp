@@ -0,0 +1,147 @@
+/*
+===============================================================================
+
+  FILE:  laspointfast.hpp
+
+  CONTENTS:
+
+    A light-weight alternative to LASzip for intermediate files that are
+    written once, read once, and then deleted. Points are collected into
+    chunks in which the coordinates, the GPS time, and the RGB colors are
+    delta coded, the records are split into byte columns, and each column
+    is compressed with a small LZ coder. A chunk table at the end of the
+    points makes the chunks seekable so that spatial indexing still works.
+
+    The points are written as LAS records that the host byte order stores
+    the same way, so only little-endian machines are supported.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- LASfastCoder lets the columnar format share the coder
+    19 October 2026 -- created for intermediate files that LAZ makes too slow
+
+===============================================================================
+*/
+#ifndef LAS_POINT_FAST_HPP
+#define LAS_POINT_FAST_HPP
+
+#include "mydefs.hpp"
+
+class ByteStreamIn;
+class ByteStreamOut;
+class LASitem;
+
+// the VLR that marks the points of a LAS file as fast compressed
+#define LAS_POINT_FAST_USER_ID "LASlib"
+#define LAS_POINT_FAST_RECORD_ID 40
+#define LAS_POINT_FAST_VERSION 1
+#define LAS_POINT_FAST_CODER_LZ 1
+
+// byte columns that do not get smaller are stored raw with this bit set in their size
+#define LAS_FAST_RAW_COLUMN 0x80000000
+
+#define LAS_FAST_HASH_BITS 12
+
+// the coder of the chunks that other chunked formats share
+class LASfastCoder
+{
+public:
+  // the hash table has (1 << LAS_FAST_HASH_BITS) entries. returns 0 when the output is not smaller
+  static U32 compress(const U8* in, const U32 size, U8* out, U32* hash_table);
+  static bool decompress(const U8* in, const U32 in_size, U8* out, const U32 size);
+  // zigzag deltas of the integers of 'size' bytes (2, 4, or 8) found every 'record_size' bytes
+  static void delta_encode(U8* records, const U32 number, const U32 record_size, const U32 size);
+  static void delta_decode(U8* records, const U32 number, const U32 record_size, const U32 size);
+};
+
+class LASpointFastLayout
+{
+public:
+  bool setup(const U32 num_items, const LASitem* items);
+  U32 num_items;
+  U32 item_offsets[16];
+  U32 item_sizes[16];
+  U32 record_size;
+  // the fields that are delta coded from one point to the next
+  U32 num_fields;
+  U32 field_offsets[8];
+  U32 field_sizes[8];
+};
+
+class LASwritePointFast
+{
+public:
+  bool setup(const U32 num_items, const LASitem* items, const U32 chunk_size=50000);
+  bool init(ByteStreamOut* outstream);
+  bool write(const U8* const * point);
+  bool chunk();
+  bool done();
+
+  LASwritePointFast();
+  ~LASwritePointFast();
+
+private:
+  bool write_chunk();
+  bool write_chunk_table();
+  ByteStreamOut* outstream;
+  LASpointFastLayout layout;
+  U32 chunk_size;
+  U32 points_in_chunk;
+  U8* records;
+  U8* column;
+  U8* compressed;
+  U32* hash_table;
+  I64 chunk_table_start_position;
+  U32 number_chunks;
+  U32 alloc_chunks;
+  U32* chunk_points;
+  U32* chunk_bytes;
+};
+
+class LASreadPointFast
+{
+public:
+  bool setup(const U32 num_items, const LASitem* items);
+  bool init(ByteStreamIn* instream);
+  bool seek(const U32 current, const U32 target);
+  bool read(U8* const * point);
+  bool done();
+
+  LASreadPointFast();
+  ~LASreadPointFast();
+
+private:
+  bool read_chunk_table();
+  bool read_chunk();
+  ByteStreamIn* instream;
+  LASpointFastLayout layout;
+  U32 points_in_chunk;
+  U32 point_in_chunk;
+  U8* records;
+  U8* columns;
+  U8* compressed;
+  U32 alloc_points;
+  U32 alloc_compressed;
+  I64 chunks_start_position;
+  U32 number_chunks;
+  U32 current_chunk;
+  I64* chunk_starts;
+  I64* chunk_firsts;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/*
+===============================================================================
+
+  FILE:  laspointraw.hpp
+
+  CONTENTS:
+
+    Converts between uncompressed LAS point records and LASpoint with one
+    routine per point format 0 to 5 that knows where each item sits in the
+    record, instead of iterating over the item list for every point. The
+    routine is picked once when the file is opened and the records are read
+    and written in blocks. Only little-endian hosts are supported because
+    the records are copied into the point fields without swapping bytes.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created to make reading uncompressed LAS bandwidth bound
+
+===============================================================================
+*/
+#ifndef LAS_POINT_RAW_HPP
+#define LAS_POINT_RAW_HPP
+
+#include "lasdefinitions.hpp"
+
+// the number of records that are read or written at once
+#define LAS_POINT_RAW_BLOCK 4096
+// after a seek the blocks start this small and double with every read
+#define LAS_POINT_RAW_BLOCK_AFTER_SEEK 32
+
+typedef void (*LASunpackRecord)(LASpoint* point, const U8* record, const U32 extra);
+typedef void (*LASpackRecord)(const LASpoint* point, U8* record, const U32 extra);
+
+class LASpointRaw
+{
+public:
+  // fails unless the point has exactly the items of a standard format 0 to 5
+  // followed by optional extra bytes and the host is little-endian
+  bool setup(const LASpoint* point, const U8 point_data_format, const U16 point_data_record_length);
+
+  inline void unpack(LASpoint* point, const U8* record) const { (*unpack_record)(point, record, extra); };
+  inline void pack(const LASpoint* point, U8* record) const { (*pack_record)(point, record, extra); };
+
+  U32 record_size;
+  U32 extra;
+
+  LASpointRaw();
+
+private:
+  LASunpackRecord unpack_record;
+  LASpackRecord pack_record;
+};
+
+#endif
@@ -26,6 +26,8 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- iterative intersection with explicit stack and range fast path
+    19 October 2026 -- bit-interleaving (Morton) fast path and batch variant for cell indices
     11 May 2011 -- moved into LASlib so that LASreader supports spatial indexing
     19 January 2011 -- created after mara met with silke to talk about africa
   
@@ -88,6 +90,7 @@ public:
   U32 get_level_index(const F64 x, const F64 y, U32 level, F32* min, F32* max) const;
   U32 get_level_index(const F64 x, const F64 y, F32* min, F32* max) const;
   U32 get_cell_index(const F64 x, const F64 y, U32 level) const;
+  void get_cell_indices(const F64* x, const F64* y, const U32 number, U32* cell_indices) const;
 
   // additional bounding box queries
   void get_cell_bounding_box(const F64 x, const F64 y, U32 level, F32* min, F32* max) const;
@@ -137,12 +140,17 @@ private:
   U32 adaptive_alloc;
   U32* adaptive;
 
-  void intersect_rectangle_with_cells(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index);
-  void intersect_rectangle_with_cells_adaptive(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index);
-  void intersect_tile_with_cells(const F32 ll_x, const F32 ll_y, const F32 ur_x, const F32 ur_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index);
-  void intersect_tile_with_cells_adaptive(const F32 ll_x, const F32 ll_y, const F32 ur_x, const F32 ur_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index);
-  void intersect_circle_with_cells(const F64 center_x, const F64 center_y, const F64 radius, const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index);
-  void intersect_circle_with_cells_adaptive(const F64 center_x, const F64 center_y, const F64 radius, const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index);
+  // exact Morton codes replace the descent when all cell boundaries are floats
+  bool morton;
+  U32 morton_levels;
+  F32 morton_min_x, morton_max_x, morton_min_y, morton_max_y;
+  F64 morton_unit_x, morton_unit_y;
+  void setup_morton();
+  inline bool use_morton(const U32 level) const { return morton && (level <= morton_levels) && (levels == morton_levels) && (min_x == morton_min_x) && (max_x == morton_max_x) && (min_y == morton_min_y) && (max_y == morton_max_y); };
+  U32 get_morton_level_index(const F64 x, const F64 y, const U32 level) const;
+
+  void intersect_with_cells(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F64* circle, U32 level);
+  bool intersect_with_ranges(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F64* circle, U32 level);
   bool intersect_circle_with_rectangle(const F64 center_x, const F64 center_y, const F64 radius, const F32 r_min_x, const F32 r_max_x, const F32 r_min_y, const F32 r_max_y);
   void raster_occupancy(bool(*does_cell_exist)(I32), U32* data, U32 min_x, U32 min_y, U32 level_index, U32 level, U32 stop_level) const;
   void* current_cells;
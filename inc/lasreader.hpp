@@ -25,6 +25,21 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- added '-pipe_on_shared' so only LASlib stages are offered shared memory
+    19 October 2026 -- LASscan composes read loops at compile time
+    19 October 2026 -- added '-preview' to read only a spread-out fraction of the LAX cells
+    19 October 2026 -- opens '.lac' columnar files with LASreaderCOL
+    19 October 2026 -- opens '.laf' files with fast compressed points as LAS
+    19 October 2026 -- get_inside_rectangle() and friends for the LAZ chunk copier
+    19 October 2026 -- has_raw_points() and read_raw_points() for record passthrough
+    19 October 2026 -- single '-buffered' tiles find their neighbors via the lastiling VLR
+    19 October 2026 -- added '-buffered_cache' to reuse neighbor points across tiles
+    19 October 2026 -- added '-merge_gps_time' to merge flightlines in time order
+    19 October 2026 -- added '-prefetch_files' and '-interleave' for merged reading
+    19 October 2026 -- added '-catalog' and '-write_catalog' for huge tile collections
+    19 October 2026 -- added '-peek_threads' to open many merged files faster
+    19 October 2026 -- added '-read_ahead' and '-read_coalesce' for indexed queries
+    19 October 2026 -- added '-auto_index' to build the LAX during the first spatial query
      7 February 2014 -- added option '-apply_file_source_ID' when reading LAS/LAZ
     22 August 2012 -- added the '-pipe_on' option for a multi-stage LAStools pipeline
     11 August 2012 -- added on-the-fly buffered reading of LiDAR files (efficient with LAX)
@@ -45,6 +60,7 @@
 #include "lasdefinitions.hpp"
 
 class LASindex;
+class LAScatalog;
 class LASfilter;
 class LAStransform;
 class ByteStreamIn;
@@ -61,8 +77,17 @@ public:
   virtual I32 get_format() const = 0;
   virtual bool has_layers() const { return FALSE; };
 
+  // raw point records can be moved in blocks when nothing changes per point
+  virtual bool has_raw_points() const { return FALSE; };
+  virtual U32 read_raw_points(U8* records, U32 number) { return 0; };
+
   void set_index(LASindex* index);
   inline LASindex* get_index() const { return index; };
+  void set_auto_index(const CHAR* file_name, const CHAR* directory=0);
+  void set_read_ahead(const U32 intervals, const U32 coalesce_bytes=0);
+  // with a LAX file only about 'point_budget' points spread evenly over the
+  // query (or the whole file) are read. must come after inside_*() (0 = off)
+  void set_preview(const U32 point_budget);
   virtual void set_filter(LASfilter* filter);
   inline LASfilter* get_filter() const { return filter; };
   virtual void set_transform(LAStransform* transform);
@@ -85,6 +110,7 @@ public:
   inline F64 get_r_max_y() const { return r_max_y; };
 
   virtual bool seek(const I64 p_index) = 0;
+  virtual bool prefetch(const I64 p_start, const I64 p_end) { return FALSE; };
   bool read_point() { return (this->*read_simple)(); };
 
   inline void compute_coordinates() { point.compute_coordinates(); };
@@ -116,6 +142,7 @@ public:
   virtual ~LASreader();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   virtual bool read_point_default() = 0;
 
   LASindex* index;
@@ -128,6 +155,10 @@ protected:
   F64 r_min_x, r_min_y, r_max_x, r_max_y;
   F64 orig_min_x, orig_min_y, orig_max_x, orig_max_y;
 
+  U32 read_ahead;
+  U32 read_coalesce;
+  U32 preview;
+
 private:
   bool (LASreader::*read_simple)();
   bool (LASreader::*read_complex)();
@@ -143,6 +174,19 @@ private:
   bool read_point_inside_circle_indexed();
   bool read_point_inside_rectangle();
   bool read_point_inside_rectangle_indexed();
+  bool read_point_preview_indexed();
+
+  // optional index that is built during the first (linear) spatial query
+  LASindex* auto_lasindex;
+  CHAR* auto_lasindex_file_name;
+  CHAR* auto_lasindex_directory;
+  U32 auto_lasindex_count;
+
+  bool prepare_auto_index();
+  void complete_auto_index();
+  bool read_point_inside_tile_auto_indexed();
+  bool read_point_inside_circle_auto_indexed();
+  bool read_point_inside_rectangle_auto_indexed();
 };
 
 #include "laswaveform13reader.hpp"
@@ -156,6 +200,8 @@ public:
   void set_file_name(const CHAR* file_name, bool unique=FALSE);
   bool add_file_name(const CHAR* file_name, bool unique=FALSE);
   bool add_list_of_files(const CHAR* list_of_files, bool unique=FALSE);
+  bool add_catalog(const CHAR* catalog_file_name, bool unique=FALSE);
+  void set_write_catalog(const CHAR* write_catalog);
   void delete_file_name(U32 file_name_id);
   bool set_file_name_current(U32 file_name_id);
   U32 get_file_name_number() const;
@@ -187,11 +233,26 @@ public:
   void set_populate_header(bool populate_header);
   void set_keep_lastiling(bool keep_lastiling);
   void set_pipe_on(bool pipe_on);
+  void set_pipe_on_shared(bool pipe_on_shared);
+  void set_read_ahead(U32 read_ahead);
+  void set_read_coalesce(U32 read_coalesce);
+  void set_preview(U32 preview);
+  void set_auto_index(bool auto_index);
+  void set_auto_index_directory(const CHAR* auto_index_directory);
+  inline const CHAR* get_auto_index_directory() const { return auto_index_directory; };
+  void set_peek_threads(U32 peek_threads);
+  void set_prefetch_files(U32 prefetch_files);
+  void set_interleave(U32 interleave);
+  void set_gps_time_merge(bool gps_time_merge, bool gps_time_check=FALSE);
+  void set_buffered_cache(U32 megabytes);
   const CHAR* get_parse_string() const;
   void usage() const;
   void set_inside_tile(const F32 ll_x, const F32 ll_y, const F32 size);
   void set_inside_circle(const F64 center_x, const F64 center_y, const F64 radius);
   void set_inside_rectangle(const F64 min_x, const F64 min_y, const F64 max_x, const F64 max_y);
+  inline const F32* get_inside_tile() const { return inside_tile; };
+  inline const F64* get_inside_circle() const { return inside_circle; };
+  inline const F64* get_inside_rectangle() const { return inside_rectangle; };
   bool parse(int argc, char* argv[]);
   bool is_piped() const;
   bool is_buffered() const;
@@ -214,6 +275,10 @@ private:
   bool add_file_name_single(const CHAR* file_name, bool unique=FALSE);
   bool add_neighbor_file_name_single(const CHAR* neighbor_file_name, bool unique=FALSE);
 #endif
+  bool schedule_buffered_tiles();
+  bool has_lastiling(const CHAR* file_name) const;
+  const CHAR* lastiling_file_name;
+  bool lastiling_found;
   I32 io_ibuffer_size;
   CHAR** file_names;
   const CHAR* file_name;
@@ -249,6 +314,23 @@ private:
   bool populate_header;
   bool keep_lastiling;
   bool pipe_on;
+  bool pipe_on_shared;
+  bool auto_index;
+  CHAR* auto_index_directory;
+  U32 read_ahead;
+  U32 read_coalesce;
+  U32 preview;
+  U32 peek_threads;
+  U32 prefetch_files;
+  U32 interleave;
+  bool gps_time_merge;
+  bool gps_time_check;
+  U32 buffered_cache;
+  U32* file_last_use;
+  U32* file_release;
+  U32 file_release_next;
+  LAScatalog* catalog;
+  CHAR* write_catalog;
   bool use_stdin;
   bool unique;
 
@@ -24,6 +24,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
     06 December 2013 -- option to deal with European '-comma_not_dot' numbers
     26 March 2012 -- created after forgetting my laptop adaptor in the pre-fab
   
@@ -56,6 +57,7 @@ public:
   virtual ~LASreaderASC();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool read_point_default();
 
 private:
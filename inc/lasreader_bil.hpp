@@ -24,6 +24,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
     3 April 2012 -- created after joining the Spar Europe 2012 Advisory Board
   
 ===============================================================================
@@ -55,6 +56,7 @@ public:
   virtual ~LASreaderBIL();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool read_point_default();
 
 private:
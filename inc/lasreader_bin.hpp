@@ -26,6 +26,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
     4 September 2011 -- created on Labor Day Sunday far from beloved mountains
   
 ===============================================================================
@@ -55,6 +56,7 @@ public:
   virtual ~LASreaderBIN();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   virtual bool open(ByteStreamIn* stream);
   bool read_point_default();
 
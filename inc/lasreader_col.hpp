@@ -0,0 +1,108 @@
+/*
+===============================================================================
+
+  FILE:  lasreader_col.hpp
+
+  CONTENTS:
+
+    Reads LIDAR points from a columnar file (LAC) written by LASwriterCOL.
+    Only the selected columns are decompressed and all other fields of the
+    points stay zero. Chunks whose minimum and maximum rule out every point
+    of a range or of an inside_tile(), inside_circle(), or inside_rectangle()
+    query are skipped without reading them. Needs a seekable file.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created for reading only the columns a tool needs
+
+===============================================================================
+*/
+#ifndef LAS_READER_COL_HPP
+#define LAS_READER_COL_HPP
+
+#include "lasreader.hpp"
+#include "laswriter_col.hpp"
+
+#include <stdio.h>
+
+class LASreaderCOL : public LASreader
+{
+public:
+
+  bool open(const char* file_name, U32 io_buffer_size=262144);
+  // opens the file again and keeps the selected columns and the ranges
+  bool reopen(const char* file_name, U32 io_buffer_size=262144);
+
+  I32 get_format() const { return LAS_TOOLS_FORMAT_LAC; };
+
+  // the columns are the point fields by their LASpoint names and the attributes by theirs
+  inline U32 get_number_columns() const { return number_columns; };
+  const CHAR* get_column_name(U32 index) const;
+  I32 get_column_index(const CHAR* name) const;
+
+  // a comma separated list such as "X,Y,Z,classification" or 0 for all columns
+  bool select_columns(const CHAR* names);
+  // skips chunks and points whose value is outside [min, max]. X, Y, and Z are
+  // given as coordinates. ranges and spatial queries always read their columns.
+  // while a spatial index drives the reading each point outside the ranges is
+  // rejected on its own so that the index moves on to its next point.
+  bool add_range(const CHAR* name, F64 min, F64 max);
+  void clear_ranges();
+
+  bool seek(const I64 p_index);
+
+  ByteStreamIn* get_stream() const;
+  void close(bool close_stream=TRUE);
+
+  LASreaderCOL();
+  virtual ~LASreaderCOL();
+
+protected:
+  template<class Source> friend struct LASscanSource;
+  bool read_point_default();
+
+private:
+  bool read_footer();
+  bool chunk_qualifies(U32 chunk) const;
+  bool load_chunk(U32 chunk);
+  bool load_column(U32 chunk, U32 c);
+  FILE* file;
+  ByteStreamIn* stream;
+  U32 number_columns;
+  LAScolumn* columns;
+  U8* selected;
+  U8* ranged;
+  F64* range_min;
+  F64* range_max;
+  I32 column_X;
+  I32 column_Y;
+  U32 number_chunks;
+  U32* chunk_points;
+  I64* chunk_firsts;
+  LAScolumnChunk* column_chunks;
+  U32 current_chunk;
+  U32 points_in_chunk;
+  U32 point_in_chunk;
+  U32 number_loaded;
+  U32* loaded;
+  U8** values;
+  U8* planes;
+  U8* compressed;
+};
+
+#endif
@@ -24,6 +24,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
     10 October 2013 -- created after returning from INTERGEO 2013 in Essen
   
 ===============================================================================
@@ -55,6 +56,7 @@ public:
   virtual ~LASreaderDTM();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool read_point_default();
 
 private:
@@ -24,6 +24,14 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
+    19 October 2026 -- unpacks uncompressed points of format 0 to 5 from blocks of records
+    19 October 2026 -- keeps the hierarchy VLRs of octree files only when asked to
+    19 October 2026 -- reads LAF files with the fast compression of LASreadPointFast
+    19 October 2026 -- hands out compressed chunks verbatim for chunk copying
+    19 October 2026 -- reads raw point records in blocks when nothing changes per point
+    19 October 2026 -- attaches to the shared memory ring of an upstream '-pipe_on'
+    19 October 2026 -- prefetch() hints upcoming point ranges to the OS via posix_fadvise()
     13 October 2014 -- changed default IO buffer size with setvbuf() to 262144
     27 August 2014 -- peek bounding box to open many file with lasreadermerged
      9 July 2012 -- fixed crash that occured when input had a corrupt VLRs
@@ -51,6 +59,9 @@ using namespace std;
 #endif
 
 class LASreadPoint;
+class LASreadPointFast;
+class LASpointRaw;
+class LASsharedpipe;
 
 class LASreaderLAS : public LASreader
 {
@@ -63,6 +74,21 @@ public:
   I32 get_format() const;
 
   bool seek(const I64 p_index);
+  bool prefetch(const I64 p_start, const I64 p_end);
+
+  bool has_raw_points() const;
+  U32 read_raw_points(U8* records, U32 number);
+
+  // the compressed chunks of a LAZ file can be copied without decompressing
+  // them. read_chunk() moves the stream so seek() before the next read_point()
+  U32 get_number_chunks();
+  inline U32 get_chunk_points(U32 chunk) const { return chunk_points[chunk]; };
+  inline U32 get_chunk_bytes(U32 chunk) const { return (U32)(chunk_starts[chunk+1] - chunk_starts[chunk]); };
+  bool read_chunk(U32 chunk, U8* bytes);
+
+  // the hierarchy VLRs of an octree file describe its point order and are taken
+  // away so they cannot end up in other files. LASreaderOctree keeps them.
+  inline void set_keep_octree(bool keep_octree) { this->keep_octree = keep_octree; };
 
   ByteStreamIn* get_stream() const;
   void close(bool close_stream=TRUE);
@@ -71,6 +97,7 @@ public:
   virtual ~LASreaderLAS();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   virtual bool open(ByteStreamIn* stream, bool peek_only=FALSE);
   virtual bool read_point_default();
 
@@ -78,14 +105,29 @@ private:
   FILE* file;
   ByteStreamIn* stream;
   LASreadPoint* reader;
+  LASreadPointFast* fastreader;
+  LASsharedpipe* sharedpipe;
+  bool read_chunk_table();
+  bool read_raw_block();
+  LASpointRaw* rawreader;
+  U8* raw_records;
+  U32 raw_number;
+  U32 raw_current;
+  U32 raw_block;
+  U32 number_chunks;
+  U32* chunk_points;
+  I64* chunk_starts;
+  bool keep_octree;
 };
 
 class LASreaderLASrescale : public virtual LASreaderLAS
 {
 public:
   LASreaderLASrescale(F64 x_scale_factor, F64 y_scale_factor, F64 z_scale_factor);
+  bool has_raw_points() const { return FALSE; };
 
 protected:
+  template<class Source> friend struct LASscanSource;
   virtual bool open(ByteStreamIn* stream, bool peek_only=FALSE);
   virtual bool read_point_default();
   bool rescale_x, rescale_y, rescale_z;
@@ -98,8 +140,10 @@ class LASreaderLASreoffset : public virtual LASreaderLAS
 public:
   LASreaderLASreoffset(F64 x_offset, F64 y_offset, F64 z_offset);
   LASreaderLASreoffset(); // auto reoffset
+  bool has_raw_points() const { return FALSE; };
 
 protected:
+  template<class Source> friend struct LASscanSource;
   virtual bool open(ByteStreamIn* stream, bool peek_only=FALSE);
   virtual bool read_point_default();
   bool auto_reoffset;
@@ -113,8 +157,10 @@ class LASreaderLASrescalereoffset : public LASreaderLASrescale, LASreaderLASreof
 public:
   LASreaderLASrescalereoffset(F64 x_scale_factor, F64 y_scale_factor, F64 z_scale_factor, F64 x_offset, F64 y_offset, F64 z_offset);
   LASreaderLASrescalereoffset(F64 x_scale_factor, F64 y_scale_factor, F64 z_scale_factor); // auto reoffset
+  bool has_raw_points() const { return FALSE; };
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool open(ByteStreamIn* stream, bool peek_only=FALSE);
   bool read_point_default();
 };
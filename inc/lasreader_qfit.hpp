@@ -26,6 +26,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
     22 December 2011 -- created after my banker keeps me hostage for 2.5 hours
   
 ===============================================================================
@@ -55,6 +56,7 @@ public:
   virtual ~LASreaderQFIT();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   virtual bool open(ByteStreamIn* stream);
   bool read_point_default();
 
@@ -24,6 +24,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
     16 December 2011 -- after Silke got Australia mad and didn't call anymore
   
 ===============================================================================
@@ -55,6 +56,7 @@ public:
   virtual ~LASreaderSHP();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool read_point_default();
 
 private:
@@ -24,6 +24,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
     9 July 2014 -- allowing input from stdin after the 7:1 in the World Cup
     8 April 2011 -- created after starting a google group for LAStools users
   
@@ -65,6 +66,7 @@ public:
   virtual ~LASreaderTXT();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool read_point_default();
 
 private:
@@ -30,6 +30,10 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
+    19 October 2026 -- neighbors found via the lastiling VLR are read concurrently
+    19 October 2026 -- rims of neighbor files can be cached across tiles
+    19 October 2026 -- buffer points are kept LAZ compressed in blocks of 10000
     17 July 2012 -- created after converting the LASzip paper from LaTeX to Word
   
 ===============================================================================
@@ -39,6 +43,14 @@
 
 #include "lasreader.hpp"
 
+class LASzip;
+class LASwritePoint;
+class LASreadPoint;
+class ByteStreamOutArray;
+class ByteStreamInArray;
+class LASreaderBufferedCached;
+class LAScatalog;
+
 class LASreaderBuffered : public LASreader
 {
 public:
@@ -56,9 +68,15 @@ public:
   bool set_file_name(const CHAR* file_name);
   bool add_neighbor_file_name(const CHAR* file_name);
   void set_buffer_size(const F32 buffer_size);
+  void set_lastiling_neighbors(const bool lastiling_neighbors, const LAScatalog* catalog=0);
 
   bool remove_buffer();
 
+  // optional process-wide cache for the buffer points of neighbor files
+  static void set_cache_budget(const I64 bytes);
+  static inline I64 get_cache_budget() { return cache_budget; };
+  static void release_cached(const CHAR* file_name);
+
   bool open();
   bool reopen();
 
@@ -80,6 +98,7 @@ public:
   ~LASreaderBuffered();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool read_point_default();
 
 private:
@@ -87,11 +106,27 @@ private:
 
   void clean_buffer();
   bool copy_point_to_buffer();
+  void done_point_buffer();
   bool copy_point_from_buffer();
   U32 get_number_buffered_points() const;
+  U32 get_buffer_bytes() const;
+  void check_point_type(const LASreader* lasreader_neighbor);
+  void add_neighbor_point();
+  void copy_neighbor_point(const LASpoint* neighbor_point);
+  bool read_neighbors_cached(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y);
+  void load_cached(LASreader* lasreader_neighbor, LASreaderBufferedCached* cached);
+  static I64 cache_budget;
+  void add_lastiling_neighbors();
+  bool read_neighbors_concurrently(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y);
 
   const U32 points_per_buffer;
   U8** buffers;
+  U32* buffer_bytes;
+  LASzip* buffer_laszip;
+  LASwritePoint* buffer_writer;
+  ByteStreamOutArray* buffer_stream_out;
+  LASreadPoint* buffer_reader;
+  ByteStreamInArray* buffer_stream_in;
   U8* current_buffer;
   U32 size_of_buffers_array;
   U32 number_of_buffers;
@@ -100,8 +135,11 @@ private:
 
   LASreadOpener lasreadopener;
   LASreadOpener lasreadopener_neighbors;
+  LASreadOpener lasreadopener_cache;
   LASreader* lasreader;
   F32 buffer_size;
+  bool lastiling_neighbors;
+  const LAScatalog* catalog;
   bool point_type_change;
   bool point_size_change;
   bool rescale;
@@ -24,6 +24,13 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
+    19 October 2026 -- optional k-way merge of the files in GPS time order
+    19 October 2026 -- next files are opened in the background or read interleaved
+    19 October 2026 -- an R-tree over the bounding boxes prunes files for spatial queries
+    19 October 2026 -- headers can come from a catalog that is checked when first used
+    19 October 2026 -- headers of merged LAS files are peeked at by several threads
+    19 October 2026 -- files without LAX are indexed during the first spatial query
     20 January 2011 -- created missing Livermore and my Extra Virgin Olive Oil
   
 ===============================================================================
@@ -40,6 +47,12 @@
 #include "lasreader_dtm.hpp"
 #include "lasreader_txt.hpp"
 
+class LAScatalog;
+class LASrtree;
+class LASreaderMergedPrefetch;
+class LASreaderMergedInterleave;
+class LASreaderMergedGPStime;
+
 class LASreaderMerged : public LASreader
 {
 public:
@@ -59,6 +72,15 @@ public:
   void set_skip_lines(I32 skip_lines);
   void set_populate_header(bool populate_header);
   void set_keep_lastiling(bool keep_lastiling);
+  void set_auto_index(bool auto_index);
+  void set_auto_index_directory(const CHAR* auto_index_directory);
+  void set_peek_threads(U32 peek_threads);
+  // opens the next files in the background (0 = off)
+  void set_prefetch_files(U32 prefetch_files);
+  void set_interleave(U32 interleave);
+  void set_gps_time_merge(bool gps_time_merge, bool gps_time_check=FALSE);
+  void set_catalog(const LAScatalog* catalog);
+  void set_write_catalog(const CHAR* write_catalog);
   bool open();
   bool reopen();
 
@@ -80,10 +102,16 @@ public:
   ~LASreaderMerged();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool read_point_default();
 
 private:
   bool open_next_file();
+  U32 find_next_file(U32 file_name) const;
+  LASreaderLAS* create_lasreaderlas() const;
+  bool open_lasreaderlas(LASreaderLAS* lasreaderlas, const U32 file_name) const;
+  void prune_files(const bool strict);
+  void check_catalog_entries();
   void clean();
 
   LASreader* lasreader;
@@ -111,12 +139,47 @@ private:
   I32 skip_lines;
   bool populate_header;
   bool keep_lastiling;
+  bool auto_index;
+  CHAR* auto_index_directory;
+  U32 peek_threads;
+  const LAScatalog* catalog;
+  CHAR* write_catalog;
   U32 file_name_current;
   U32 file_name_number;
   U32 file_name_allocated;
   I32 io_ibuffer_size;
   CHAR** file_names;
   F64* bounding_boxes;
+  LASrtree* file_rtree;
+  U32* file_hits;
+  U32 file_hit_number;
+  // files whose header came from a catalog entry that was not yet checked
+  bool* unchecked;
+
+  // optional opening of the next files in the background
+  U32 prefetch_files;
+  LASreaderMergedPrefetch* prefetches;
+  static void prefetch_file(void* data);
+  void start_prefetch();
+  LASreaderLAS* take_prefetch(const U32 file_name);
+  void stop_prefetch();
+
+  // optional unordered reading of several files at once
+  U32 interleave;
+  LASreaderMergedInterleave* interleaving;
+  static void interleave_files(void* data);
+  bool start_interleaving();
+  bool read_point_interleaved();
+  void stop_interleaving();
+
+  // optional merging of (flightline) files in the order of their GPS time
+  // (at most LAS_MERGED_GPS_TIME_MAX_FILES that overlap the query)
+  bool gps_time_merge;
+  bool gps_time_check;
+  LASreaderMergedGPStime* gps_time_merging;
+  bool start_gps_time_merge();
+  bool read_point_gps_time_merged();
+  void stop_gps_time_merge();
 };
 
 #endif
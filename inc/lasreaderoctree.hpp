@@ -0,0 +1,94 @@
+/*
+===============================================================================
+
+  FILE:  lasreaderoctree.hpp
+
+  CONTENTS:
+
+    Reads the points of a file written by LASoctree coarse to fine. Only the
+    nodes down to a maximal level are read and, with a point budget, only as
+    many complete levels as fit into the budget. With inside_tile(), inside_
+    circle(), or inside_rectangle() only the nodes that intersect the query
+    are read. The selected nodes are adjacent in the file for the most part
+    so that a view needs only a few seeks. The selection is made when the
+    first point is read and 'npoints' then counts the selected points.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created for level-of-detail reads from a single file
+
+===============================================================================
+*/
+#ifndef LAS_READER_OCTREE_HPP
+#define LAS_READER_OCTREE_HPP
+
+#include "lasreader.hpp"
+#include "lasoctree.hpp"
+
+class LASreaderLAS;
+
+class LASreaderOctree : public LASreader
+{
+public:
+
+  bool open(const char* file_name, I32 io_buffer_size=262144);
+
+  I32 get_format() const;
+
+  inline const LASoctree* get_octree() const { return &octree; };
+
+  // -1 reads all levels and a budget of 0 reads all points
+  void set_max_level(const I32 max_level);
+  void set_point_budget(const I64 point_budget);
+  // the level of the node that the last point came from
+  inline I32 get_level() const { return level; };
+
+  bool inside_none();
+  bool inside_tile(const F32 ll_x, const F32 ll_y, const F32 size);
+  bool inside_circle(const F64 center_x, const F64 center_y, const F64 radius);
+  bool inside_rectangle(const F64 min_x, const F64 min_y, const F64 max_x, const F64 max_y);
+
+  // the index of a point counts only the selected points
+  bool seek(const I64 p_index);
+
+  ByteStreamIn* get_stream() const;
+  void close(bool close_stream=TRUE);
+
+  LASreaderOctree();
+  ~LASreaderOctree();
+
+protected:
+  template<class Source> friend struct LASscanSource;
+  bool read_point_default();
+
+private:
+  bool select_nodes();
+  LASreaderLAS* lasreaderlas;
+  LASoctree octree;
+  I32 max_level;
+  I64 point_budget;
+  I32 level;
+  bool selected;
+  U32 number_selected;
+  U32* selected_nodes;
+  U32 current_node;
+  U32 point_in_node;
+  I64 next_point;
+};
+
+#endif
@@ -25,6 +25,9 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- LASscan reads points without the virtual call
+    19 October 2026 -- the shared memory ring is only offered with set_shared_pipe()
+    19 October 2026 -- points go through a shared memory ring when stdout is a FIFO
     21 August 2012 -- created after swimming in the Main river 3 days in a row
   
 ===============================================================================
@@ -35,10 +38,15 @@
 #include "lasreader.hpp"
 #include "laswriter.hpp"
 
+class LASsharedpipe;
+
 class LASreaderPipeOn : public LASreader
 {
 public:
 
+  // offer a shared memory ring to a next stage that reads stdout as a FIFO.
+  // must come before open() which then waits briefly for it to attach
+  void set_shared_pipe(bool shared_pipe) { this->shared_pipe = shared_pipe; };
   bool open(LASreader* lasreader);
   LASreader* get_lasreader() const { return lasreader; };
 
@@ -62,11 +70,14 @@ public:
   ~LASreaderPipeOn();
 
 protected:
+  template<class Source> friend struct LASscanSource;
   bool read_point_default();
 
 private:
   LASreader* lasreader;
   LASwriter* laswriter;
+  LASsharedpipe* sharedpipe;
+  bool shared_pipe;
 };
 
 #endif
@@ -0,0 +1,70 @@
+/*
+===============================================================================
+
+  FILE:  lasrtree.hpp
+  
+  CONTENTS:
+  
+    A static R-tree that is bulk-loaded with the Sort-Tile-Recursive (STR)
+    packing from the bounding boxes of many files (or anything else with a
+    bounding box) and then finds all boxes intersecting a query rectangle
+    without testing every single one of them.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  
+  CHANGE HISTORY:
+  
+    19 October 2026 -- created for spatial queries on huge merged collections
+  
+===============================================================================
+*/
+#ifndef LAS_RTREE_HPP
+#define LAS_RTREE_HPP
+
+#include "mydefs.hpp"
+
+class LASrtree
+{
+public:
+  // the boxes are given as min_x, min_y, max_x, max_y. empty ones are ignored
+  bool build(const U32 number, const F64* bounding_boxes, const U32 node_size=16);
+
+  // finds the boxes that intersect the rectangle and reports them in ascending
+  // order. with strict the minimum of a box must be strictly below the maximum
+  // of the rectangle (like for a tile or a circle) otherwise it may touch it.
+  U32 intersect_rectangle(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const bool strict=FALSE);
+  inline U32 get_number_hits() const { return number_hits; };
+  inline const U32* get_hits() const { return hits; };
+
+  LASrtree();
+  ~LASrtree();
+
+private:
+  void clean();
+  U32 number_items;
+  U32* items;
+  F64* item_boxes;
+  U32 number_nodes;
+  U32 number_leaves;
+  F64* node_boxes;
+  U32* node_first;
+  U32* node_count;
+  U32* stack;
+  U32 number_hits;
+  U32* hits;
+};
+
+#endif
@@ -0,0 +1,245 @@
+/*
+===============================================================================
+
+  FILE:  lasscan.hpp
+
+  CONTENTS:
+
+    Reads the points of a LASreader in one loop that the compiler composes
+    from four parts that are template parameters instead of going through
+    the member function pointers of read_point() and the virtual function
+    read_point_default() for every point:
+
+      Source     the concrete reader class, for example LASreaderLAS, whose
+                 read_point_default() is called directly. with LASreader it
+                 is called through the virtual function as before.
+      Filter     LASscanNoFilter, a concrete test such as LASscanKeepClass-
+                 ifications, or LASscanFilter that runs a LASfilter
+      Transform  LASscanNoTransform or LASscanTransform for a LAStransform
+      Region     LASscanEverywhere, LASscanRectangle, LASscanTile, or
+                 LASscanCircle
+
+    A region that is constructed from the reader uses the query of its last
+    inside_tile(), inside_circle(), or inside_rectangle() and then also its
+    LAX file. The filter, transform, and query that were set on the reader
+    itself are otherwise ignored. LASreader::read_point() is unchanged and
+    is what to use for all other combinations.
+
+      LASreaderLAS* lasreaderlas = ...;
+      LASscan<LASreaderLAS, LASscanNoFilter, LASscanNoTransform, LASscanRectangle>
+        scan(lasreaderlas, LASscanNoFilter(), LASscanNoTransform(), LASscanRectangle(lasreaderlas));
+      while (scan.read_point()) { ... lasreaderlas->point ... }
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created to take the indirect calls out of tight read loops
+
+===============================================================================
+*/
+#ifndef LAS_SCAN_HPP
+#define LAS_SCAN_HPP
+
+#include "lasreader.hpp"
+#include "lasindex.hpp"
+#include "lasfilter.hpp"
+#include "lastransform.hpp"
+
+#include <typeinfo>
+
+// calls read_point_default() of exactly this class without the virtual call
+
+template<class Source> struct LASscanSource
+{
+  static inline bool read(Source* source) { return source->Source::read_point_default(); };
+};
+
+template<> struct LASscanSource<LASreader>
+{
+  static inline bool read(LASreader* reader) { return reader->read_point_default(); };
+};
+
+// filters return TRUE for points that are dropped (like LASfilter)
+
+class LASscanNoFilter
+{
+public:
+  inline bool filter(const LASpoint* point) const { return FALSE; };
+};
+
+class LASscanFilter
+{
+public:
+  inline bool filter(const LASpoint* point) const { return lasfilter->filter(point); };
+  LASscanFilter(LASfilter* lasfilter) { this->lasfilter = lasfilter; };
+private:
+  LASfilter* lasfilter;
+};
+
+class LASscanKeepClassifications
+{
+public:
+  inline bool filter(const LASpoint* point) const { return ((1u << point->classification) & classifications) == 0; };
+  // bit i of the mask keeps classification i
+  LASscanKeepClassifications(U32 classifications) { this->classifications = classifications; };
+private:
+  U32 classifications;
+};
+
+class LASscanDropWithheld
+{
+public:
+  inline bool filter(const LASpoint* point) const { return point->withheld_flag != 0; };
+};
+
+class LASscanNoTransform
+{
+public:
+  inline void transform(LASpoint* point) const { };
+};
+
+class LASscanTransform
+{
+public:
+  inline void transform(LASpoint* point) const { lastransform->transform(point); };
+  LASscanTransform(const LAStransform* lastransform) { this->lastransform = lastransform; };
+private:
+  const LAStransform* lastransform;
+};
+
+// regions that are 'indexed' may use the LAX file of the reader
+
+class LASscanEverywhere
+{
+public:
+  inline bool inside(const LASpoint* point) const { return TRUE; };
+  inline bool indexed() const { return FALSE; };
+};
+
+class LASscanRectangle
+{
+public:
+  inline bool inside(const LASpoint* point) const { return point->inside_rectangle(min_x, min_y, max_x, max_y); };
+  inline bool indexed() const { return from_reader; };
+  LASscanRectangle(const F64 min_x, const F64 min_y, const F64 max_x, const F64 max_y)
+  {
+    this->min_x = min_x; this->min_y = min_y; this->max_x = max_x; this->max_y = max_y;
+    from_reader = FALSE;
+  };
+  LASscanRectangle(const LASreader* reader)
+  {
+    min_x = reader->get_r_min_x(); min_y = reader->get_r_min_y(); max_x = reader->get_r_max_x(); max_y = reader->get_r_max_y();
+    from_reader = (reader->get_inside() == 3);
+  };
+private:
+  F64 min_x, min_y, max_x, max_y;
+  bool from_reader;
+};
+
+class LASscanTile
+{
+public:
+  inline bool inside(const LASpoint* point) const { return point->inside_tile(ll_x, ll_y, ur_x, ur_y); };
+  inline bool indexed() const { return from_reader; };
+  LASscanTile(const F32 ll_x, const F32 ll_y, const F32 size)
+  {
+    this->ll_x = ll_x; this->ll_y = ll_y; ur_x = ll_x + size; ur_y = ll_y + size;
+    from_reader = FALSE;
+  };
+  LASscanTile(const LASreader* reader)
+  {
+    ll_x = reader->get_t_ll_x(); ll_y = reader->get_t_ll_y(); ur_x = ll_x + reader->get_t_size(); ur_y = ll_y + reader->get_t_size();
+    from_reader = (reader->get_inside() == 1);
+  };
+private:
+  F32 ll_x, ll_y, ur_x, ur_y;
+  bool from_reader;
+};
+
+class LASscanCircle
+{
+public:
+  inline bool inside(const LASpoint* point) const { return point->inside_circle(center_x, center_y, radius_squared); };
+  inline bool indexed() const { return from_reader; };
+  LASscanCircle(const F64 center_x, const F64 center_y, const F64 radius)
+  {
+    this->center_x = center_x; this->center_y = center_y; radius_squared = radius*radius;
+    from_reader = FALSE;
+  };
+  LASscanCircle(const LASreader* reader)
+  {
+    center_x = reader->get_c_center_x(); center_y = reader->get_c_center_y(); radius_squared = reader->get_c_radius()*reader->get_c_radius();
+    from_reader = (reader->get_inside() == 2);
+  };
+private:
+  F64 center_x, center_y, radius_squared;
+  bool from_reader;
+};
+
+template<class Source, class Filter, class Transform, class Region>
+class LASscan
+{
+public:
+  inline bool read_point()
+  {
+    while (next_point())
+    {
+      if (!region.inside(&(source->point))) continue;
+      if (filter.filter(&(source->point))) continue;
+      transform.transform(&(source->point));
+      return TRUE;
+    }
+    return FALSE;
+  };
+
+  inline LASpoint* get_point() const { return &(source->point); };
+
+  LASscan(Source* source, const Filter& filter=Filter(), const Transform& transform=Transform(), const Region& region=Region()) : filter(filter), transform(transform), region(region)
+  {
+    this->source = source;
+    // a subclass such as LASreaderLASrescale has its own read_point_default()
+    exact = (typeid(*source) == typeid(Source));
+    index = (region.indexed() ? source->get_index() : 0);
+  };
+
+private:
+  inline bool next_point()
+  {
+    if (index)
+    {
+      while (index->seek_next((LASreader*)source))
+      {
+        if (read_point_default()) return TRUE;
+      }
+      return FALSE;
+    }
+    return read_point_default();
+  };
+  inline bool read_point_default()
+  {
+    if (exact) return LASscanSource<Source>::read(source);
+    return LASscanSource<LASreader>::read(source);
+  };
+  Source* source;
+  Filter filter;
+  Transform transform;
+  Region region;
+  LASindex* index;
+  bool exact;
+};
+
+#endif
@@ -0,0 +1,80 @@
+/*
+===============================================================================
+
+  FILE:  lassharedpipe.hpp
+  
+  CONTENTS:
+  
+    A ring of raw point blocks in POSIX shared memory that replaces the LAS
+    stream on stdout/stdin between two LASlib stages of a '-pipe_on_shared'
+    chain. The writing stage offers the ring in a VLR of the piped LAS header
+    and the reading stage attaches to it. Without a taker the points are
+    piped as usual.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  
+  CHANGE HISTORY:
+  
+    19 October 2026 -- created to run multi-stage pipelines at memory speed
+  
+===============================================================================
+*/
+#ifndef LAS_SHARED_PIPE_HPP
+#define LAS_SHARED_PIPE_HPP
+
+#include "mydefs.hpp"
+
+#include <stdio.h>
+
+class LASpoint;
+class LASsharedpipeControl;
+
+// the VLR of the piped header that names the ring
+#define LAS_SHARED_PIPE_USER_ID "LASlib"
+#define LAS_SHARED_PIPE_RECORD_ID 39
+
+class LASsharedpipe
+{
+public:
+  // writing stage
+  static bool is_pipe(FILE* file);
+  bool create(const U32 point_size, const U32 points_per_slot=8192, const U32 number_slots=16);
+  inline const CHAR* get_name() const { return name; };
+  bool wait_attached(const U32 milliseconds);
+  bool write_point(const LASpoint* point);
+  bool done();
+
+  // reading stage
+  bool attach(const CHAR* name, const U32 point_size);
+  bool read_point(LASpoint* point);
+
+  LASsharedpipe();
+  ~LASsharedpipe();
+
+private:
+  void wait(volatile U32* address, const U32 value);
+  void wake(volatile U32* address);
+  CHAR name[64];
+  LASsharedpipeControl* control;
+  U8* slots;
+  I64 size;
+  bool creator;
+  U32 count;
+  U32 number;
+  U8* current;
+};
+
+#endif
@@ -54,6 +54,7 @@ public:
   // map points to cells
   virtual bool inside(const F64 x, const F64 y) const = 0;
   virtual U32 get_cell_index(const F64 x, const F64 y) const = 0;
+  virtual void get_cell_indices(const F64* x, const F64* y, const U32 number, U32* cell_indices) const { for (U32 i = 0; i < number; i++) cell_indices[i] = get_cell_index(x[i], y[i]); };
 
   // map cells to coarser cells
   virtual bool coarsen(const I32 cell_index, I32* coarser_cell_index, U32* num_cell_indices, I32** cell_indices) const = 0;
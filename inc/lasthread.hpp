@@ -0,0 +1,82 @@
+/*
+===============================================================================
+
+  FILE:  lasthread.hpp
+  
+  CONTENTS:
+  
+    A minimal portable wrapper around native threads (Win32 or pthreads) and
+    mutexes so that LASlib can overlap slow I/O with other work.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  
+  CHANGE HISTORY:
+  
+    19 October 2026 -- added condition variables for handing over blocks of points
+    19 October 2026 -- created for peeking into many merged files at once
+  
+===============================================================================
+*/
+#ifndef LAS_THREAD_HPP
+#define LAS_THREAD_HPP
+
+#include "mydefs.hpp"
+
+class LASthread
+{
+public:
+  bool start(void (*function)(void*), void* data);
+  bool join();
+  inline bool is_running() const { return (handle != 0); };
+  LASthread();
+  ~LASthread();
+private:
+  void* handle;
+  void (*function)(void*);
+  void* data;
+#ifdef _WIN32
+  static unsigned long __stdcall run(void* thread);
+#else
+  static void* run(void* thread);
+#endif
+};
+
+class LASmutex
+{
+public:
+  void lock();
+  void unlock();
+  LASmutex();
+  ~LASmutex();
+private:
+  friend class LAScondition;
+  void* handle;
+};
+
+class LAScondition
+{
+public:
+  // the mutex must be locked by the caller and is locked again on return
+  void wait(LASmutex* mutex);
+  void signal();
+  void broadcast();
+  LAScondition();
+  ~LAScondition();
+private:
+  void* handle;
+};
+
+#endif
@@ -24,6 +24,9 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- inventory taken from the header of a file copied verbatim
+    19 October 2026 -- inventory of raw point records in one tight scan
+    19 October 2026 -- inventories of several threads can be merged
     25 December 2010 -- created after swinging in Mara's hammock for hours
   
 ===============================================================================
@@ -46,6 +49,9 @@ public:
   I32 max_Z;
   I32 min_Z;
   bool add(const LASpoint* point);
+  bool add(const LASinventory* inventory);
+  bool add(const U8* records, U32 number, U16 record_length);
+  bool add(const LASheader* header);
   LASinventory();
 private:
   bool first;
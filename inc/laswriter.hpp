@@ -25,6 +25,10 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- '-olac' writes columnar files with LASwriterCOL
+    19 October 2026 -- '-olaf' writes LAS files with fast compressed points
+    19 October 2026 -- copy_raw_points() moves unchanged point records in blocks
+    19 October 2026 -- output files can be written by an I/O thread ('-async_obuffers 4')
     5 September 2011 -- support for writing Terrasolid's BIN format
     11 June 2011 -- billion point support: p_count & npoints are 64 bit counters
     8 May 2011 -- added an option for variable chunking via chunk()
@@ -44,6 +48,8 @@
 
 #include "lasutility.hpp"
 
+class LASreader;
+
 class LASwriter
 {
 public:
@@ -59,6 +65,15 @@ public:
   virtual bool update_header(const LASheader* header, bool use_inventory=FALSE, bool update_extra_bytes=FALSE) = 0;
   virtual I64 close(bool update_npoints=TRUE) = 0;
 
+  // raw point records can be moved in blocks when nothing changes per point.
+  // this is API only: apart from LASpipeline with a lone writer no read/write
+  // loop calls it, so a tool that copies points unchanged must call it itself
+  // before falling back to its read_point() / write_point() loop.
+  virtual bool takes_raw_points(U8 point_data_format, U16 point_data_record_length) const { return FALSE; };
+  virtual bool write_raw_points(const U8* records, U32 number) { return FALSE; };
+  // returns the number of copied points or -1 when the records do not match
+  I64 copy_raw_points(LASreader* lasreader, bool update_inventory=TRUE);
+
   LASwriter() { npoints = 0; p_count = 0; };
   virtual ~LASwriter() {};
 };
@@ -70,6 +85,8 @@ class LASwriteOpener
 public:
   void set_io_obuffer_size(I32 io_obuffer_size);
   inline I32 get_io_obuffer_size() const { return io_obuffer_size; };
+  void set_async_obuffers(U32 async_obuffers);
+  inline U32 get_async_obuffers() const { return async_obuffers; };
   void set_directory(const CHAR* directory);
   void set_file_name(const CHAR* file_name);
   void set_appendix(const CHAR* appendix);
@@ -104,6 +121,7 @@ private:
   void add_appendix(const CHAR* appendix=0);
   void cut_characters(U32 cut=0);
   I32 io_obuffer_size;
+  U32 async_obuffers;
   CHAR* directory;
   CHAR* file_name;
   CHAR* appendix;
@@ -24,6 +24,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- optionally hands full output blocks to a separate I/O thread
     13 October 2014 -- changed default IO buffer size with setvbuf() to 262144
     5 November 2011 -- changed default IO buffer size with setvbuf() to 65536
     5 September 2011 -- created after sampling grapes in the sommerhausen hills  
@@ -38,6 +39,7 @@
 #include <stdio.h>
 
 class ByteStreamOut;
+class ByteStreamOutFileAsync;
 
 class LASwriterBIN : public LASwriter
 {
@@ -45,6 +47,9 @@ public:
 
   bool refile(FILE* file);
 
+  // full blocks are written by a separate I/O thread (0 = off)
+  void set_async_buffers(U32 async_buffers) { this->async_buffers = async_buffers; };
+
   bool open(const char* file_name, const LASheader* header, const char* version, U32 io_buffer_size=262144);
   bool open(FILE* file, const LASheader* header, const char* version);
   bool open(ByteStreamOut* stream, const LASheader* header, const char* version);
@@ -60,6 +65,8 @@ public:
 
 private:
   ByteStreamOut* stream;
+  ByteStreamOutFileAsync* async_stream;
+  U32 async_buffers;
   FILE* file;
   U32 version;
   I32 units;
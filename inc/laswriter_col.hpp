@@ -0,0 +1,152 @@
+/*
+===============================================================================
+
+  FILE:  laswriter_col.hpp
+
+  CONTENTS:
+
+    Writes LIDAR points into a columnar file (LAC). Every field of the points
+    and every attribute in the extra bytes is stored in a column of its own.
+    The columns are cut into chunks that are compressed separately and carry
+    the minimum and the maximum of their values. A footer at the end of the
+    file lists the columns, the chunks, and their statistics and holds the
+    LAS header with all VLRs. Readers load only the columns they need and
+    skip chunks whose statistics rule out any point they are looking for.
+
+    The columns are stored in the byte order of the host, so only little-
+    endian machines are supported.
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    19 October 2026 -- created for reading only the columns a tool needs
+
+===============================================================================
+*/
+#ifndef LAS_WRITER_COL_HPP
+#define LAS_WRITER_COL_HPP
+
+#include "laswriter.hpp"
+
+#include <stdio.h>
+
+#include <sstream>
+using namespace std;
+
+#define LAS_COLUMN_MAGIC "LASC"
+#define LAS_COLUMN_VERSION 1
+
+// the type of columns without statistics. all others use LAS_ATTRIBUTE_U8 ... LAS_ATTRIBUTE_F64
+#define LAS_COLUMN_BYTES 255
+
+// the point fields that the columns are filled from
+#define LAS_COLUMN_X                    0
+#define LAS_COLUMN_Y                    1
+#define LAS_COLUMN_Z                    2
+#define LAS_COLUMN_INTENSITY            3
+#define LAS_COLUMN_RETURN_NUMBER        4
+#define LAS_COLUMN_NUMBER_OF_RETURNS    5
+#define LAS_COLUMN_SCAN_DIRECTION_FLAG  6
+#define LAS_COLUMN_EDGE_OF_FLIGHT_LINE  7
+#define LAS_COLUMN_CLASSIFICATION       8
+#define LAS_COLUMN_SYNTHETIC_FLAG       9
+#define LAS_COLUMN_KEYPOINT_FLAG       10
+#define LAS_COLUMN_WITHHELD_FLAG       11
+#define LAS_COLUMN_SCAN_ANGLE_RANK     12
+#define LAS_COLUMN_USER_DATA           13
+#define LAS_COLUMN_POINT_SOURCE_ID     14
+#define LAS_COLUMN_GPS_TIME            15
+#define LAS_COLUMN_RED                 16
+#define LAS_COLUMN_GREEN               17
+#define LAS_COLUMN_BLUE                18
+#define LAS_COLUMN_NIR                 19
+#define LAS_COLUMN_WAVEPACKET          20
+#define LAS_COLUMN_ATTRIBUTE           21
+
+class LAScolumn
+{
+public:
+  // stored in the footer
+  CHAR name[32];
+  U8 type;
+  U8 delta;
+  U16 width;
+  // derived from the name and the attributes in the header
+  U32 field;
+  I32 start;
+
+  bool set_field(const LASattributer* attributer);
+  F64 get_value(const U8* value) const;
+  void get(const LASpoint* point, U8* value) const;
+  void set(LASpoint* point, const U8* value) const;
+};
+
+class LAScolumnChunk
+{
+public:
+  I64 offset;
+  U32 bytes;
+  F64 min;
+  F64 max;
+};
+
+class ByteStreamOut;
+class LASwriterLAS;
+
+class LASwriterCOL : public LASwriter
+{
+public:
+
+  bool open(const char* file_name, const LASheader* header, U32 chunk_size=50000, U32 io_buffer_size=262144);
+  bool open(FILE* file, const LASheader* header, U32 chunk_size=50000);
+  bool open(ByteStreamOut* stream, const LASheader* header, U32 chunk_size=50000);
+
+  bool write_point(const LASpoint* point);
+  bool chunk();
+
+  bool update_header(const LASheader* header, bool use_inventory=FALSE, bool update_extra_bytes=FALSE);
+  I64 close(bool update_npoints=TRUE);
+
+  LASwriterCOL();
+  ~LASwriterCOL();
+
+private:
+  bool add_column(const CHAR* name, U8 type, U16 width, bool delta, const LASattributer* attributer);
+  bool write_chunk();
+  bool write_footer();
+  ByteStreamOut* stream;
+  FILE* file;
+  // counted here as tell() does not work when writing to a pipe
+  I64 bytes_written;
+  // the LAS header with its VLRs is written into memory and copied into the footer
+  LASwriterLAS* headerwriter;
+  ostringstream* headerstream;
+  U32 chunk_size;
+  U32 points_in_chunk;
+  U32 number_columns;
+  LAScolumn* columns;
+  U8** values;
+  U8* planes;
+  U8* compressed;
+  U32* hash_table;
+  U32 number_chunks;
+  U32 alloc_chunks;
+  U32* chunk_points;
+  LAScolumnChunk* column_chunks;
+};
+
+#endif
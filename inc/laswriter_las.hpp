@@ -24,6 +24,13 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- set_variable_chunking() ends LAZ chunks only at chunk()
+    19 October 2026 -- writes LAF files with the fast compression of LASwritePointFast
+    19 October 2026 -- appends compressed chunks verbatim with set_chunk_copy()
+    19 October 2026 -- packs uncompressed points of format 0 to 5 into blocks of records
+    19 October 2026 -- takes raw point records in blocks when nothing changes per point
+    19 October 2026 -- map_points() lets many threads write uncompressed points
+    19 October 2026 -- optionally hands full output blocks to a separate I/O thread
     13 October 2014 -- changed default IO buffer size with setvbuf() to 262144
     5 November 2011 -- changed default IO buffer size with setvbuf() to 65536
     8 May 2011 -- added an option for variable chunking via chunk()
@@ -51,7 +58,10 @@ using namespace std;
 #endif
 
 class ByteStreamOut;
+class ByteStreamOutFileAsync;
 class LASwritePoint;
+class LASwritePointFast;
+class LASpointRaw;
 
 class LASwriterLAS : public LASwriter
 {
@@ -59,6 +69,9 @@ public:
 
   bool refile(FILE* file);
 
+  // full blocks are written by a separate I/O thread (0 = off)
+  void set_async_buffers(U32 async_buffers) { this->async_buffers = async_buffers; };
+
   bool open(const LASheader* header, U32 compressor=LASZIP_COMPRESSOR_NONE, I32 requested_version=0, I32 chunk_size=50000);
   bool open(const char* file_name, const LASheader* header, U32 compressor=LASZIP_COMPRESSOR_NONE, I32 requested_version=0, I32 chunk_size=50000, I32 io_buffer_size=262144);
   bool open(FILE* file, const LASheader* header, U32 compressor=LASZIP_COMPRESSOR_NONE, I32 requested_version=0, I32 chunk_size=50000);
@@ -67,6 +80,33 @@ public:
   bool write_point(const LASpoint* point);
   bool chunk();
 
+  // uncompressed files with a known number of points can be written by many
+  // threads at once. map_points() must come right after open() and reserves
+  // and memory-maps all point records. each thread then fills its own range
+  // of records with write_point_at() and keeps its own LASinventory that it
+  // merges into 'inventory' when done. close() (or unmap_points()) ends it.
+  bool map_points(I64 npoints);
+  bool write_point_at(I64 index, const LASpoint* point);
+  bool unmap_points();
+
+  bool takes_raw_points(U8 point_data_format, U16 point_data_record_length) const;
+  bool write_raw_points(const U8* records, U32 number);
+
+  // compressed chunks of LAZ files with the same point layout are appended
+  // verbatim. set_chunk_copy() must come before open() and makes the chunks
+  // variable in size. close() then writes the chunk table. points cannot be
+  // written with write_point() in this mode.
+  void set_chunk_copy(bool chunk_copy) { this->chunk_copy = chunk_copy; };
+  bool write_chunk(const U8* bytes, U32 number_bytes, U32 number_points);
+
+  // points are compressed with the light-weight LASwritePointFast instead of
+  // LASzip. set_fast_compression() must come before open() with compressor
+  // LASZIP_COMPRESSOR_NONE. the chunk size of open() is used for its chunks.
+  void set_fast_compression(bool fast_compression) { this->fast_compression = fast_compression; };
+
+  // chunks of LAZ files end only when chunk() is called. must come before open()
+  void set_variable_chunking(bool variable_chunking) { this->variable_chunking = variable_chunking; };
+
   bool update_header(const LASheader* header, bool use_inventory=FALSE, bool update_extra_bytes=FALSE);
   I64 close(bool update_npoints=TRUE);
 
@@ -76,10 +116,35 @@ public:
 private:
   bool open(ByteStreamOut* stream, const LASheader* header, U32 compressor, I32 requested_version, I32 chunk_size);
   ByteStreamOut* stream;
+  ByteStreamOutFileAsync* async_stream;
+  U32 async_buffers;
   LASwritePoint* writer;
+  LASwritePointFast* fastwriter;
+  bool fast_compression;
+  bool flush_raw_points();
+  LASpointRaw* rawwriter;
+  U8* raw_records;
+  U32 raw_number;
   FILE* file;
   I64 header_start_position;
   bool writing_las_1_4;
+  bool points_mappable;
+  U8 point_format;
+  U16 point_record_length;
+  U8* mapped;
+  I64 mapped_start;
+  I64 mapped_size;
+  U8* mapped_points;
+  I64 mapped_npoints;
+  void* mapped_handle;
+  bool write_chunk_table();
+  bool chunk_copy;
+  bool variable_chunking;
+  I64 chunk_table_start_position;
+  U32 number_chunks;
+  U32 alloc_chunks;
+  U32* chunk_points;
+  U32* chunk_bytes;
 };
 
 #endif
@@ -24,6 +24,7 @@
   
   CHANGE HISTORY:
   
+    19 October 2026 -- optionally hands full output blocks to a separate I/O thread
     23 December 2011 -- created after by new OGIO laptop bagpack arrived 
   
 ===============================================================================
@@ -36,6 +37,7 @@
 #include <stdio.h>
 
 class ByteStreamOut;
+class ByteStreamOutFileAsync;
 
 class LASwriterQFIT : public LASwriter
 {
@@ -43,6 +45,9 @@ public:
 
   bool refile(FILE* file);
 
+  // full blocks are written by a separate I/O thread (0 = off)
+  void set_async_buffers(U32 async_buffers) { this->async_buffers = async_buffers; };
+
   bool open(const char* file_name, const LASheader* header, I32 version=48, U32 io_buffer_size=65536);
   bool open(FILE* file, const LASheader* header, I32 version=48);
   bool open(ByteStreamOut* stream, const LASheader* header, I32 version=48);
@@ -58,6 +63,8 @@ public:
 
 private:
   ByteStreamOut* stream;
+  ByteStreamOutFileAsync* async_stream;
+  U32 async_buffers;
   FILE* file;
   I32 version;
   bool endian_swap;
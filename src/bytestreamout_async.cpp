@@ -0,0 +1,305 @@
+/*
+===============================================================================
+
+  FILE:  bytestreamout_async.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the COPYING file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "bytestreamout_async.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined _WIN32 && !defined __MINGW32__
+#define LAS_ASYNC_FSEEK(file, offset, whence) _fseeki64(file, offset, whence)
+#define LAS_ASYNC_FTELL(file) _ftelli64(file)
+#else
+#define LAS_ASYNC_FSEEK(file, offset, whence) fseeko(file, (off_t)offset, whence)
+#define LAS_ASYNC_FTELL(file) ((I64)ftello(file))
+#endif
+
+ByteStreamOutFileAsync::ByteStreamOutFileAsync(FILE* file, U32 buffer_size, U32 number_buffers)
+{
+  this->file = file;
+  this->buffer_size = (buffer_size < 4096 ? 4096 : buffer_size);
+  this->number_buffers = (number_buffers < 2 ? 2 : number_buffers);
+  buffers = new U8*[this->number_buffers];
+  sizes = new U32[this->number_buffers];
+  for (U32 i = 0; i < this->number_buffers; i++)
+  {
+    buffers[i] = (U8*)malloc(this->buffer_size);
+    sizes[i] = 0;
+  }
+  head = 0;
+  count = 0;
+  current = 0;
+  position = LAS_ASYNC_FTELL(file);
+  if (position < 0) position = 0;
+  failed = FALSE;
+  stop = FALSE;
+  // without the I/O thread full blocks are written by the caller
+  thread.start(write_buffers, this);
+}
+
+ByteStreamOutFileAsync::~ByteStreamOutFileAsync()
+{
+  flush();
+  mutex.lock();
+  stop = TRUE;
+  filled.signal();
+  mutex.unlock();
+  thread.join();
+  for (U32 i = 0; i < number_buffers; i++) free(buffers[i]);
+  delete [] buffers;
+  delete [] sizes;
+}
+
+// the I/O thread writes the queued blocks in order
+
+void ByteStreamOutFileAsync::write_buffers(void* data)
+{
+  ByteStreamOutFileAsync* stream = (ByteStreamOutFileAsync*)data;
+  U32 index;
+  bool ok;
+  while (TRUE)
+  {
+    stream->mutex.lock();
+    while ((stream->count == 0) && !stream->stop) stream->filled.wait(&stream->mutex);
+    if (stream->count == 0)
+    {
+      stream->mutex.unlock();
+      break;
+    }
+    index = stream->head;
+    stream->mutex.unlock();
+    ok = (fwrite(stream->buffers[index], 1, stream->sizes[index], stream->file) == stream->sizes[index]);
+    stream->mutex.lock();
+    if (!ok) stream->failed = TRUE;
+    stream->sizes[index] = 0;
+    stream->head = (index + 1) % stream->number_buffers;
+    stream->count--;
+    stream->emptied.signal();
+    stream->mutex.unlock();
+  }
+}
+
+bool ByteStreamOutFileAsync::queue_current()
+{
+  U32 size = sizes[current];
+  if (size == 0) return !failed;
+  if (!thread.is_running())
+  {
+    if (fwrite(buffers[current], 1, size, file) != size) failed = TRUE;
+    sizes[current] = 0;
+    position += size;
+    return !failed;
+  }
+  mutex.lock();
+  // the block being written counts as well so that it is never refilled
+  while (count == (number_buffers - 1)) emptied.wait(&mutex);
+  count++;
+  current = (head + count) % number_buffers;
+  filled.signal();
+  bool ok = !failed;
+  mutex.unlock();
+  position += size;
+  return ok;
+}
+
+bool ByteStreamOutFileAsync::refile(FILE* file)
+{
+  if (file == 0) return FALSE;
+  flush();
+  this->file = file;
+  position = LAS_ASYNC_FTELL(file);
+  if (position < 0) position = 0;
+  return TRUE;
+}
+
+bool ByteStreamOutFileAsync::putByte(U8 byte)
+{
+  if (sizes[current] == buffer_size)
+  {
+    if (!queue_current()) return FALSE;
+  }
+  buffers[current][sizes[current]] = byte;
+  sizes[current]++;
+  return TRUE;
+}
+
+bool ByteStreamOutFileAsync::putBytes(const U8* bytes, U32 num_bytes)
+{
+  U32 room;
+  while (num_bytes)
+  {
+    if (sizes[current] == buffer_size)
+    {
+      if (!queue_current()) return FALSE;
+    }
+    room = buffer_size - sizes[current];
+    if (room > num_bytes) room = num_bytes;
+    memcpy(buffers[current] + sizes[current], bytes, room);
+    sizes[current] += room;
+    bytes += room;
+    num_bytes -= room;
+  }
+  return TRUE;
+}
+
+bool ByteStreamOutFileAsync::isSeekable() const
+{
+  return (file != stdout);
+}
+
+I64 ByteStreamOutFileAsync::tell() const
+{
+  return position + sizes[current];
+}
+
+bool ByteStreamOutFileAsync::seek(const I64 position)
+{
+  if (!flush()) return FALSE;
+  if (LAS_ASYNC_FSEEK(file, position, SEEK_SET) != 0) return FALSE;
+  this->position = position;
+  return TRUE;
+}
+
+bool ByteStreamOutFileAsync::seekEnd()
+{
+  if (!flush()) return FALSE;
+  if (LAS_ASYNC_FSEEK(file, 0, SEEK_END) != 0) return FALSE;
+  position = LAS_ASYNC_FTELL(file);
+  return TRUE;
+}
+
+bool ByteStreamOutFileAsync::flush()
+{
+  queue_current();
+  if (thread.is_running())
+  {
+    mutex.lock();
+    while (count) emptied.wait(&mutex);
+    mutex.unlock();
+  }
+  if (fflush(file) != 0) failed = TRUE;
+  return !failed;
+}
+
+ByteStreamOutFileAsyncLE::ByteStreamOutFileAsyncLE(FILE* file, U32 buffer_size, U32 number_buffers) : ByteStreamOutFileAsync(file, buffer_size, number_buffers)
+{
+}
+
+bool ByteStreamOutFileAsyncLE::put16bitsLE(const U8* bytes)
+{
+  return putBytes(bytes, 2);
+}
+
+bool ByteStreamOutFileAsyncLE::put32bitsLE(const U8* bytes)
+{
+  return putBytes(bytes, 4);
+}
+
+bool ByteStreamOutFileAsyncLE::put64bitsLE(const U8* bytes)
+{
+  return putBytes(bytes, 8);
+}
+
+bool ByteStreamOutFileAsyncLE::put16bitsBE(const U8* bytes)
+{
+  swapped[0] = bytes[1];
+  swapped[1] = bytes[0];
+  return putBytes(swapped, 2);
+}
+
+bool ByteStreamOutFileAsyncLE::put32bitsBE(const U8* bytes)
+{
+  swapped[0] = bytes[3];
+  swapped[1] = bytes[2];
+  swapped[2] = bytes[1];
+  swapped[3] = bytes[0];
+  return putBytes(swapped, 4);
+}
+
+bool ByteStreamOutFileAsyncLE::put64bitsBE(const U8* bytes)
+{
+  swapped[0] = bytes[7];
+  swapped[1] = bytes[6];
+  swapped[2] = bytes[5];
+  swapped[3] = bytes[4];
+  swapped[4] = bytes[3];
+  swapped[5] = bytes[2];
+  swapped[6] = bytes[1];
+  swapped[7] = bytes[0];
+  return putBytes(swapped, 8);
+}
+
+ByteStreamOutFileAsyncBE::ByteStreamOutFileAsyncBE(FILE* file, U32 buffer_size, U32 number_buffers) : ByteStreamOutFileAsync(file, buffer_size, number_buffers)
+{
+}
+
+bool ByteStreamOutFileAsyncBE::put16bitsLE(const U8* bytes)
+{
+  swapped[0] = bytes[1];
+  swapped[1] = bytes[0];
+  return putBytes(swapped, 2);
+}
+
+bool ByteStreamOutFileAsyncBE::put32bitsLE(const U8* bytes)
+{
+  swapped[0] = bytes[3];
+  swapped[1] = bytes[2];
+  swapped[2] = bytes[1];
+  swapped[3] = bytes[0];
+  return putBytes(swapped, 4);
+}
+
+bool ByteStreamOutFileAsyncBE::put64bitsLE(const U8* bytes)
+{
+  swapped[0] = bytes[7];
+  swapped[1] = bytes[6];
+  swapped[2] = bytes[5];
+  swapped[3] = bytes[4];
+  swapped[4] = bytes[3];
+  swapped[5] = bytes[2];
+  swapped[6] = bytes[1];
+  swapped[7] = bytes[0];
+  return putBytes(swapped, 8);
+}
+
+bool ByteStreamOutFileAsyncBE::put16bitsBE(const U8* bytes)
+{
+  return putBytes(bytes, 2);
+}
+
+bool ByteStreamOutFileAsyncBE::put32bitsBE(const U8* bytes)
+{
+  return putBytes(bytes, 4);
+}
+
+bool ByteStreamOutFileAsyncBE::put64bitsBE(const U8* bytes)
+{
+  return putBytes(bytes, 8);
+}
@@ -0,0 +1,247 @@
+/*
+===============================================================================
+
+  FILE:  lascatalog.cpp
+  
+  CONTENTS:
+  
+    see corresponding header file
+  
+  PROGRAMMERS:
+  
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+  
+  COPYRIGHT:
+  
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  
+  CHANGE HISTORY:
+  
+    see corresponding header file
+  
+===============================================================================
+*/
+#include "lascatalog.hpp"
+
+#include "lasreader.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <map>
+#include <string>
+using namespace std;
+
+typedef map<string, U32> my_entry_map;
+
+// the first line of a catalog file
+#define LAS_CATALOG_SIGNATURE "LAScatalog 1.1"
+
+void LAScatalogEntry::set(const LASreader* lasreader)
+{
+  valid = TRUE;
+  buffered = (lasreader->header.vlr_lastiling && lasreader->header.vlr_lastiling->buffer);
+  npoints = lasreader->npoints;
+  number_of_point_records = lasreader->header.number_of_point_records;
+  for (U32 r = 0; r < 5; r++) number_of_points_by_return[r] = lasreader->header.number_of_points_by_return[r];
+  point_data_format = lasreader->header.point_data_format;
+  point_data_record_length = lasreader->header.point_data_record_length;
+  min_x = lasreader->header.min_x;
+  min_y = lasreader->header.min_y;
+  min_z = lasreader->header.min_z;
+  max_x = lasreader->header.max_x;
+  max_y = lasreader->header.max_y;
+  max_z = lasreader->header.max_z;
+  x_scale_factor = lasreader->header.x_scale_factor;
+  y_scale_factor = lasreader->header.y_scale_factor;
+  z_scale_factor = lasreader->header.z_scale_factor;
+  x_offset = lasreader->header.x_offset;
+  y_offset = lasreader->header.y_offset;
+  z_offset = lasreader->header.z_offset;
+}
+
+void LAScatalogEntry::get(LASreader* lasreader) const
+{
+  lasreader->npoints = npoints;
+  lasreader->header.number_of_point_records = number_of_point_records;
+  for (U32 r = 0; r < 5; r++) lasreader->header.number_of_points_by_return[r] = number_of_points_by_return[r];
+  lasreader->header.point_data_format = point_data_format;
+  lasreader->header.point_data_record_length = point_data_record_length;
+  lasreader->header.min_x = min_x;
+  lasreader->header.min_y = min_y;
+  lasreader->header.min_z = min_z;
+  lasreader->header.max_x = max_x;
+  lasreader->header.max_y = max_y;
+  lasreader->header.max_z = max_z;
+  lasreader->header.x_scale_factor = x_scale_factor;
+  lasreader->header.y_scale_factor = y_scale_factor;
+  lasreader->header.z_scale_factor = z_scale_factor;
+  lasreader->header.x_offset = x_offset;
+  lasreader->header.y_offset = y_offset;
+  lasreader->header.z_offset = z_offset;
+}
+
+LAScatalogEntry::LAScatalogEntry()
+{
+  memset(this, 0, sizeof(LAScatalogEntry));
+  mtime = -1;
+}
+
+bool LAScatalog::read(const CHAR* file_name)
+{
+  FILE* file = fopen(file_name, "r");
+  if (file == 0)
+  {
+    fprintf(stderr, "ERROR: cannot open catalog '%s'\n", file_name);
+    return FALSE;
+  }
+  CHAR line[2048];
+  if ((fgets(line, 2048, file) == 0) || (strncmp(line, LAS_CATALOG_SIGNATURE, strlen(LAS_CATALOG_SIGNATURE)) != 0))
+  {
+    fprintf(stderr, "ERROR: '%s' is not a catalog\n", file_name);
+    fclose(file);
+    return FALSE;
+  }
+  LAScatalogEntry entry;
+  I32 valid, buffered, point_data_format, point_data_record_length, pos;
+  U32 count = 1;
+  while (fgets(line, 2048, file))
+  {
+    count++;
+    // remove line return and white spaces at the end
+    I32 len = (I32)strlen(line) - 1;
+    while ((len >= 0) && ((line[len] == '\n') || (line[len] == '\r') || (line[len] == ' ') || (line[len] == '\t')))
+    {
+      line[len] = '\0';
+      len--;
+    }
+    if (len < 0) continue;
+    // the file name comes last as it may contain spaces
+#ifdef _WIN32
+    if (sscanf(line, "%I64d %d %d %I64d %u %u %u %u %u %u %d %d %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %n",
+#else
+    if (sscanf(line, "%lld %d %d %lld %u %u %u %u %u %u %d %d %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf %n",
+#endif
+      &entry.mtime, &valid, &buffered, &entry.npoints, &entry.number_of_point_records,
+      &entry.number_of_points_by_return[0], &entry.number_of_points_by_return[1], &entry.number_of_points_by_return[2], &entry.number_of_points_by_return[3], &entry.number_of_points_by_return[4],
+      &point_data_format, &point_data_record_length,
+      &entry.min_x, &entry.min_y, &entry.min_z, &entry.max_x, &entry.max_y, &entry.max_z,
+      &entry.x_scale_factor, &entry.y_scale_factor, &entry.z_scale_factor, &entry.x_offset, &entry.y_offset, &entry.z_offset, &pos) != 24 || (line[pos] == '\0'))
+    {
+      fprintf(stderr, "WARNING: skipping corrupt line %u of catalog '%s'\n", count, file_name);
+      continue;
+    }
+    entry.valid = (valid != 0);
+    entry.buffered = (buffered != 0);
+    entry.point_data_format = (U8)point_data_format;
+    entry.point_data_record_length = (U16)point_data_record_length;
+    add_entry(&line[pos], &entry);
+  }
+  fclose(file);
+  return TRUE;
+}
+
+bool LAScatalog::write(const CHAR* file_name) const
+{
+  FILE* file = fopen(file_name, "w");
+  if (file == 0)
+  {
+    fprintf(stderr, "ERROR: cannot open catalog '%s' for write\n", file_name);
+    return FALSE;
+  }
+  fprintf(file, "%s %u\n", LAS_CATALOG_SIGNATURE, number_entries);
+  for (U32 i = 0; i < number_entries; i++)
+  {
+    const LAScatalogEntry* entry = &entries[i];
+#ifdef _WIN32
+    fprintf(file, "%I64d %d %d %I64d %u %u %u %u %u %u %d %d ",
+#else
+    fprintf(file, "%lld %d %d %lld %u %u %u %u %u %u %d %d ",
+#endif
+      entry->mtime, (entry->valid ? 1 : 0), (entry->buffered ? 1 : 0), entry->npoints, entry->number_of_point_records,
+      entry->number_of_points_by_return[0], entry->number_of_points_by_return[1], entry->number_of_points_by_return[2], entry->number_of_points_by_return[3], entry->number_of_points_by_return[4],
+      entry->point_data_format, entry->point_data_record_length);
+    // enough digits to read back the exact same doubles
+    fprintf(file, "%.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %s\n",
+      entry->min_x, entry->min_y, entry->min_z, entry->max_x, entry->max_y, entry->max_z,
+      entry->x_scale_factor, entry->y_scale_factor, entry->z_scale_factor, entry->x_offset, entry->y_offset, entry->z_offset, file_names[i]);
+  }
+  if (fclose(file) != 0)
+  {
+    fprintf(stderr, "ERROR: cannot write catalog '%s'\n", file_name);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+U32 LAScatalog::add_entry(const CHAR* file_name, const LAScatalogEntry* entry)
+{
+  if (number_entries == alloc_entries)
+  {
+    alloc_entries = (alloc_entries ? 2*alloc_entries : 1024);
+    file_names = (CHAR**)realloc(file_names, sizeof(CHAR*)*alloc_entries);
+    entries = (LAScatalogEntry*)realloc(entries, sizeof(LAScatalogEntry)*alloc_entries);
+  }
+  file_names[number_entries] = strdup(file_name);
+  entries[number_entries] = *entry;
+  // a later entry for the same file replaces an earlier one in the lookup
+  (*((my_entry_map*)lookup))[file_name] = number_entries;
+  number_entries++;
+  return number_entries - 1;
+}
+
+I32 LAScatalog::find_entry(const CHAR* file_name) const
+{
+  my_entry_map::const_iterator it = ((my_entry_map*)lookup)->find(file_name);
+  if (it == ((my_entry_map*)lookup)->end()) return -1;
+  return (I32)(it->second);
+}
+
+bool LAScatalog::is_current(U32 i) const
+{
+  if ((i >= number_entries) || !entries[i].valid) return FALSE;
+  return (get_mtime(file_names[i]) == entries[i].mtime);
+}
+
+I64 LAScatalog::get_mtime(const CHAR* file_name)
+{
+  struct stat file_stat;
+  if (stat(file_name, &file_stat) != 0) return -1;
+  return (I64)file_stat.st_mtime;
+}
+
+void LAScatalog::clean()
+{
+  for (U32 i = 0; i < number_entries; i++) free(file_names[i]);
+  if (file_names) free(file_names);
+  if (entries) free(entries);
+  ((my_entry_map*)lookup)->clear();
+  number_entries = 0;
+  alloc_entries = 0;
+  file_names = 0;
+  entries = 0;
+}
+
+LAScatalog::LAScatalog()
+{
+  number_entries = 0;
+  alloc_entries = 0;
+  file_names = 0;
+  entries = 0;
+  lookup = new my_entry_map;
+}
+
+LAScatalog::~LAScatalog()
+{
+  clean();
+  delete ((my_entry_map*)lookup);
+}
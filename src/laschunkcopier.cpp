@@ -0,0 +1,334 @@
+/*
+===============================================================================
+
+  FILE:  laschunkcopier.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "laschunkcopier.hpp"
+
+#include "lasreader_las.hpp"
+#include "laswriter_las.hpp"
+#include "lasindex.hpp"
+#include "lasfilter.hpp"
+#include "lastransform.hpp"
+#include "laswritepoint.hpp"
+#include "bytestreamout_array.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// chunks are only interchangeable when they were encoded for the same items
+
+bool LASchunkcopier::qualifies(const LASheader* header) const
+{
+  U32 i;
+  if ((header->laszip == 0) || (header->laszip->compressor != LASZIP_COMPRESSOR_CHUNKED)) return FALSE;
+  if (header->point_data_format != first->point_data_format) return FALSE;
+  if (header->point_data_record_length != first->point_data_record_length) return FALSE;
+  if (header->laszip->num_items != first->laszip->num_items) return FALSE;
+  for (i = 0; i < header->laszip->num_items; i++)
+  {
+    if (header->laszip->items[i].type != first->laszip->items[i].type) return FALSE;
+    if (header->laszip->items[i].size != first->laszip->items[i].size) return FALSE;
+    if (header->laszip->items[i].version != first->laszip->items[i].version) return FALSE;
+  }
+  if ((header->x_scale_factor != first->x_scale_factor) || (header->y_scale_factor != first->y_scale_factor) || (header->z_scale_factor != first->z_scale_factor)) return FALSE;
+  if ((header->x_offset != first->x_offset) || (header->y_offset != first->y_offset) || (header->z_offset != first->z_offset)) return FALSE;
+  return TRUE;
+}
+
+bool LASchunkcopier::reserve_bytes(U32 number_bytes)
+{
+  if (number_bytes > alloc_bytes)
+  {
+    if (bytes) free(bytes);
+    alloc_bytes = number_bytes + number_bytes/4;
+    bytes = (U8*)malloc(alloc_bytes);
+    if (bytes == 0)
+    {
+      fprintf(stderr,"ERROR: cannot allocate %u bytes for chunk\n", alloc_bytes);
+      alloc_bytes = 0;
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+bool LASchunkcopier::copy_chunk(LASreaderLAS* lasreaderlas, U32 chunk)
+{
+  U32 number_bytes = lasreaderlas->get_chunk_bytes(chunk);
+  if (!reserve_bytes(number_bytes)) return FALSE;
+  if (!lasreaderlas->read_chunk(chunk, bytes)) return FALSE;
+  if (!laswriterlas->write_chunk(bytes, number_bytes, lasreaderlas->get_chunk_points(chunk))) return FALSE;
+  chunks_copied++;
+  return TRUE;
+}
+
+// decodes a chunk once to see which of its points are inside. only chunks
+// straddling the boundary are decoded again and their inside points encoded
+
+bool LASchunkcopier::clip_chunk(LASreaderLAS* lasreaderlas, U32 chunk, I64 first_point)
+{
+  U32 i, inside = 0, number_points = lasreaderlas->get_chunk_points(chunk);
+  LASinventory inventory;
+  if (!lasreaderlas->seek(first_point)) return FALSE;
+  for (i = 0; i < number_points; i++)
+  {
+    if (!lasreaderlas->read_point()) return FALSE;
+    if (lasreaderlas->point.inside_rectangle(r_min_x, r_min_y, r_max_x, r_max_y))
+    {
+      inventory.add(&lasreaderlas->point);
+      inside++;
+    }
+  }
+  laswriterlas->inventory.add(&inventory);
+  if (inside == 0)
+  {
+    chunks_skipped++;
+    return TRUE;
+  }
+  if (inside == number_points)
+  {
+    return copy_chunk(lasreaderlas, chunk);
+  }
+  // a chunk is exactly what a pointwise compressor writes for its points
+  ByteStreamOutArray* out;
+  if (IS_LITTLE_ENDIAN())
+    out = new ByteStreamOutArrayLE();
+  else
+    out = new ByteStreamOutArrayBE();
+  LASwritePoint* writer = new LASwritePoint();
+  if (!writer->setup(laszip->num_items, laszip->items, laszip) || !writer->init(out))
+  {
+    fprintf(stderr,"ERROR: cannot re-encode chunk %u\n", chunk);
+    delete writer;
+    delete out;
+    return FALSE;
+  }
+  bool success = lasreaderlas->seek(first_point);
+  for (i = 0; success && (i < number_points); i++)
+  {
+    if (!lasreaderlas->read_point()) success = FALSE;
+    else if (lasreaderlas->point.inside_rectangle(r_min_x, r_min_y, r_max_x, r_max_y)) success = writer->write(lasreaderlas->point.point);
+  }
+  writer->done();
+  delete writer;
+  if (success) success = laswriterlas->write_chunk(out->getData(), (U32)out->getSize(), inside);
+  delete out;
+  if (success) chunks_recoded++;
+  return success;
+}
+
+bool LASchunkcopier::copy_file(LASreaderLAS* lasreaderlas, const CHAR* file_name)
+{
+  U32 chunk, number_chunks = lasreaderlas->get_number_chunks();
+  if ((number_chunks == 0) && (lasreaderlas->npoints != 0))
+  {
+    fprintf(stderr,"ERROR: no chunk table in '%s'\n", file_name);
+    return FALSE;
+  }
+  const LASheader* header = &lasreaderlas->header;
+
+  // files that are completely inside are copied without decoding anything
+
+  if (!clip || ((r_min_x <= header->min_x) && (header->max_x <= r_max_x) && (r_min_y <= header->min_y) && (header->max_y <= r_max_y)))
+  {
+    for (chunk = 0; chunk < number_chunks; chunk++)
+    {
+      if (!copy_chunk(lasreaderlas, chunk)) return FALSE;
+    }
+    laswriterlas->inventory.add(header);
+    return TRUE;
+  }
+
+  if ((header->max_x < r_min_x) || (r_max_x < header->min_x) || (header->max_y < r_min_y) || (r_max_y < header->min_y))
+  {
+    chunks_skipped += number_chunks;
+    return TRUE;
+  }
+
+  // the LAX file tells which chunks have no point in the rectangle
+
+  I64* first_points = new I64[number_chunks+1];
+  first_points[0] = 0;
+  for (chunk = 0; chunk < number_chunks; chunk++) first_points[chunk+1] = first_points[chunk] + lasreaderlas->get_chunk_points(chunk);
+  U8* candidate = new U8[number_chunks];
+  LASindex lasindex;
+  if (lasindex.read(file_name))
+  {
+    memset(candidate, 0, number_chunks);
+    if (lasindex.intersect_rectangle(r_min_x, r_min_y, r_max_x, r_max_y))
+    {
+      lasindex.get_intervals();
+      chunk = 0;
+      while (lasindex.has_intervals())
+      {
+        // intervals come sorted but may start in an earlier chunk than the last one ended
+        U32 lo = 0, hi = number_chunks;
+        while ((hi - lo) > 1)
+        {
+          U32 mid = (lo + hi) / 2;
+          if (first_points[mid] <= (I64)lasindex.start) lo = mid; else hi = mid;
+        }
+        for (chunk = lo; (chunk < number_chunks) && (first_points[chunk] <= (I64)lasindex.end); chunk++)
+        {
+          candidate[chunk] = 1;
+        }
+      }
+    }
+  }
+  else
+  {
+    memset(candidate, 1, number_chunks);
+  }
+
+  bool success = TRUE;
+  for (chunk = 0; success && (chunk < number_chunks); chunk++)
+  {
+    if (candidate[chunk])
+      success = clip_chunk(lasreaderlas, chunk, first_points[chunk]);
+    else
+      chunks_skipped++;
+  }
+  delete [] first_points;
+  delete [] candidate;
+  return success;
+}
+
+I64 LASchunkcopier::copy(LASreadOpener* lasreadopener, const CHAR* file_name_out)
+{
+  U32 f, number_files = lasreadopener->get_file_name_number();
+  if (number_files == 0) return -1;
+
+  // the opener may not change points
+
+  if (lasreadopener->get_filter() && lasreadopener->get_filter()->active()) return -1;
+  if (lasreadopener->get_transform() && lasreadopener->get_transform()->active()) return -1;
+  if (lasreadopener->get_scale_factor() || lasreadopener->get_offset() || lasreadopener->is_auto_reoffset()) return -1;
+  if (lasreadopener->get_inside_tile() || lasreadopener->get_inside_circle()) return -1;
+  const F64* rectangle = lasreadopener->get_inside_rectangle();
+  clip = (rectangle != 0);
+  if (clip)
+  {
+    r_min_x = rectangle[0];
+    r_min_y = rectangle[1];
+    r_max_x = rectangle[2];
+    r_max_y = rectangle[3];
+  }
+
+  // all files must qualify before anything is written
+
+  LASreaderLAS* lasreaderlas_first = new LASreaderLAS();
+  if (!lasreaderlas_first->open(lasreadopener->get_file_name(0), 262144, TRUE))
+  {
+    delete lasreaderlas_first;
+    return -1;
+  }
+  first = &lasreaderlas_first->header;
+  if (!qualifies(first))
+  {
+    delete lasreaderlas_first;
+    return -1;
+  }
+  for (f = 1; f < number_files; f++)
+  {
+    LASreaderLAS lasreaderlas;
+    if (!lasreaderlas.open(lasreadopener->get_file_name(f), 262144, TRUE) || !qualifies(&lasreaderlas.header))
+    {
+      delete lasreaderlas_first;
+      return -1;
+    }
+  }
+
+  // the re-encoder for boundary chunks uses the items of the first file
+
+  if (laszip) delete laszip;
+  laszip = new LASzip();
+  laszip->setup(first->laszip->num_items, first->laszip->items, LASZIP_COMPRESSOR_POINTWISE);
+  laszip->request_version(first->laszip->items[0].version);
+
+  laswriterlas = new LASwriterLAS();
+  laswriterlas->set_chunk_copy(TRUE);
+  if (!laswriterlas->open(file_name_out, first, LASZIP_COMPRESSOR_CHUNKED, first->laszip->items[0].version))
+  {
+    fprintf(stderr,"ERROR: cannot open '%s' for copying chunks\n", file_name_out);
+    delete laswriterlas;
+    laswriterlas = 0;
+    delete lasreaderlas_first;
+    return -1;
+  }
+
+  bool success = TRUE;
+  for (f = 0; success && (f < number_files); f++)
+  {
+    LASreaderLAS lasreaderlas;
+    if (!lasreaderlas.open(lasreadopener->get_file_name(f)))
+    {
+      fprintf(stderr,"ERROR: cannot open '%s'\n", lasreadopener->get_file_name(f));
+      success = FALSE;
+    }
+    else
+    {
+      success = copy_file(&lasreaderlas, lasreadopener->get_file_name(f));
+    }
+  }
+
+  laswriterlas->update_header(first, TRUE);
+  I64 number_points = laswriterlas->p_count;
+  if ((laswriterlas->close() < 0) || !success) number_points = -1;
+  delete laswriterlas;
+  laswriterlas = 0;
+  if (number_points == -1)
+  {
+    // no truncated output is left behind
+    remove(file_name_out);
+  }
+  delete lasreaderlas_first;
+  first = 0;
+  return number_points;
+}
+
+LASchunkcopier::LASchunkcopier()
+{
+  first = 0;
+  laswriterlas = 0;
+  laszip = 0;
+  clip = FALSE;
+  r_min_x = r_min_y = r_max_x = r_max_y = 0.0;
+  bytes = 0;
+  alloc_bytes = 0;
+  chunks_copied = 0;
+  chunks_recoded = 0;
+  chunks_skipped = 0;
+}
+
+LASchunkcopier::~LASchunkcopier()
+{
+  if (laszip) delete laszip;
+  if (bytes) free(bytes);
+}
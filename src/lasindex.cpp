@@ -33,6 +33,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
 
 #include "lasspatial.hpp"
 #include "lasinterval.hpp"
@@ -61,12 +64,22 @@ LASindex::LASindex()
   full = 0;
   total = 0;
   cells = 0;
+  read_ahead = 0;
+  coalesce_bytes = 0;
+  ranges = 0;
+  ranges_alloc = 0;
+  ranges_number = 0;
+  ranges_current = 0;
+  ranges_advised = 0;
+  ranges_valid = FALSE;
+  preview = 0;
 }
 
 LASindex::~LASindex()
 {
   if (spatial) delete spatial;
   if (interval) delete interval;
+  if (ranges) free(ranges);
 }
 
 void LASindex::prepare(LASspatial* spatial, I32 threshold)
@@ -213,6 +226,7 @@ LASinterval* LASindex::get_interval() const
 bool LASindex::intersect_rectangle(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y)
 {
   have_interval = FALSE;
+  ranges_valid = FALSE;
   cells = spatial->intersect_rectangle(r_min_x, r_min_y, r_max_x, r_max_y);
 //  fprintf(stderr,"%d cells of %g/%g %g/%g intersect rect %g/%g %g/%g\n", num_cells, spatial->get_min_x(), spatial->get_min_y(), spatial->get_max_x(), spatial->get_max_y(), r_min_x, r_min_y, r_max_x, r_max_y);
   if (cells)
@@ -223,6 +237,7 @@ bool LASindex::intersect_rectangle(const F64 r_min_x, const F64 r_min_y, const F
 bool LASindex::intersect_tile(const F32 ll_x, const F32 ll_y, const F32 size)
 {
   have_interval = FALSE;
+  ranges_valid = FALSE;
   cells = spatial->intersect_tile(ll_x, ll_y, size);
 //  fprintf(stderr,"%d cells of %g/%g %g/%g intersect tile %g/%g/%g\n", num_cells, spatial->get_min_x(), spatial->get_min_y(), spatial->get_max_x(), spatial->get_max_y(), ll_x, ll_y, size);
   if (cells)
@@ -233,6 +248,7 @@ bool LASindex::intersect_tile(const F32 ll_x, const F32 ll_y, const F32 size)
 bool LASindex::intersect_circle(const F64 center_x, const F64 center_y, const F64 radius)
 {
   have_interval = FALSE;
+  ranges_valid = FALSE;
   cells = spatial->intersect_circle(center_x, center_y, radius);
 //  fprintf(stderr,"%d cells of %g/%g %g/%g intersect circle %g/%g/%g\n", num_cells, spatial->get_min_x(), spatial->get_min_y(), spatial->get_max_x(), spatial->get_max_y(), center_x, center_y, radius);
   if (cells)
@@ -240,9 +256,94 @@ bool LASindex::intersect_circle(const F64 center_x, const F64 center_y, const F6
   return FALSE;
 }
 
+// total number of points as recorded in the cells of the index
+U32 LASindex::count_points()
+{
+  U32 count = 0;
+  interval->get_cells();
+  while (interval->has_cells())
+  {
+    count += interval->full;
+  }
+  return count;
+}
+
+// bounds the number of points inside the rectangle: cells that are completely
+// inside contribute to both counts, cells that are only touched to the upper
+bool LASindex::count_rectangle(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, U32* lower, U32* upper)
+{
+  F32 min[2];
+  F32 max[2];
+  *lower = 0;
+  *upper = 0;
+  interval->get_cells();
+  while (interval->has_cells())
+  {
+    spatial->get_cell_bounding_box(interval->index, min, max);
+    if ((min[0] > r_max_x) || (min[1] > r_max_y) || (max[0] < r_min_x) || (max[1] < r_min_y)) continue;
+    if ((r_min_x <= min[0]) && (r_min_y <= min[1]) && (max[0] <= r_max_x) && (max[1] <= r_max_y))
+    {
+      *lower += interval->full;
+    }
+    *upper += interval->full;
+  }
+  return (*upper != 0);
+}
+
+// adds the points of each cell to the raster cells it overlaps proportional to
+// the overlap area (assuming a uniform distribution within each cell). rows are
+// stored bottom to top so that counts[row*ncols+col] covers the area starting at
+// ll_x + col*step and ll_y + row*step. the raster is not cleared to allow that
+// the counts of many indices get accumulated into the same raster.
+bool LASindex::raster_counts(const F64 ll_x, const F64 ll_y, const F64 step, const U32 ncols, const U32 nrows, F32* counts)
+{
+  F32 min[2];
+  F32 max[2];
+  I32 col, row, min_col, max_col, min_row, max_row;
+  F64 area, overlap_x, overlap_y;
+  F64 ur_x = ll_x + step*ncols;
+  F64 ur_y = ll_y + step*nrows;
+  bool overlap = FALSE;
+  interval->get_cells();
+  while (interval->has_cells())
+  {
+    if (interval->full == 0) continue;
+    spatial->get_cell_bounding_box(interval->index, min, max);
+    if ((min[0] >= ur_x) || (min[1] >= ur_y) || (max[0] <= ll_x) || (max[1] <= ll_y)) continue;
+    area = ((F64)max[0] - (F64)min[0])*((F64)max[1] - (F64)min[1]);
+    if (area <= 0.0) continue;
+    min_col = I32_FLOOR((min[0] - ll_x)/step);
+    max_col = I32_FLOOR((max[0] - ll_x)/step);
+    min_row = I32_FLOOR((min[1] - ll_y)/step);
+    max_row = I32_FLOOR((max[1] - ll_y)/step);
+    if (min_col < 0) min_col = 0;
+    if (max_col >= (I32)ncols) max_col = ncols - 1;
+    if (min_row < 0) min_row = 0;
+    if (max_row >= (I32)nrows) max_row = nrows - 1;
+    for (row = min_row; row <= max_row; row++)
+    {
+      overlap_y = (row+1)*step + ll_y;
+      if (overlap_y > max[1]) overlap_y = max[1];
+      overlap_y -= ((row*step + ll_y) < min[1] ? min[1] : (row*step + ll_y));
+      if (overlap_y <= 0.0) continue;
+      for (col = min_col; col <= max_col; col++)
+      {
+        overlap_x = (col+1)*step + ll_x;
+        if (overlap_x > max[0]) overlap_x = max[0];
+        overlap_x -= ((col*step + ll_x) < min[0] ? min[0] : (col*step + ll_x));
+        if (overlap_x <= 0.0) continue;
+        counts[row*ncols+col] += (F32)(interval->full*overlap_x*overlap_y/area);
+        overlap = TRUE;
+      }
+    }
+  }
+  return overlap;
+}
+
 bool LASindex::get_intervals()
 {
   have_interval = FALSE;
+  ranges_valid = FALSE;
   return interval->get_merged_cell();
 }
 
@@ -260,9 +361,8 @@ bool LASindex::has_intervals()
   return FALSE;
 }
 
-bool LASindex::read(const char* file_name)
+static char* lax_file_name(const char* file_name, const char* directory)
 {
-  if (file_name == 0) return FALSE;
   char* name = strdup(file_name);
   if (strstr(file_name, ".las") || strstr(file_name, ".laz"))
   {
@@ -278,11 +378,43 @@ bool LASindex::read(const char* file_name)
     name[strlen(name)-2] = 'a';
     name[strlen(name)-1] = 'x';
   }
-  FILE* file = fopen(name, "rb");
+  if (directory == 0) return name;
+  // same LAX name but placed into the (cache) directory
+  I32 len = (I32)strlen(name);
+  while ((len > 0) && (name[len-1] != '/') && (name[len-1] != '\\') && (name[len-1] != ':')) len--;
+  I32 dir_len = (I32)strlen(directory);
+  char* dir_name = (char*)malloc(dir_len + strlen(&name[len]) + 2);
+  strcpy(dir_name, directory);
+  if ((dir_len > 0) && (directory[dir_len-1] != '/') && (directory[dir_len-1] != '\\'))
+  {
+    strcat(dir_name, "/");
+  }
+  strcat(dir_name, &name[len]);
   free(name);
+  return dir_name;
+}
+
+bool LASindex::read(const char* file_name, const char* directory)
+{
+  if (file_name == 0) return FALSE;
+  char* name = lax_file_name(file_name, 0);
+  FILE* file = fopen(name, "rb");
+  if ((file == 0) && directory)
+  {
+    // a cached LAX file is only used when it is not older than the file it indexes
+    free(name);
+    name = lax_file_name(file_name, directory);
+    struct stat file_stat;
+    struct stat lax_stat;
+    if ((stat(file_name, &file_stat) == 0) && (stat(name, &lax_stat) == 0) && (lax_stat.st_mtime >= file_stat.st_mtime))
+    {
+      file = fopen(name, "rb");
+    }
+  }
   if (file == 0)
   {
 //    fprintf(stderr,"ERROR (LASindex): cannot open '%s' for read\n", name);
+    free(name);
     return FALSE;
   }
   ByteStreamIn* stream;
@@ -295,10 +427,12 @@ bool LASindex::read(const char* file_name)
     fprintf(stderr,"ERROR (LASindex): cannot read '%s'\n", name);
     delete stream;
     fclose(file);
+    free(name);
     return FALSE;
   }
   delete stream;
   fclose(file);
+  free(name);
   return TRUE;
 }
 
@@ -437,25 +571,18 @@ bool LASindex::append(const char* file_name) const
   return TRUE;
 }
 
-bool LASindex::write(const char* file_name) const
+bool LASindex::write(const char* file_name, const char* directory) const
 {
   if (file_name == 0) return FALSE;
-  char* name = strdup(file_name);
-  if (strstr(file_name, ".las") || strstr(file_name, ".laz"))
-  {
-    name[strlen(name)-1] = 'x';
-  }
-  else if (strstr(file_name, ".LAS") || strstr(file_name, ".LAZ"))
-  {
-    name[strlen(name)-1] = 'X';
-  }
-  else
+  char* name = lax_file_name(file_name, 0);
+  FILE* file = fopen(name, "wb");
+  if ((file == 0) && directory)
   {
-    name[strlen(name)-3] = 'l';
-    name[strlen(name)-2] = 'a';
-    name[strlen(name)-1] = 'x';
+    // the data may live on a read-only volume so fall back to the cache directory
+    free(name);
+    name = lax_file_name(file_name, directory);
+    file = fopen(name, "wb");
   }
-  FILE* file = fopen(name, "wb");
   if (file == 0)
   {
     fprintf(stderr,"ERROR (LASindex): cannot open '%s' for write\n", name);
@@ -563,12 +690,153 @@ bool LASindex::write(ByteStreamOut* stream) const
   return TRUE;
 }
 
+void LASindex::set_read_ahead(const U32 intervals, const U32 coalesce_bytes)
+{
+  this->read_ahead = intervals;
+  this->coalesce_bytes = coalesce_bytes;
+  ranges_valid = FALSE;
+}
+
+void LASindex::set_preview(const U32 point_budget)
+{
+  preview = point_budget;
+  have_interval = FALSE;
+  ranges_valid = FALSE;
+  // the preview walks the cells one by one so the merged intervals start over
+  if (interval) interval->get_merged_cell();
+}
+
+// every intersected cell gives the same fraction of its points, taken from
+// the start of each of its intervals. the rounding error of one interval is
+// carried into the next so that small intervals still add up to a share.
+bool LASindex::get_preview_ranges(const U32 gap)
+{
+  U32 i, count = 0;
+  if (!spatial->get_intersected_cells()) return FALSE;
+  while (spatial->has_more_cells())
+  {
+    if (interval->get_cell(spatial->current_cell)) count += interval->full;
+  }
+  F64 fraction = ((count > preview) ? (F64)preview / (F64)count : 1.0);
+  U32 number = 0;
+  U32 alloc = 0;
+  U64* preview_ranges = 0;
+  spatial->get_intersected_cells();
+  while (spatial->has_more_cells())
+  {
+    if (!interval->get_cell(spatial->current_cell)) continue;
+    F64 carry = 0.0;
+    while (interval->has_intervals())
+    {
+      U32 length = interval->end - interval->start + 1;
+      carry += fraction*length;
+      U32 take = (U32)carry;
+      if (take == 0) continue;
+      if (take > length) take = length;
+      carry -= take;
+      if (number == alloc)
+      {
+        alloc = (alloc ? 2*alloc : 1024);
+        preview_ranges = (U64*)realloc(preview_ranges, sizeof(U64)*alloc);
+      }
+      preview_ranges[number] = (((U64)interval->start) << 32) | (U64)(interval->start + take - 1);
+      number++;
+    }
+  }
+  // the ranges of different cells may overlap so they are sorted and merged
+  std::sort(preview_ranges, preview_ranges + number);
+  ranges_number = 0;
+  for (i = 0; i < number; i++)
+  {
+    U32 range_start = (U32)(preview_ranges[i] >> 32);
+    U32 range_end = (U32)(preview_ranges[i] & 0xFFFFFFFF);
+    if (ranges_number && ((range_start <= ranges[2*ranges_number-1]) || ((range_start - ranges[2*ranges_number-1] - 1) <= gap)))
+    {
+      if (range_end > ranges[2*ranges_number-1]) ranges[2*ranges_number-1] = range_end;
+    }
+    else
+    {
+      if (ranges_number == ranges_alloc)
+      {
+        ranges_alloc = (ranges_alloc ? 2*ranges_alloc : 256);
+        ranges = (U32*)realloc(ranges, sizeof(U32)*2*ranges_alloc);
+      }
+      ranges[2*ranges_number] = range_start;
+      ranges[2*ranges_number+1] = range_end;
+      ranges_number++;
+    }
+  }
+  if (preview_ranges) free(preview_ranges);
+  return TRUE;
+}
+
+// the merged intervals of the current query are copied into an array once so
+// that intervals separated by fewer than coalesce_bytes get joined (reading
+// through the gap is cheaper than a seek) and so that the reader can be told
+// about the next few intervals long before it has to seek there
+bool LASindex::get_next_range(LASreader* lasreader)
+{
+  if (!ranges_valid)
+  {
+    U32 gap = 0;
+    if (lasreader->header.point_data_record_length)
+    {
+      gap = coalesce_bytes / lasreader->header.point_data_record_length;
+    }
+    ranges_number = 0;
+    if (preview)
+    {
+      get_preview_ranges(gap);
+    }
+    else
+    {
+      while (interval->has_intervals())
+      {
+        if (ranges_number && (interval->start > ranges[2*ranges_number-1]) && ((interval->start - ranges[2*ranges_number-1] - 1) <= gap))
+        {
+          if (interval->end > ranges[2*ranges_number-1]) ranges[2*ranges_number-1] = interval->end;
+        }
+        else
+        {
+          if (ranges_number == ranges_alloc)
+          {
+            ranges_alloc = (ranges_alloc ? 2*ranges_alloc : 256);
+            ranges = (U32*)realloc(ranges, sizeof(U32)*2*ranges_alloc);
+          }
+          ranges[2*ranges_number] = interval->start;
+          ranges[2*ranges_number+1] = interval->end;
+          ranges_number++;
+        }
+      }
+    }
+    ranges_current = 0;
+    ranges_advised = 0;
+    ranges_valid = TRUE;
+  }
+  if (ranges_current == ranges_number) return FALSE;
+  start = ranges[2*ranges_current];
+  end = ranges[2*ranges_current+1];
+  ranges_current++;
+  // keep the current and the next read_ahead ranges in flight
+  while ((ranges_advised < ranges_number) && (ranges_advised < ranges_current + read_ahead))
+  {
+    lasreader->prefetch(ranges[2*ranges_advised], ranges[2*ranges_advised+1]);
+    ranges_advised++;
+  }
+  have_interval = TRUE;
+  return TRUE;
+}
+
 // read next interval point
 bool LASindex::read_next(LASreader* lasreader)
 {
   if (!have_interval)
   {
-    if (!has_intervals()) return FALSE;
+    if (read_ahead || coalesce_bytes || preview)
+    {
+      if (!get_next_range(lasreader)) return FALSE;
+    }
+    else if (!has_intervals()) return FALSE;
     lasreader->seek(start);
   }
   if (lasreader->p_count == end)
@@ -583,7 +851,11 @@ bool LASindex::seek_next(LASreader* lasreader)
 {
   if (!have_interval)
   {
-    if (!has_intervals()) return FALSE;
+    if (read_ahead || coalesce_bytes || preview)
+    {
+      if (!get_next_range(lasreader)) return FALSE;
+    }
+    else if (!has_intervals()) return FALSE;
     lasreader->seek(start);
   }
   if (lasreader->p_count == end)
@@ -0,0 +1,553 @@
+/*
+===============================================================================
+
+  FILE:  lasoctree.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "lasoctree.hpp"
+
+#include "lasreader.hpp"
+#include "laswriter_las.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#ifdef UNORDERED
+#include <tr1/unordered_map>
+using namespace std;
+using namespace tr1;
+typedef unordered_map<U64,U32> my_octree_hash;
+#else
+#include <hash_map>
+using namespace std;
+typedef hash_map<U64,U32> my_octree_hash;
+#endif
+
+// the cells of all levels and the nodes share one key space
+
+static inline U64 las_octree_key(const I32 level, const U32 x, const U32 y, const U32 z)
+{
+  return (((U64)level) << 60) | (((U64)x) << 40) | (((U64)y) << 20) | ((U64)z);
+}
+
+static inline U32 las_octree_cell(const F64 f, const U32 cells)
+{
+  if (f <= 0.0) return 0;
+  U32 c = (U32)(f*cells);
+  return (c < cells ? c : cells - 1);
+}
+
+static U64 las_octree_morton(const U32 x, const U32 y, const U32 z)
+{
+  U32 b;
+  U64 code = 0;
+  for (b = 0; b < 20; b++)
+  {
+    code |= ((U64)((x >> b) & 1)) << (3*b+2);
+    code |= ((U64)((y >> b) & 1)) << (3*b+1);
+    code |= ((U64)((z >> b) & 1)) << (3*b);
+  }
+  return code;
+}
+
+class LASoctreeOrder
+{
+public:
+  U64 key;
+  U32 node;
+  bool operator<(const LASoctreeOrder& other) const { return key < other.key; };
+};
+
+// a copy of the header that owns its own VLRs (without any octree VLRs) so
+// that the hierarchy is not added to the header of the reader
+
+static void las_octree_copy_header(LASheader* copy, const LASheader* header)
+{
+  U32 i;
+  *copy = *header;
+  copy->unlink();
+  if (header->user_data_in_header_size)
+  {
+    copy->user_data_in_header_size = header->user_data_in_header_size;
+    copy->user_data_in_header = new U8[header->user_data_in_header_size];
+    memcpy(copy->user_data_in_header, header->user_data_in_header, header->user_data_in_header_size);
+  }
+  if (header->number_attributes)
+  {
+    copy->init_attributes(header->number_attributes, header->attributes);
+  }
+  for (i = 0; i < header->number_of_variable_length_records; i++)
+  {
+    const LASvlr* vlr = &(header->vlrs[i]);
+    if (LASoctree::is_octree_vlr(vlr)) continue;
+    U8* data = 0;
+    if (vlr->record_length_after_header)
+    {
+      data = new U8[vlr->record_length_after_header];
+      memcpy(data, vlr->data, vlr->record_length_after_header);
+    }
+    copy->add_vlr(vlr->user_id, vlr->record_id, vlr->record_length_after_header, data);
+    memcpy(copy->vlrs[copy->number_of_variable_length_records-1].description, vlr->description, 32);
+  }
+  if (header->laszip)
+  {
+    copy->laszip = new LASzip();
+    copy->laszip->setup(header->laszip->num_items, header->laszip->items, header->laszip->compressor);
+  }
+  if (header->vlr_lastiling)
+  {
+    copy->vlr_lastiling = new LASvlr_lastiling();
+    *(copy->vlr_lastiling) = *(header->vlr_lastiling);
+  }
+  if (header->vlr_lasoriginal)
+  {
+    copy->vlr_lasoriginal = new LASvlr_lasoriginal();
+    *(copy->vlr_lasoriginal) = *(header->vlr_lasoriginal);
+  }
+  if (header->user_data_after_header_size)
+  {
+    copy->user_data_after_header_size = header->user_data_after_header_size;
+    copy->user_data_after_header = new U8[header->user_data_after_header_size];
+    memcpy(copy->user_data_after_header, header->user_data_after_header, header->user_data_after_header_size);
+    copy->offset_to_point_data += header->user_data_after_header_size;
+  }
+}
+
+void LASoctree::set_max_level(const I32 max_level)
+{
+  requested_max_level = (max_level > LAS_OCTREE_MAX_LEVEL ? LAS_OCTREE_MAX_LEVEL : max_level);
+}
+
+I64 LASoctree::build(LASreader* lasreader, const CHAR* file_name)
+{
+  U32 n, p;
+
+  if ((lasreader == 0) || (file_name == 0))
+  {
+    fprintf(stderr,"ERROR: no reader or no file name for octree\n");
+    return -1;
+  }
+  if (lasreader->npoints > U32_MAX)
+  {
+    fprintf(stderr,"ERROR: octree cannot hold %u or more points\n", U32_MAX);
+    return -1;
+  }
+
+  clean();
+
+  LASheader* header = &lasreader->header;
+  LASpoint* point = &lasreader->point;
+  U32 size = point->total_point_size;
+
+  // the root cube around the bounding box
+
+  center_x = (header->min_x + header->max_x) / 2;
+  center_y = (header->min_y + header->max_y) / 2;
+  center_z = (header->min_z + header->max_z) / 2;
+  halfsize = header->max_x - header->min_x;
+  if (halfsize < (header->max_y - header->min_y)) halfsize = header->max_y - header->min_y;
+  if (halfsize < (header->max_z - header->min_z)) halfsize = header->max_z - header->min_z;
+  halfsize = (halfsize > 0.0 ? halfsize / 2 : 1.0);
+  U32 cells = (1 << LAS_OCTREE_CELLS_LOG2);
+  spacing = 2*halfsize / cells;
+
+  // without a requested depth the levels grow until a surface fits
+
+  max_level = requested_max_level;
+  if (max_level < 0)
+  {
+    F64 capacity = (F64)cells*(F64)cells;
+    max_level = 0;
+    while ((max_level < LAS_OCTREE_MAX_LEVEL) && (capacity < (F64)lasreader->npoints))
+    {
+      capacity *= 4;
+      max_level++;
+    }
+  }
+
+  // each point goes to the coarsest level whose cell is still free
+
+  U32 alloc_points = (lasreader->npoints > 0 ? (U32)lasreader->npoints : 1024);
+  U8* records = (U8*)malloc((size_t)size*alloc_points);
+  U32* point_nodes = (U32*)malloc(sizeof(U32)*alloc_points);
+  if ((records == 0) || (point_nodes == 0))
+  {
+    fprintf(stderr,"ERROR: cannot allocate memory for %u points\n", alloc_points);
+    if (records) free(records);
+    if (point_nodes) free(point_nodes);
+    return -1;
+  }
+  U32 number_points = 0;
+  U32 alloc_nodes = 0;
+  my_octree_hash occupied;
+  my_octree_hash node_index;
+  F64 min_x = center_x - halfsize;
+  F64 min_y = center_y - halfsize;
+  F64 min_z = center_z - halfsize;
+  F64 width = 2*halfsize;
+
+  while (lasreader->read_point())
+  {
+    if (number_points == alloc_points)
+    {
+      alloc_points *= 2;
+      records = (U8*)realloc(records, (size_t)size*alloc_points);
+      point_nodes = (U32*)realloc(point_nodes, sizeof(U32)*alloc_points);
+      if ((records == 0) || (point_nodes == 0))
+      {
+        fprintf(stderr,"ERROR: cannot allocate memory for %u points\n", alloc_points);
+        if (records) free(records);
+        if (point_nodes) free(point_nodes);
+        return -1;
+      }
+    }
+    F64 fx = (point->get_x() - min_x) / width;
+    F64 fy = (point->get_y() - min_y) / width;
+    F64 fz = (point->get_z() - min_z) / width;
+    I32 level;
+    U32 cx = 0, cy = 0, cz = 0;
+    for (level = 0; level <= max_level; level++)
+    {
+      U32 level_cells = (cells << level);
+      cx = las_octree_cell(fx, level_cells);
+      cy = las_octree_cell(fy, level_cells);
+      cz = las_octree_cell(fz, level_cells);
+      if (level == max_level) break;
+      if (occupied.insert(my_octree_hash::value_type(las_octree_key(level, cx, cy, cz), 0)).second) break;
+    }
+    cx >>= LAS_OCTREE_CELLS_LOG2;
+    cy >>= LAS_OCTREE_CELLS_LOG2;
+    cz >>= LAS_OCTREE_CELLS_LOG2;
+    U64 key = las_octree_key(level, cx, cy, cz);
+    my_octree_hash::iterator hash_element = node_index.find(key);
+    if (hash_element == node_index.end())
+    {
+      if (number_nodes == alloc_nodes)
+      {
+        alloc_nodes = (alloc_nodes ? 2*alloc_nodes : 1024);
+        LASoctreeNode* more_nodes = (LASoctreeNode*)realloc(nodes, sizeof(LASoctreeNode)*alloc_nodes);
+        if (more_nodes == 0)
+        {
+          fprintf(stderr,"ERROR: cannot allocate memory for %u octree nodes\n", alloc_nodes);
+          free(records);
+          free(point_nodes);
+          clean();
+          return -1;
+        }
+        nodes = more_nodes;
+      }
+      n = number_nodes;
+      nodes[n].level = level;
+      nodes[n].x = cx;
+      nodes[n].y = cy;
+      nodes[n].z = cz;
+      nodes[n].first = 0;
+      nodes[n].number = 0;
+      node_index.insert(my_octree_hash::value_type(key, n));
+      number_nodes++;
+    }
+    else
+    {
+      n = (*hash_element).second;
+    }
+    nodes[n].number++;
+    point->copy_to(&(records[(size_t)number_points*size]));
+    point_nodes[number_points] = n;
+    number_points++;
+  }
+  occupied.clear();
+  node_index.clear();
+
+  // the nodes go level by level and in Morton order within a level
+
+  LASoctreeOrder* order = new LASoctreeOrder[number_nodes];
+  for (n = 0; n < number_nodes; n++)
+  {
+    order[n].key = (((U64)nodes[n].level) << 60) | las_octree_morton(nodes[n].x, nodes[n].y, nodes[n].z);
+    order[n].node = n;
+  }
+  std::sort(order, order + number_nodes);
+  U32* rank = new U32[number_nodes];
+  U32* next = new U32[number_nodes];
+  LASoctreeNode* sorted_nodes = (LASoctreeNode*)malloc(sizeof(LASoctreeNode)*(number_nodes ? number_nodes : 1));
+  I64 first = 0;
+  for (n = 0; n < number_nodes; n++)
+  {
+    sorted_nodes[n] = nodes[order[n].node];
+    sorted_nodes[n].first = first;
+    next[n] = (U32)first;
+    first += sorted_nodes[n].number;
+    rank[order[n].node] = n;
+  }
+  free(nodes);
+  nodes = sorted_nodes;
+  delete [] order;
+
+  // counting sort of the points into the order of their nodes
+
+  U32* sequence = new U32[number_points ? number_points : 1];
+  for (p = 0; p < number_points; p++)
+  {
+    sequence[next[rank[point_nodes[p]]]++] = p;
+  }
+  delete [] rank;
+  delete [] next;
+  free(point_nodes);
+
+  // every node becomes one chunk of the LAZ file
+
+  bool compress = !(strstr(file_name, ".las") || strstr(file_name, ".LAS"));
+  LASheader octree_header;
+  las_octree_copy_header(&octree_header, header);
+  bool success = write_vlrs(&octree_header);
+  LASwriterLAS laswriterlas;
+  if (success)
+  {
+    if (compress) laswriterlas.set_variable_chunking(TRUE);
+    if (!laswriterlas.open(file_name, &octree_header, (compress ? LASZIP_COMPRESSOR_CHUNKED : LASZIP_COMPRESSOR_NONE)))
+    {
+      fprintf(stderr,"ERROR: cannot open '%s' for octree\n", file_name);
+      success = FALSE;
+    }
+  }
+  if (success)
+  {
+    p = 0;
+    for (n = 0; success && (n < number_nodes); n++)
+    {
+      U32 i;
+      for (i = 0; i < nodes[n].number; i++, p++)
+      {
+        point->copy_from(&(records[(size_t)sequence[p]*size]));
+        if (!laswriterlas.write_point(point))
+        {
+          success = FALSE;
+          break;
+        }
+        laswriterlas.update_inventory(point);
+      }
+      if (success && compress) success = laswriterlas.chunk();
+    }
+    laswriterlas.update_header(&octree_header, TRUE);
+    if (laswriterlas.close() < 0) success = FALSE;
+  }
+  octree_header.clean();
+  delete [] sequence;
+  free(records);
+
+  return (success ? (I64)number_points : -1);
+}
+
+// the cube, the depth, and the number of nodes go into a VLR of 56 bytes
+//   U16  version                                        2 bytes
+//   U16  cells_log2                                     2 bytes
+//   I32  max_level                                      4 bytes
+//   F64  center_x, center_y, center_z                  24 bytes
+//   F64  halfsize                                       8 bytes
+//   F64  spacing                                        8 bytes
+//   U32  number_nodes                                   4 bytes
+//   U32  number_pages                                   4 bytes
+// and the nodes into pages of 28 bytes per node
+//   I32  level, x, y, z                                16 bytes
+//   I64  first                                          8 bytes
+//   U32  number                                         4 bytes
+
+bool LASoctree::write_vlrs(LASheader* header) const
+{
+  U32 n, p;
+  U32 number_pages = (number_nodes + LAS_OCTREE_NODES_PER_PAGE - 1) / LAS_OCTREE_NODES_PER_PAGE;
+  if ((LAS_OCTREE_PAGE_RECORD_ID + number_pages) > U16_MAX_PLUS_ONE)
+  {
+    fprintf(stderr,"ERROR: too many octree nodes (%u) for VLRs\n", number_nodes);
+    return FALSE;
+  }
+  remove_vlrs(header);
+
+  U8* data = new U8[56];
+  U16 version = LAS_OCTREE_VERSION;
+  U16 cells_log2 = LAS_OCTREE_CELLS_LOG2;
+  memcpy(data, &version, 2);
+  memcpy(data + 2, &cells_log2, 2);
+  memcpy(data + 4, &max_level, 4);
+  memcpy(data + 8, &center_x, 8);
+  memcpy(data + 16, &center_y, 8);
+  memcpy(data + 24, &center_z, 8);
+  memcpy(data + 32, &halfsize, 8);
+  memcpy(data + 40, &spacing, 8);
+  memcpy(data + 48, &number_nodes, 4);
+  memcpy(data + 52, &number_pages, 4);
+  header->add_vlr(LAS_OCTREE_USER_ID, LAS_OCTREE_RECORD_ID, 56, data);
+
+  for (p = 0; p < number_pages; p++)
+  {
+    U32 start = p*LAS_OCTREE_NODES_PER_PAGE;
+    U32 number = number_nodes - start;
+    if (number > LAS_OCTREE_NODES_PER_PAGE) number = LAS_OCTREE_NODES_PER_PAGE;
+    data = new U8[number*LAS_OCTREE_NODE_SIZE];
+    for (n = 0; n < number; n++)
+    {
+      const LASoctreeNode* node = &(nodes[start + n]);
+      U8* entry = &(data[n*LAS_OCTREE_NODE_SIZE]);
+      memcpy(entry, &(node->level), 4);
+      memcpy(entry + 4, &(node->x), 4);
+      memcpy(entry + 8, &(node->y), 4);
+      memcpy(entry + 12, &(node->z), 4);
+      memcpy(entry + 16, &(node->first), 8);
+      memcpy(entry + 24, &(node->number), 4);
+    }
+    header->add_vlr(LAS_OCTREE_USER_ID, (U16)(LAS_OCTREE_PAGE_RECORD_ID + p), (U16)(number*LAS_OCTREE_NODE_SIZE), data);
+  }
+  return TRUE;
+}
+
+bool LASoctree::read_vlrs(const LASheader* header)
+{
+  U32 n, p;
+  clean();
+  const LASvlr* vlr = header->get_vlr(LAS_OCTREE_USER_ID, LAS_OCTREE_RECORD_ID);
+  if ((vlr == 0) || (vlr->record_length_after_header != 56) || (vlr->data == 0))
+  {
+    return FALSE;
+  }
+  U16 version, cells_log2;
+  U32 number_pages;
+  memcpy(&version, vlr->data, 2);
+  memcpy(&cells_log2, vlr->data + 2, 2);
+  if ((version != LAS_OCTREE_VERSION) || (cells_log2 != LAS_OCTREE_CELLS_LOG2))
+  {
+    fprintf(stderr,"ERROR: octree version %d with %d cells is not supported\n", version, (1 << cells_log2));
+    return FALSE;
+  }
+  memcpy(&max_level, vlr->data + 4, 4);
+  memcpy(&center_x, vlr->data + 8, 8);
+  memcpy(&center_y, vlr->data + 16, 8);
+  memcpy(&center_z, vlr->data + 24, 8);
+  memcpy(&halfsize, vlr->data + 32, 8);
+  memcpy(&spacing, vlr->data + 40, 8);
+  memcpy(&number_nodes, vlr->data + 48, 4);
+  memcpy(&number_pages, vlr->data + 52, 4);
+  nodes = (LASoctreeNode*)malloc(sizeof(LASoctreeNode)*(number_nodes ? number_nodes : 1));
+  if (nodes == 0)
+  {
+    fprintf(stderr,"ERROR: cannot allocate %u octree nodes\n", number_nodes);
+    number_nodes = 0;
+    return FALSE;
+  }
+
+  I64 first = 0;
+  for (p = 0; p < number_pages; p++)
+  {
+    U32 start = p*LAS_OCTREE_NODES_PER_PAGE;
+    U32 number = (start < number_nodes ? number_nodes - start : 0);
+    if (number > LAS_OCTREE_NODES_PER_PAGE) number = LAS_OCTREE_NODES_PER_PAGE;
+    vlr = header->get_vlr(LAS_OCTREE_USER_ID, (U16)(LAS_OCTREE_PAGE_RECORD_ID + p));
+    if ((vlr == 0) || (vlr->record_length_after_header != number*LAS_OCTREE_NODE_SIZE) || (vlr->data == 0))
+    {
+      fprintf(stderr,"ERROR: page %u of octree hierarchy is missing or corrupt\n", p);
+      clean();
+      return FALSE;
+    }
+    for (n = 0; n < number; n++)
+    {
+      LASoctreeNode* node = &(nodes[start + n]);
+      const U8* entry = &(vlr->data[n*LAS_OCTREE_NODE_SIZE]);
+      memcpy(&(node->level), entry, 4);
+      memcpy(&(node->x), entry + 4, 4);
+      memcpy(&(node->y), entry + 8, 4);
+      memcpy(&(node->z), entry + 12, 4);
+      memcpy(&(node->first), entry + 16, 8);
+      memcpy(&(node->number), entry + 24, 4);
+      if (node->first != first)
+      {
+        fprintf(stderr,"ERROR: octree node %u starts at point %u instead of %u\n", start + n, (U32)node->first, (U32)first);
+        clean();
+        return FALSE;
+      }
+      first += node->number;
+    }
+  }
+  if (first != header->number_of_point_records)
+  {
+    fprintf(stderr,"ERROR: octree has %u instead of %u points\n", (U32)first, header->number_of_point_records);
+    clean();
+    return FALSE;
+  }
+  return TRUE;
+}
+
+void LASoctree::remove_vlrs(LASheader* header) const
+{
+  U32 i = header->number_of_variable_length_records;
+  while (i)
+  {
+    i--;
+    if (is_octree_vlr(&(header->vlrs[i]))) header->remove_vlr(i);
+  }
+}
+
+bool LASoctree::is_octree_vlr(const LASvlr* vlr)
+{
+  return (strncmp(vlr->user_id, LAS_OCTREE_USER_ID, 16) == 0);
+}
+
+void LASoctree::get_bounding_box(const LASoctreeNode* node, F64* min, F64* max) const
+{
+  F64 size = 2*halfsize / (1 << node->level);
+  min[0] = center_x - halfsize + size*node->x;
+  min[1] = center_y - halfsize + size*node->y;
+  min[2] = center_z - halfsize + size*node->z;
+  max[0] = min[0] + size;
+  max[1] = min[1] + size;
+  max[2] = min[2] + size;
+}
+
+void LASoctree::clean()
+{
+  if (nodes) free(nodes);
+  nodes = 0;
+  number_nodes = 0;
+  max_level = 0;
+}
+
+LASoctree::LASoctree()
+{
+  center_x = center_y = center_z = 0.0;
+  halfsize = 0.0;
+  spacing = 0.0;
+  max_level = 0;
+  number_nodes = 0;
+  nodes = 0;
+  requested_max_level = -1;
+}
+
+LASoctree::~LASoctree()
+{
+  clean();
+}
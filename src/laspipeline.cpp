@@ -0,0 +1,407 @@
+/*
+===============================================================================
+
+  FILE:  laspipeline.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "laspipeline.hpp"
+
+#include "lasreader.hpp"
+#include "laswriter.hpp"
+#include "lasfilter.hpp"
+#include "lastransform.hpp"
+#include "lasthread.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LAS_PIPELINE_FILTER    0
+#define LAS_PIPELINE_TRANSFORM 1
+#define LAS_PIPELINE_STAGE     2
+#define LAS_PIPELINE_WRITER    3
+
+class LASpipelineBlock
+{
+public:
+  LASpoint* points;
+  U32 number;
+  LASpipelineBlock* next;
+};
+
+class LASpipelineQueue
+{
+public:
+  LASpipelineBlock* first;
+  LASpipelineBlock* last;
+  bool closed;
+  LAScondition filled;
+  void push(LASpipelineBlock* block)
+  {
+    block->next = 0;
+    if (last) last->next = block;
+    else first = block;
+    last = block;
+    filled.signal();
+  };
+  LASpipelineBlock* pop()
+  {
+    LASpipelineBlock* block = first;
+    if (block)
+    {
+      first = block->next;
+      if (first == 0) last = 0;
+    }
+    return block;
+  };
+  LASpipelineQueue() { first = 0; last = 0; closed = FALSE; };
+};
+
+class LASpipelineShared
+{
+public:
+  LASmutex mutex;
+  bool stop;
+  U32 number_queues;
+  LASpipelineQueue* queues; // one in front of each step and last the empty blocks
+  void abort()
+  {
+    mutex.lock();
+    stop = TRUE;
+    for (U32 i = 0; i < number_queues; i++) queues[i].filled.broadcast();
+    mutex.unlock();
+  };
+};
+
+class LASpipelineStep
+{
+public:
+  U32 type;
+  LASfilter* lasfilter;
+  LAStransform* lastransform;
+  LASpipelineStage* stage;
+  LASwriter* laswriter;
+  bool update_inventory;
+  LASthread thread;
+  LASpipelineShared* shared;
+  U32 index;
+  I64 count;
+  LASpipelineStep(U32 type)
+  {
+    this->type = type;
+    lasfilter = 0;
+    lastransform = 0;
+    stage = 0;
+    laswriter = 0;
+    update_inventory = FALSE;
+    shared = 0;
+    index = 0;
+    count = 0;
+  };
+};
+
+void LASpipeline::set_block_size(U32 points_per_block)
+{
+  this->points_per_block = (points_per_block ? points_per_block : 1);
+}
+
+void LASpipeline::set_number_blocks(U32 number_blocks)
+{
+  this->number_blocks = number_blocks;
+}
+
+void LASpipeline::add_filter(LASfilter* lasfilter)
+{
+  if (lasfilter == 0) return;
+  LASpipelineStep* step = new LASpipelineStep(LAS_PIPELINE_FILTER);
+  step->lasfilter = lasfilter;
+  add_step(step);
+}
+
+void LASpipeline::add_transform(LAStransform* lastransform)
+{
+  if (lastransform == 0) return;
+  LASpipelineStep* step = new LASpipelineStep(LAS_PIPELINE_TRANSFORM);
+  step->lastransform = lastransform;
+  add_step(step);
+}
+
+void LASpipeline::add_stage(LASpipelineStage* stage)
+{
+  if (stage == 0) return;
+  LASpipelineStep* step = new LASpipelineStep(LAS_PIPELINE_STAGE);
+  step->stage = stage;
+  add_step(step);
+}
+
+void LASpipeline::add_writer(LASwriter* laswriter, bool update_inventory)
+{
+  if (laswriter == 0) return;
+  LASpipelineStep* step = new LASpipelineStep(LAS_PIPELINE_WRITER);
+  step->laswriter = laswriter;
+  step->update_inventory = update_inventory;
+  add_step(step);
+}
+
+void LASpipeline::add_step(LASpipelineStep* step)
+{
+  if (number_steps == alloc_steps)
+  {
+    alloc_steps += 4;
+    steps = (LASpipelineStep**)realloc(steps, sizeof(LASpipelineStep*)*alloc_steps);
+  }
+  steps[number_steps] = step;
+  number_steps++;
+}
+
+// processes one block and compacts the points that survive to its front
+
+bool LASpipeline::process_block(LASpipelineStep* step, LASpoint* points, U32* number)
+{
+  U32 i, kept = 0;
+  switch (step->type)
+  {
+  case LAS_PIPELINE_FILTER:
+    for (i = 0; i < *number; i++)
+    {
+      if (step->lasfilter->filter(&points[i])) continue;
+      if (kept != i) points[kept] = points[i];
+      kept++;
+    }
+    break;
+  case LAS_PIPELINE_TRANSFORM:
+    for (i = 0; i < *number; i++)
+    {
+      step->lastransform->transform(&points[i]);
+    }
+    kept = *number;
+    break;
+  case LAS_PIPELINE_STAGE:
+    for (i = 0; i < *number; i++)
+    {
+      if (!step->stage->process(&points[i])) continue;
+      if (kept != i) points[kept] = points[i];
+      kept++;
+    }
+    break;
+  case LAS_PIPELINE_WRITER:
+    for (i = 0; i < *number; i++)
+    {
+      if (!step->laswriter->write_point(&points[i]))
+      {
+        fprintf(stderr, "ERROR: pipeline could not write point %u of block\n", i);
+        return FALSE;
+      }
+      if (step->update_inventory) step->laswriter->update_inventory(&points[i]);
+    }
+    kept = *number;
+    break;
+  }
+  *number = kept;
+  step->count += kept;
+  return TRUE;
+}
+
+// each step takes blocks from its queue and hands them on to the next one
+
+void LASpipeline::run_step(void* data)
+{
+  LASpipelineStep* step = (LASpipelineStep*)data;
+  LASpipelineShared* shared = step->shared;
+  LASpipelineQueue* input = &(shared->queues[step->index]);
+  LASpipelineQueue* output = &(shared->queues[step->index+1]);
+  LASpipelineBlock* block;
+  while (TRUE)
+  {
+    shared->mutex.lock();
+    while ((input->first == 0) && !input->closed && !shared->stop) input->filled.wait(&shared->mutex);
+    block = (shared->stop ? 0 : input->pop());
+    shared->mutex.unlock();
+    if (block == 0) break;
+    bool ok = process_block(step, block->points, &block->number);
+    shared->mutex.lock();
+    output->push(block);
+    shared->mutex.unlock();
+    if (!ok)
+    {
+      shared->abort();
+      break;
+    }
+  }
+  shared->mutex.lock();
+  output->closed = TRUE;
+  output->filled.broadcast();
+  shared->mutex.unlock();
+}
+
+I64 LASpipeline::run(LASreader* lasreader)
+{
+  if (lasreader == 0)
+  {
+    fprintf(stderr, "ERROR: pipeline has no lasreader\n");
+    return -1;
+  }
+  if (number_steps == 0)
+  {
+    fprintf(stderr, "ERROR: pipeline has no stages\n");
+    return -1;
+  }
+
+  // a lone writer may move the raw records when nothing changes per point
+
+  if ((number_steps == 1) && (steps[0]->type == LAS_PIPELINE_WRITER))
+  {
+    I64 count = steps[0]->laswriter->copy_raw_points(lasreader, steps[0]->update_inventory);
+    if (count >= 0) return count;
+  }
+
+  U32 i, j;
+  U32 blocks = (number_blocks ? number_blocks : 2*(number_steps+1));
+  LASpipelineBlock* block;
+  LASpipelineShared shared;
+  shared.stop = FALSE;
+  shared.number_queues = number_steps + 1;
+  shared.queues = new LASpipelineQueue[shared.number_queues];
+
+  for (i = 0; i < blocks; i++)
+  {
+    block = new LASpipelineBlock();
+    block->points = new LASpoint[points_per_block];
+    for (j = 0; j < points_per_block; j++)
+    {
+      if (lasreader->header.laszip)
+        block->points[j].init(&lasreader->header, lasreader->header.laszip->num_items, lasreader->header.laszip->items, &lasreader->header);
+      else
+        block->points[j].init(&lasreader->header, lasreader->header.point_data_format, lasreader->header.point_data_record_length, &lasreader->header);
+    }
+    block->number = 0;
+    shared.queues[number_steps].push(block);
+  }
+
+  // start one thread per step
+
+  bool threaded = TRUE;
+  for (i = 0; i < number_steps; i++)
+  {
+    steps[i]->shared = &shared;
+    steps[i]->index = i;
+    steps[i]->count = 0;
+    if (!steps[i]->thread.start(run_step, steps[i]))
+    {
+      threaded = FALSE;
+      break;
+    }
+  }
+
+  if (!threaded)
+  {
+    // stop the threads that did start and run all steps one after the other
+    shared.abort();
+    for (i = 0; i < number_steps; i++) steps[i]->thread.join();
+    shared.stop = FALSE;
+    block = shared.queues[number_steps].pop();
+    while (block && !shared.stop)
+    {
+      block->number = 0;
+      while ((block->number < points_per_block) && lasreader->read_point())
+      {
+        block->points[block->number] = lasreader->point;
+        block->number++;
+      }
+      if (block->number == 0) break;
+      bool full = (block->number == points_per_block);
+      for (i = 0; i < number_steps; i++)
+      {
+        if (!process_block(steps[i], block->points, &block->number))
+        {
+          shared.stop = TRUE;
+          break;
+        }
+      }
+      if (!full) break;
+    }
+    if (block) shared.queues[number_steps].push(block);
+  }
+  else
+  {
+    // the calling thread is the reader
+    while (TRUE)
+    {
+      shared.mutex.lock();
+      while ((shared.queues[number_steps].first == 0) && !shared.stop) shared.queues[number_steps].filled.wait(&shared.mutex);
+      block = (shared.stop ? 0 : shared.queues[number_steps].pop());
+      shared.mutex.unlock();
+      if (block == 0) break;
+      block->number = 0;
+      while ((block->number < points_per_block) && lasreader->read_point())
+      {
+        block->points[block->number] = lasreader->point;
+        block->number++;
+      }
+      bool full = (block->number == points_per_block);
+      shared.mutex.lock();
+      shared.queues[(block->number ? 0 : number_steps)].push(block);
+      shared.mutex.unlock();
+      if (!full) break;
+    }
+    shared.mutex.lock();
+    shared.queues[0].closed = TRUE;
+    shared.queues[0].filled.broadcast();
+    shared.mutex.unlock();
+    for (i = 0; i < number_steps; i++) steps[i]->thread.join();
+  }
+
+  // all blocks are back in the empty queue unless a step failed
+
+  for (i = 0; i < shared.number_queues; i++)
+  {
+    while ((block = shared.queues[i].pop()))
+    {
+      delete [] block->points;
+      delete block;
+    }
+  }
+  delete [] shared.queues;
+
+  if (shared.stop) return -1;
+  return steps[number_steps-1]->count;
+}
+
+LASpipeline::LASpipeline()
+{
+  points_per_block = 4096;
+  number_blocks = 0;
+  number_steps = 0;
+  alloc_steps = 0;
+  steps = 0;
+}
+
+LASpipeline::~LASpipeline()
+{
+  for (U32 i = 0; i < number_steps; i++) delete steps[i];
+  if (steps) free(steps);
+}
@@ -0,0 +1,710 @@
+/*
+===============================================================================
+
+  FILE:  laspointfast.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "laspointfast.hpp"
+
+#include "laszip.hpp"
+#include "bytestreamin.hpp"
+#include "bytestreamout.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// layout of a chunk
+//   U32 number of points
+//   for each byte of the point record
+//     U32 size of the column (top bit set when the column is stored raw)
+//     U8  bytes of the column
+// layout of the chunk table
+//   U32 version (0)
+//   U32 number of chunks
+//   for each chunk
+//     U32 number of points
+//     U32 number of bytes
+
+#define LAS_FAST_MIN_MATCH 4
+#define LAS_FAST_MAX_OFFSET 65535
+
+static inline U32 las_fast_hash(const U8* bytes)
+{
+  U32 sequence;
+  memcpy(&sequence, bytes, 4);
+  return (sequence * 2654435761U) >> (32 - LAS_FAST_HASH_BITS);
+}
+
+static inline U8* las_fast_put_length(U8* out, U32 length)
+{
+  while (length >= 255)
+  {
+    *out++ = 255;
+    length -= 255;
+  }
+  *out++ = (U8)length;
+  return out;
+}
+
+// a byte-aligned LZ coder in the style of LZ4. each sequence is a token with
+// the literal and match lengths, the literals, and a 16 bit match offset. the
+// last sequence only has literals. returns 0 when the output is not smaller.
+
+U32 LASfastCoder::compress(const U8* in, const U32 size, U8* out, U32* hash_table)
+{
+  if (size < 16) return 0;
+  memset(hash_table, 0, sizeof(U32) << LAS_FAST_HASH_BITS);
+  U8* op = out;
+  U8* oend = out + size;
+  U32 anchor = 0;
+  U32 ip = 1;
+  U32 limit = size - LAS_FAST_MIN_MATCH;
+  hash_table[las_fast_hash(in)] = 0;
+  while (ip <= limit)
+  {
+    U32 h = las_fast_hash(in + ip);
+    U32 ref = hash_table[h];
+    hash_table[h] = ip;
+    if ((ip - ref > LAS_FAST_MAX_OFFSET) || (memcmp(in + ref, in + ip, LAS_FAST_MIN_MATCH) != 0))
+    {
+      // skip faster through data that does not compress
+      ip += 1 + ((ip - anchor) >> 6);
+      continue;
+    }
+    U32 length = LAS_FAST_MIN_MATCH;
+    while ((ip + length < size) && (in[ref + length] == in[ip + length])) length++;
+    U32 literals = ip - anchor;
+    if ((op + 1 + literals/255 + 1 + literals + 2 + (length - LAS_FAST_MIN_MATCH)/255 + 1) >= oend) return 0;
+    U8* token = op++;
+    *token = (U8)((literals < 15 ? literals : 15) << 4);
+    if (literals >= 15) op = las_fast_put_length(op, literals - 15);
+    memcpy(op, in + anchor, literals);
+    op += literals;
+    U32 offset = ip - ref;
+    *op++ = (U8)(offset & 0xFF);
+    *op++ = (U8)(offset >> 8);
+    U32 extra = length - LAS_FAST_MIN_MATCH;
+    *token |= (U8)(extra < 15 ? extra : 15);
+    if (extra >= 15) op = las_fast_put_length(op, extra - 15);
+    ip += length;
+    anchor = ip;
+  }
+  U32 literals = size - anchor;
+  if ((op + 1 + literals/255 + 1 + literals) >= oend) return 0;
+  U8* token = op++;
+  *token = (U8)((literals < 15 ? literals : 15) << 4);
+  if (literals >= 15) op = las_fast_put_length(op, literals - 15);
+  memcpy(op, in + anchor, literals);
+  op += literals;
+  return (U32)(op - out);
+}
+
+// checks every length and offset so that a damaged file cannot write out of bounds
+
+bool LASfastCoder::decompress(const U8* in, const U32 in_size, U8* out, const U32 size)
+{
+  const U8* ip = in;
+  const U8* iend = in + in_size;
+  U32 op = 0;
+  U32 length, offset, byte;
+  while (ip < iend)
+  {
+    U32 token = *ip++;
+    length = token >> 4;
+    if (length == 15)
+    {
+      do
+      {
+        if (ip >= iend) return FALSE;
+        byte = *ip++;
+        length += byte;
+      } while (byte == 255);
+    }
+    if ((length > (U32)(iend - ip)) || (length > size - op)) return FALSE;
+    memcpy(out + op, ip, length);
+    ip += length;
+    op += length;
+    if (ip == iend) break;
+    if ((iend - ip) < 2) return FALSE;
+    offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if ((offset == 0) || (offset > op)) return FALSE;
+    length = token & 15;
+    if (length == 15)
+    {
+      do
+      {
+        if (ip >= iend) return FALSE;
+        byte = *ip++;
+        length += byte;
+      } while (byte == 255);
+    }
+    length += LAS_FAST_MIN_MATCH;
+    if (length > size - op) return FALSE;
+    if (offset >= length)
+    {
+      memcpy(out + op, out + op - offset, length);
+      op += length;
+    }
+    else
+    {
+      // overlapping matches repeat the last 'offset' bytes
+      while (length--)
+      {
+        out[op] = out[op - offset];
+        op++;
+      }
+    }
+  }
+  return (op == size);
+}
+
+// deltas are zigzag coded so that small negative differences have zero high bytes
+
+void LASfastCoder::delta_encode(U8* records, const U32 number, const U32 record_size, const U32 size)
+{
+  U32 i;
+  U8* r = records + (number - 1)*record_size;
+  if (size == 2)
+  {
+    U16 value, previous, delta;
+    for (i = number - 1; i > 0; i--, r -= record_size)
+    {
+      memcpy(&value, r, 2);
+      memcpy(&previous, r - record_size, 2);
+      delta = (U16)(value - previous);
+      delta = (U16)((delta << 1) ^ (U16)((I16)delta >> 15));
+      memcpy(r, &delta, 2);
+    }
+    memcpy(&value, r, 2);
+    value = (U16)((value << 1) ^ (U16)((I16)value >> 15));
+    memcpy(r, &value, 2);
+  }
+  else if (size == 4)
+  {
+    U32 value, previous, delta;
+    for (i = number - 1; i > 0; i--, r -= record_size)
+    {
+      memcpy(&value, r, 4);
+      memcpy(&previous, r - record_size, 4);
+      delta = value - previous;
+      delta = (delta << 1) ^ (U32)((I32)delta >> 31);
+      memcpy(r, &delta, 4);
+    }
+    memcpy(&value, r, 4);
+    value = (value << 1) ^ (U32)((I32)value >> 31);
+    memcpy(r, &value, 4);
+  }
+  else
+  {
+    U64 value, previous, delta;
+    for (i = number - 1; i > 0; i--, r -= record_size)
+    {
+      memcpy(&value, r, 8);
+      memcpy(&previous, r - record_size, 8);
+      delta = value - previous;
+      delta = (delta << 1) ^ (U64)((I64)delta >> 63);
+      memcpy(r, &delta, 8);
+    }
+    memcpy(&value, r, 8);
+    value = (value << 1) ^ (U64)((I64)value >> 63);
+    memcpy(r, &value, 8);
+  }
+}
+
+void LASfastCoder::delta_decode(U8* records, const U32 number, const U32 record_size, const U32 size)
+{
+  U32 i;
+  U8* r = records;
+  if (size == 2)
+  {
+    U16 value, previous = 0;
+    for (i = 0; i < number; i++, r += record_size)
+    {
+      memcpy(&value, r, 2);
+      previous = (U16)(previous + ((value >> 1) ^ (U16)(0 - (value & 1))));
+      memcpy(r, &previous, 2);
+    }
+  }
+  else if (size == 4)
+  {
+    U32 value, previous = 0;
+    for (i = 0; i < number; i++, r += record_size)
+    {
+      memcpy(&value, r, 4);
+      previous += (value >> 1) ^ (0 - (value & 1));
+      memcpy(r, &previous, 4);
+    }
+  }
+  else
+  {
+    U64 value, previous = 0;
+    for (i = 0; i < number; i++, r += record_size)
+    {
+      memcpy(&value, r, 8);
+      previous += (value >> 1) ^ (0 - (value & 1));
+      memcpy(r, &previous, 8);
+    }
+  }
+}
+
+bool LASpointFastLayout::setup(const U32 num_items, const LASitem* items)
+{
+  U32 i;
+  if ((num_items == 0) || (num_items > 16)) return FALSE;
+  this->num_items = num_items;
+  record_size = 0;
+  num_fields = 0;
+  for (i = 0; i < num_items; i++)
+  {
+    item_offsets[i] = record_size;
+    item_sizes[i] = items[i].size;
+    switch (items[i].type)
+    {
+    case LASitem::POINT10:
+      // X, Y, and Z
+      field_offsets[num_fields] = record_size; field_sizes[num_fields] = 4; num_fields++;
+      field_offsets[num_fields] = record_size + 4; field_sizes[num_fields] = 4; num_fields++;
+      field_offsets[num_fields] = record_size + 8; field_sizes[num_fields] = 4; num_fields++;
+      break;
+    case LASitem::GPSTIME11:
+      // nearby doubles also have nearby bit patterns
+      field_offsets[num_fields] = record_size; field_sizes[num_fields] = 8; num_fields++;
+      break;
+    case LASitem::RGB12:
+      field_offsets[num_fields] = record_size; field_sizes[num_fields] = 2; num_fields++;
+      field_offsets[num_fields] = record_size + 2; field_sizes[num_fields] = 2; num_fields++;
+      field_offsets[num_fields] = record_size + 4; field_sizes[num_fields] = 2; num_fields++;
+      break;
+    case LASitem::WAVEPACKET13:
+    case LASitem::BYTE:
+      break;
+    default:
+      fprintf(stderr,"ERROR: fast compression does not support item '%s'\n", items[i].get_name());
+      return FALSE;
+    }
+    if (num_fields > 8) return FALSE;
+    record_size += items[i].size;
+  }
+  return (record_size != 0);
+}
+
+bool LASwritePointFast::setup(const U32 num_items, const LASitem* items, const U32 chunk_size)
+{
+  if (!IS_LITTLE_ENDIAN())
+  {
+    fprintf(stderr,"ERROR: fast compression needs a little-endian machine\n");
+    return FALSE;
+  }
+  if (!layout.setup(num_items, items)) return FALSE;
+  this->chunk_size = ((chunk_size == 0) || (chunk_size == U32_MAX) ? 50000 : chunk_size);
+  records = (U8*)malloc((size_t)this->chunk_size*layout.record_size);
+  column = (U8*)malloc(this->chunk_size);
+  compressed = (U8*)malloc(this->chunk_size);
+  hash_table = (U32*)malloc(sizeof(U32) << LAS_FAST_HASH_BITS);
+  if ((records == 0) || (column == 0) || (compressed == 0) || (hash_table == 0))
+  {
+    fprintf(stderr,"ERROR: cannot allocate buffers for chunks of %u points\n", this->chunk_size);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+bool LASwritePointFast::init(ByteStreamOut* outstream)
+{
+  if (outstream == 0) return FALSE;
+  this->outstream = outstream;
+  // the start of the chunk table is filled in at the end
+  chunk_table_start_position = outstream->tell();
+  I64 unknown = -1;
+  if (!outstream->put64bitsLE((U8*)&unknown)) return FALSE;
+  points_in_chunk = 0;
+  number_chunks = 0;
+  return TRUE;
+}
+
+bool LASwritePointFast::write(const U8* const * point)
+{
+  U32 i;
+  U8* record = records + points_in_chunk*layout.record_size;
+  for (i = 0; i < layout.num_items; i++)
+  {
+    memcpy(record + layout.item_offsets[i], point[i], layout.item_sizes[i]);
+  }
+  points_in_chunk++;
+  if (points_in_chunk == chunk_size) return write_chunk();
+  return TRUE;
+}
+
+bool LASwritePointFast::chunk()
+{
+  return write_chunk();
+}
+
+bool LASwritePointFast::write_chunk()
+{
+  if (points_in_chunk == 0) return TRUE;
+  U32 i, c;
+  U32 number = points_in_chunk;
+  U32 record_size = layout.record_size;
+  I64 start = outstream->tell();
+
+  for (i = 0; i < layout.num_fields; i++)
+  {
+    LASfastCoder::delta_encode(records + layout.field_offsets[i], number, record_size, layout.field_sizes[i]);
+  }
+
+  if (!outstream->put32bitsLE((U8*)&number)) return FALSE;
+  for (c = 0; c < record_size; c++)
+  {
+    const U8* r = records + c;
+    for (i = 0; i < number; i++, r += record_size) column[i] = *r;
+    U32 size = LASfastCoder::compress(column, number, compressed, hash_table);
+    if (size)
+    {
+      if (!outstream->put32bitsLE((U8*)&size)) return FALSE;
+      if (!outstream->putBytes(compressed, size)) return FALSE;
+    }
+    else
+    {
+      size = number | LAS_FAST_RAW_COLUMN;
+      if (!outstream->put32bitsLE((U8*)&size)) return FALSE;
+      if (!outstream->putBytes(column, number)) return FALSE;
+    }
+  }
+
+  if (number_chunks == alloc_chunks)
+  {
+    alloc_chunks += 1024;
+    chunk_points = (U32*)realloc(chunk_points, sizeof(U32)*alloc_chunks);
+    chunk_bytes = (U32*)realloc(chunk_bytes, sizeof(U32)*alloc_chunks);
+    if ((chunk_points == 0) || (chunk_bytes == 0))
+    {
+      fprintf(stderr,"ERROR: cannot allocate chunk table for %u chunks\n", alloc_chunks);
+      return FALSE;
+    }
+  }
+  chunk_points[number_chunks] = number;
+  chunk_bytes[number_chunks] = (U32)(outstream->tell() - start);
+  number_chunks++;
+  points_in_chunk = 0;
+  return TRUE;
+}
+
+bool LASwritePointFast::write_chunk_table()
+{
+  U32 i;
+  I64 position = outstream->tell();
+  if (outstream->isSeekable())
+  {
+    if (!outstream->seek(chunk_table_start_position)) return FALSE;
+    if (!outstream->put64bitsLE((U8*)&position)) return FALSE;
+    if (!outstream->seek(position)) return FALSE;
+  }
+  U32 version = 0;
+  if (!outstream->put32bitsLE((U8*)&version)) return FALSE;
+  if (!outstream->put32bitsLE((U8*)&number_chunks)) return FALSE;
+  for (i = 0; i < number_chunks; i++)
+  {
+    if (!outstream->put32bitsLE((U8*)&chunk_points[i])) return FALSE;
+    if (!outstream->put32bitsLE((U8*)&chunk_bytes[i])) return FALSE;
+  }
+  if (!outstream->isSeekable())
+  {
+    // readers find the chunk table via the last eight bytes
+    if (!outstream->put64bitsLE((U8*)&position)) return FALSE;
+  }
+  return TRUE;
+}
+
+bool LASwritePointFast::done()
+{
+  if (outstream == 0) return TRUE;
+  bool success = write_chunk() && write_chunk_table();
+  outstream = 0;
+  return success;
+}
+
+LASwritePointFast::LASwritePointFast()
+{
+  outstream = 0;
+  chunk_size = 50000;
+  points_in_chunk = 0;
+  records = 0;
+  column = 0;
+  compressed = 0;
+  hash_table = 0;
+  chunk_table_start_position = -1;
+  number_chunks = 0;
+  alloc_chunks = 0;
+  chunk_points = 0;
+  chunk_bytes = 0;
+}
+
+LASwritePointFast::~LASwritePointFast()
+{
+  if (records) free(records);
+  if (column) free(column);
+  if (compressed) free(compressed);
+  if (hash_table) free(hash_table);
+  if (chunk_points) free(chunk_points);
+  if (chunk_bytes) free(chunk_bytes);
+}
+
+bool LASreadPointFast::setup(const U32 num_items, const LASitem* items)
+{
+  if (!IS_LITTLE_ENDIAN())
+  {
+    fprintf(stderr,"ERROR: fast compression needs a little-endian machine\n");
+    return FALSE;
+  }
+  return layout.setup(num_items, items);
+}
+
+bool LASreadPointFast::init(ByteStreamIn* instream)
+{
+  if (instream == 0) return FALSE;
+  this->instream = instream;
+  I64 chunk_table_start_position;
+  try { instream->get64bitsLE((U8*)&chunk_table_start_position); } catch(...)
+  {
+    fprintf(stderr,"ERROR: reading start of chunk table\n");
+    return FALSE;
+  }
+  chunks_start_position = instream->tell();
+  points_in_chunk = 0;
+  point_in_chunk = 0;
+  current_chunk = U32_MAX;
+  // without a chunk table the points can still be read one after the other
+  if (instream->isSeekable())
+  {
+    if (!read_chunk_table()) fprintf(stderr,"WARNING: cannot read chunk table. seeking disabled\n");
+    instream->seek(chunks_start_position);
+  }
+  return TRUE;
+}
+
+bool LASreadPointFast::read_chunk_table()
+{
+  U32 i, version, points, bytes;
+  I64 chunk_table_start_position;
+  try
+  {
+    instream->seek(chunks_start_position - 8);
+    instream->get64bitsLE((U8*)&chunk_table_start_position);
+    if (chunk_table_start_position == -1)
+    {
+      instream->seekEnd(8);
+      instream->get64bitsLE((U8*)&chunk_table_start_position);
+    }
+    if (chunk_table_start_position < chunks_start_position) return FALSE;
+    instream->seek(chunk_table_start_position);
+    instream->get32bitsLE((U8*)&version);
+    if (version != 0) return FALSE;
+    instream->get32bitsLE((U8*)&number_chunks);
+    chunk_starts = new I64[number_chunks+1];
+    chunk_firsts = new I64[number_chunks+1];
+    chunk_starts[0] = chunks_start_position;
+    chunk_firsts[0] = 0;
+    for (i = 0; i < number_chunks; i++)
+    {
+      instream->get32bitsLE((U8*)&points);
+      instream->get32bitsLE((U8*)&bytes);
+      chunk_firsts[i+1] = chunk_firsts[i] + points;
+      chunk_starts[i+1] = chunk_starts[i] + bytes;
+    }
+  }
+  catch (...)
+  {
+    if (chunk_starts) delete [] chunk_starts;
+    if (chunk_firsts) delete [] chunk_firsts;
+    chunk_starts = 0;
+    chunk_firsts = 0;
+    number_chunks = 0;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+bool LASreadPointFast::read_chunk()
+{
+  U32 i, c, number, size;
+  U32 record_size = layout.record_size;
+  try
+  {
+    instream->get32bitsLE((U8*)&number);
+    if (number == 0) return FALSE;
+    if (number > alloc_points)
+    {
+      if (records) free(records);
+      if (columns) free(columns);
+      records = (U8*)malloc((size_t)number*record_size);
+      columns = (U8*)malloc((size_t)number*record_size);
+      alloc_points = ((records && columns) ? number : 0);
+      if (alloc_points == 0)
+      {
+        fprintf(stderr,"ERROR: cannot allocate buffers for chunk of %u points\n", number);
+        return FALSE;
+      }
+    }
+    if (number > alloc_compressed)
+    {
+      if (compressed) free(compressed);
+      compressed = (U8*)malloc(number);
+      alloc_compressed = (compressed ? number : 0);
+      if (alloc_compressed == 0) return FALSE;
+    }
+    for (c = 0; c < record_size; c++)
+    {
+      U8* column = columns + (size_t)c*number;
+      instream->get32bitsLE((U8*)&size);
+      if (size & LAS_FAST_RAW_COLUMN)
+      {
+        if ((size & ~LAS_FAST_RAW_COLUMN) != number) return FALSE;
+        instream->getBytes(column, number);
+      }
+      else
+      {
+        if (size >= number) return FALSE;
+        instream->getBytes(compressed, size);
+        if (!LASfastCoder::decompress(compressed, size, column, number))
+        {
+          fprintf(stderr,"ERROR: corrupt column %u in chunk %u\n", c, current_chunk+1);
+          return FALSE;
+        }
+      }
+    }
+  }
+  catch (...)
+  {
+    return FALSE;
+  }
+
+  // put the byte columns back into records and undo the deltas
+
+  for (c = 0; c < record_size; c++)
+  {
+    const U8* column = columns + (size_t)c*number;
+    U8* r = records + c;
+    for (i = 0; i < number; i++, r += record_size) *r = column[i];
+  }
+  for (i = 0; i < layout.num_fields; i++)
+  {
+    LASfastCoder::delta_decode(records + layout.field_offsets[i], number, record_size, layout.field_sizes[i]);
+  }
+
+  current_chunk++;
+  points_in_chunk = number;
+  point_in_chunk = 0;
+  return TRUE;
+}
+
+bool LASreadPointFast::seek(const U32 current, const U32 target)
+{
+  if (chunk_starts == 0)
+  {
+    // without a chunk table we can only skip forward
+    if (target < current) return FALSE;
+    U32 skip = target - current;
+    while (skip)
+    {
+      if (point_in_chunk == points_in_chunk)
+      {
+        if (!read_chunk()) return FALSE;
+      }
+      U32 left = points_in_chunk - point_in_chunk;
+      if (left > skip) left = skip;
+      point_in_chunk += left;
+      skip -= left;
+    }
+    return TRUE;
+  }
+  if ((I64)target >= chunk_firsts[number_chunks]) return FALSE;
+  U32 lo = 0, hi = number_chunks;
+  while ((hi - lo) > 1)
+  {
+    U32 mid = (lo + hi) / 2;
+    if (chunk_firsts[mid] <= (I64)target) lo = mid; else hi = mid;
+  }
+  if ((lo != current_chunk) || (points_in_chunk == 0))
+  {
+    if (!instream->seek(chunk_starts[lo])) return FALSE;
+    current_chunk = lo - 1;
+    if (!read_chunk()) return FALSE;
+  }
+  point_in_chunk = (U32)(target - chunk_firsts[lo]);
+  return TRUE;
+}
+
+bool LASreadPointFast::read(U8* const * point)
+{
+  U32 i;
+  if (point_in_chunk == points_in_chunk)
+  {
+    if (!read_chunk()) return FALSE;
+  }
+  const U8* record = records + (size_t)point_in_chunk*layout.record_size;
+  for (i = 0; i < layout.num_items; i++)
+  {
+    memcpy(point[i], record + layout.item_offsets[i], layout.item_sizes[i]);
+  }
+  point_in_chunk++;
+  return TRUE;
+}
+
+bool LASreadPointFast::done()
+{
+  instream = 0;
+  return TRUE;
+}
+
+LASreadPointFast::LASreadPointFast()
+{
+  instream = 0;
+  points_in_chunk = 0;
+  point_in_chunk = 0;
+  records = 0;
+  columns = 0;
+  compressed = 0;
+  alloc_points = 0;
+  alloc_compressed = 0;
+  chunks_start_position = 0;
+  number_chunks = 0;
+  current_chunk = U32_MAX;
+  chunk_starts = 0;
+  chunk_firsts = 0;
+}
+
+LASreadPointFast::~LASreadPointFast()
+{
+  if (records) free(records);
+  if (columns) free(columns);
+  if (compressed) free(compressed);
+  if (chunk_starts) delete [] chunk_starts;
+  if (chunk_firsts) delete [] chunk_firsts;
+}
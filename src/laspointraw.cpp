@@ -0,0 +1,183 @@
+/*
+===============================================================================
+
+  FILE:  laspointraw.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "laspointraw.hpp"
+
+#include <string.h>
+
+// the items of a record have the same layout as the fields of LASpoint:
+//   POINT10        20 bytes  starting at X
+//   GPSTIME11       8 bytes  gps_time
+//   RGB12           6 bytes  rgb
+//   WAVEPACKET13   29 bytes  wavepacket
+// and the sizes are constants so the compiler turns each copy into moves
+
+static void las_unpack_record0(LASpoint* point, const U8* record, const U32 extra)
+{
+  memcpy(&(point->X), record, 20);
+  if (extra) memcpy(point->extra_bytes, record + 20, extra);
+}
+
+static void las_unpack_record1(LASpoint* point, const U8* record, const U32 extra)
+{
+  memcpy(&(point->X), record, 20);
+  memcpy(&(point->gps_time), record + 20, 8);
+  if (extra) memcpy(point->extra_bytes, record + 28, extra);
+}
+
+static void las_unpack_record2(LASpoint* point, const U8* record, const U32 extra)
+{
+  memcpy(&(point->X), record, 20);
+  memcpy(point->rgb, record + 20, 6);
+  if (extra) memcpy(point->extra_bytes, record + 26, extra);
+}
+
+static void las_unpack_record3(LASpoint* point, const U8* record, const U32 extra)
+{
+  memcpy(&(point->X), record, 20);
+  memcpy(&(point->gps_time), record + 20, 8);
+  memcpy(point->rgb, record + 28, 6);
+  if (extra) memcpy(point->extra_bytes, record + 34, extra);
+}
+
+static void las_unpack_record4(LASpoint* point, const U8* record, const U32 extra)
+{
+  memcpy(&(point->X), record, 20);
+  memcpy(&(point->gps_time), record + 20, 8);
+  memcpy(&(point->wavepacket), record + 28, 29);
+  if (extra) memcpy(point->extra_bytes, record + 57, extra);
+}
+
+static void las_unpack_record5(LASpoint* point, const U8* record, const U32 extra)
+{
+  memcpy(&(point->X), record, 20);
+  memcpy(&(point->gps_time), record + 20, 8);
+  memcpy(point->rgb, record + 28, 6);
+  memcpy(&(point->wavepacket), record + 34, 29);
+  if (extra) memcpy(point->extra_bytes, record + 63, extra);
+}
+
+static void las_pack_record0(const LASpoint* point, U8* record, const U32 extra)
+{
+  memcpy(record, &(point->X), 20);
+  if (extra) memcpy(record + 20, point->extra_bytes, extra);
+}
+
+static void las_pack_record1(const LASpoint* point, U8* record, const U32 extra)
+{
+  memcpy(record, &(point->X), 20);
+  memcpy(record + 20, &(point->gps_time), 8);
+  if (extra) memcpy(record + 28, point->extra_bytes, extra);
+}
+
+static void las_pack_record2(const LASpoint* point, U8* record, const U32 extra)
+{
+  memcpy(record, &(point->X), 20);
+  memcpy(record + 20, point->rgb, 6);
+  if (extra) memcpy(record + 26, point->extra_bytes, extra);
+}
+
+static void las_pack_record3(const LASpoint* point, U8* record, const U32 extra)
+{
+  memcpy(record, &(point->X), 20);
+  memcpy(record + 20, &(point->gps_time), 8);
+  memcpy(record + 28, point->rgb, 6);
+  if (extra) memcpy(record + 34, point->extra_bytes, extra);
+}
+
+static void las_pack_record4(const LASpoint* point, U8* record, const U32 extra)
+{
+  memcpy(record, &(point->X), 20);
+  memcpy(record + 20, &(point->gps_time), 8);
+  memcpy(record + 28, &(point->wavepacket), 29);
+  if (extra) memcpy(record + 57, point->extra_bytes, extra);
+}
+
+static void las_pack_record5(const LASpoint* point, U8* record, const U32 extra)
+{
+  memcpy(record, &(point->X), 20);
+  memcpy(record + 20, &(point->gps_time), 8);
+  memcpy(record + 28, point->rgb, 6);
+  memcpy(record + 34, &(point->wavepacket), 29);
+  if (extra) memcpy(record + 63, point->extra_bytes, extra);
+}
+
+bool LASpointRaw::setup(const LASpoint* point, const U8 point_data_format, const U16 point_data_record_length)
+{
+  static const U32 sizes[6] = { 20, 28, 26, 34, 57, 63 };
+  static const LASunpackRecord unpack_records[6] = { las_unpack_record0, las_unpack_record1, las_unpack_record2, las_unpack_record3, las_unpack_record4, las_unpack_record5 };
+  static const LASpackRecord pack_records[6] = { las_pack_record0, las_pack_record1, las_pack_record2, las_pack_record3, las_pack_record4, las_pack_record5 };
+
+  unpack_record = 0;
+  pack_record = 0;
+  if (!IS_LITTLE_ENDIAN() || (point_data_format > 5)) return FALSE;
+  if ((point_data_record_length < sizes[point_data_format]) || (point->total_point_size != point_data_record_length)) return FALSE;
+
+  // the items have to be exactly those of the point format
+
+  U32 i = 0;
+  if ((i == point->num_items) || (point->items[i].type != LASitem::POINT10) || (point->items[i].size != 20)) return FALSE;
+  i++;
+  if ((point_data_format == 1) || (point_data_format >= 3))
+  {
+    if ((i == point->num_items) || (point->items[i].type != LASitem::GPSTIME11) || (point->items[i].size != 8)) return FALSE;
+    i++;
+  }
+  if ((point_data_format == 2) || (point_data_format == 3) || (point_data_format == 5))
+  {
+    if ((i == point->num_items) || (point->items[i].type != LASitem::RGB12) || (point->items[i].size != 6)) return FALSE;
+    i++;
+  }
+  if (point_data_format >= 4)
+  {
+    if ((i == point->num_items) || (point->items[i].type != LASitem::WAVEPACKET13) || (point->items[i].size != 29)) return FALSE;
+    i++;
+  }
+  extra = point_data_record_length - sizes[point_data_format];
+  if (extra)
+  {
+    if ((i == point->num_items) || (point->items[i].type != LASitem::BYTE) || (point->items[i].size != extra)) return FALSE;
+    i++;
+  }
+  if (i != point->num_items) return FALSE;
+
+  record_size = point_data_record_length;
+  unpack_record = unpack_records[point_data_format];
+  pack_record = pack_records[point_data_format];
+  return TRUE;
+}
+
+LASpointRaw::LASpointRaw()
+{
+  record_size = 0;
+  extra = 0;
+  unpack_record = 0;
+  pack_record = 0;
+}
@@ -36,8 +36,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 #include <vector>
+#include <algorithm>
 using namespace std;
 
 typedef vector<I32> my_cell_vector;
@@ -272,9 +278,99 @@ void LASquadtree::get_cell_bounding_box(const I32 cell_index, F32* min, F32* max
   get_cell_bounding_box(level_index, level, min, max);
 }
 
+// interleaves the bits of col and row into a level index (x in the even bits)
+static inline U32 morton_interleave(U32 col, U32 row)
+{
+#ifdef __BMI2__
+  return _pdep_u32(col, 0x55555555) | _pdep_u32(row, 0xAAAAAAAA);
+#else
+  col = (col | (col << 8)) & 0x00FF00FF;
+  col = (col | (col << 4)) & 0x0F0F0F0F;
+  col = (col | (col << 2)) & 0x33333333;
+  col = (col | (col << 1)) & 0x55555555;
+  row = (row | (row << 8)) & 0x00FF00FF;
+  row = (row | (row << 4)) & 0x0F0F0F0F;
+  row = (row | (row << 2)) & 0x33333333;
+  row = (row | (row << 1)) & 0x55555555;
+  return col | (row << 1);
+#endif
+}
+
+// inverse of the above
+static inline void morton_deinterleave(U32 level_index, U32* col, U32* row)
+{
+  U32 c = level_index & 0x55555555;
+  U32 r = (level_index >> 1) & 0x55555555;
+  c = (c | (c >> 1)) & 0x33333333;
+  c = (c | (c >> 2)) & 0x0F0F0F0F;
+  c = (c | (c >> 4)) & 0x00FF00FF;
+  c = (c | (c >> 8)) & 0x0000FFFF;
+  r = (r | (r >> 1)) & 0x33333333;
+  r = (r | (r >> 2)) & 0x0F0F0F0F;
+  r = (r | (r >> 4)) & 0x00FF00FF;
+  r = (r | (r >> 8)) & 0x0000FFFF;
+  *col = c;
+  *row = r;
+}
+
+// quantizes a coordinate to the column (or row) the descent would pick. the first
+// guess can be one off next to a boundary so it is corrected with the exact
+// boundaries. coordinates outside (or NaN) end up where the descent puts them.
+static inline U32 morton_quantize(const F64 v, const F32 bb_min, const F32 bb_max, const F64 unit, const U32 max_cell)
+{
+  if (v < bb_min) return 0;
+  if (!(v < bb_max)) return max_cell;
+  U32 q = (U32)((v - bb_min)/unit);
+  if (q > max_cell) q = max_cell;
+  if (v < (bb_min + q*unit)) q--;
+  else if ((q < max_cell) && (v >= (bb_min + (q+1)*unit))) q++;
+  return q;
+}
+
+// the recursive descent below compares against float midpoints. these are exact
+// (and the descent is nothing but a quantization to the grid of the level) when
+// the bounding box and the finest cell size are multiples of the float spacing
+// at twice the largest coordinate, because then every boundary and every sum of
+// two boundaries is a float.
+void LASquadtree::setup_morton()
+{
+  morton = FALSE;
+  if ((levels > 16) || !(min_x < max_x) || !(min_y < max_y)) return;
+  F64 extent = fabs((F64)min_x);
+  if (fabs((F64)max_x) > extent) extent = fabs((F64)max_x);
+  if (fabs((F64)min_y) > extent) extent = fabs((F64)min_y);
+  if (fabs((F64)max_y) > extent) extent = fabs((F64)max_y);
+  int exponent;
+  frexp(2.0*extent, &exponent);
+  F64 spacing = ldexp(1.0, exponent - 24);
+  F64 unit_x = ((F64)max_x - (F64)min_x)/(1 << levels);
+  F64 unit_y = ((F64)max_y - (F64)min_y)/(1 << levels);
+  if (fmod((F64)min_x, spacing) != 0.0 || fmod((F64)min_y, spacing) != 0.0) return;
+  if (fmod(unit_x, spacing) != 0.0 || fmod(unit_y, spacing) != 0.0) return;
+  morton_levels = levels;
+  morton_min_x = min_x;
+  morton_max_x = max_x;
+  morton_min_y = min_y;
+  morton_max_y = max_y;
+  morton_unit_x = unit_x;
+  morton_unit_y = unit_y;
+  morton = TRUE;
+}
+
+// quantizes x & y to the grid of the level and interleaves the bits
+U32 LASquadtree::get_morton_level_index(const F64 x, const F64 y, const U32 level) const
+{
+  U32 max_cell = (1 << level) - 1;
+  F64 unit_x = morton_unit_x * (1 << (morton_levels - level));
+  F64 unit_y = morton_unit_y * (1 << (morton_levels - level));
+  return morton_interleave(morton_quantize(x, min_x, max_x, unit_x, max_cell), morton_quantize(y, min_y, max_y, unit_y, max_cell));
+}
+
 // returns the (sub-)level index of the cell that x & y fall into at the specified level
 U32 LASquadtree::get_level_index(const F64 x, const F64 y, U32 level) const
 {
+  if (use_morton(level)) return get_morton_level_index(x, y, level);
+
   volatile float cell_mid_x;
   volatile float cell_mid_y;
   float cell_min_x, cell_max_x;
@@ -404,6 +500,45 @@ U32 LASquadtree::get_cell_index(const F64 x, const F64 y) const
   return get_cell_index(x, y, levels);
 }
 
+// returns the indices of the cells that many x & y fall into. the loop without
+// calls or branches on the Morton path is left for the compiler to vectorize.
+void LASquadtree::get_cell_indices(const F64* x, const F64* y, const U32 number, U32* cell_indices) const
+{
+  U32 i;
+  if (!use_morton(levels))
+  {
+    for (i = 0; i < number; i++) cell_indices[i] = get_cell_index(x[i], y[i], levels);
+    return;
+  }
+  U32 offset = (sub_level ? level_offset[sub_level+levels] + (sub_level_index << (levels*2)) : level_offset[levels]);
+  I32 max_cell = (1 << levels) - 1;
+  F64 bb_min_x = min_x;
+  F64 bb_min_y = min_y;
+  F64 unit_x = morton_unit_x;
+  F64 unit_y = morton_unit_y;
+  I32 col, row;
+  F64 qx, qy;
+  for (i = 0; i < number; i++)
+  {
+    qx = (x[i] - bb_min_x)/unit_x;
+    qy = (y[i] - bb_min_y)/unit_y;
+    // NaN coordinates go right (like in the descent) and are clamped below
+    qx = (qx == qx ? qx : max_cell);
+    qy = (qy == qy ? qy : max_cell);
+    qx = (qx < 0.0 ? 0.0 : (qx > max_cell ? max_cell : qx));
+    qy = (qy < 0.0 ? 0.0 : (qy > max_cell ? max_cell : qy));
+    col = (I32)qx;
+    row = (I32)qy;
+    col -= (x[i] < (bb_min_x + col*unit_x) ? 1 : 0);
+    col += ((col < max_cell) && (x[i] >= (bb_min_x + (col+1)*unit_x)) ? 1 : 0);
+    row -= (y[i] < (bb_min_y + row*unit_y) ? 1 : 0);
+    row += ((row < max_cell) && (y[i] >= (bb_min_y + (row+1)*unit_y)) ? 1 : 0);
+    col = (col < 0 ? 0 : col);
+    row = (row < 0 ? 0 : row);
+    cell_indices[i] = offset + morton_interleave((U32)col, (U32)row);
+  }
+}
+
 // returns the indices of parent and siblings for the specified cell index
 bool LASquadtree::coarsen(const I32 cell_index, I32* coarser_cell_index, U32* num_cell_indices, I32** cell_indices) const
 {
@@ -644,6 +779,7 @@ bool LASquadtree::read(ByteStreamIn* stream)
     fprintf(stderr,"ERROR (LASquadtree): reading max_y\n");
     return FALSE;
   }
+  setup_morton();
   return TRUE;
 }
 
@@ -771,13 +907,9 @@ U32 LASquadtree::intersect_rectangle(const F64 r_min_x, const F64 r_min_y, const
     return 0;
   }
 
-  if (adaptive)
-  {
-    intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, min_x, max_x, min_y, max_y, 0, 0);
-  }
-  else
+  if (!intersect_with_ranges(r_min_x, r_min_y, r_max_x, r_max_y, 0, level))
   {
-    intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, min_x, max_x, min_y, max_y, level, 0);
+    intersect_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, 0, level);
   }
 
   return (U32)(((my_cell_vector*)current_cells)->size());
@@ -807,13 +939,9 @@ U32 LASquadtree::intersect_tile(const F32 ll_x, const F32 ll_y, const F32 size,
     return 0;
   }
 
-  if (adaptive)
-  {
-    intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, min_x, max_x, min_y, max_y, 0, 0);
-  }
-  else
+  if (!intersect_with_ranges(ll_x, ll_y, ur_x, ur_y, 0, level))
   {
-    intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, min_x, max_x, min_y, max_y, level, 0);
+    intersect_with_cells(ll_x, ll_y, ur_x, ur_y, 0, level);
   }
 
   return (U32)(((my_cell_vector*)current_cells)->size());
@@ -845,13 +973,14 @@ U32 LASquadtree::intersect_circle(const F64 center_x, const F64 center_y, const
     return 0;
   }
 
-  if (adaptive)
-  {
-    intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, min_x, max_x, min_y, max_y, 0, 0);
-  }
-  else
+  F64 circle[3];
+  circle[0] = center_x;
+  circle[1] = center_y;
+  circle[2] = radius;
+
+  if (!intersect_with_ranges(r_min_x, r_min_y, r_max_x, r_max_y, circle, level))
   {
-    intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, min_x, max_x, min_y, max_y, level, 0);
+    intersect_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, circle, level);
   }
 
   return (U32)(((my_cell_vector*)current_cells)->size());
@@ -862,517 +991,249 @@ U32 LASquadtree::intersect_circle(const F64 center_x, const F64 center_y, const
   return intersect_circle(center_x, center_y, radius, levels);
 }
 
-void LASquadtree::intersect_rectangle_with_cells(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index)
+// a cell waiting on the explicit stack of the traversals below
+typedef struct LASquadtreeStackCell
 {
-  volatile float cell_mid_x;
-  volatile float cell_mid_y;
-  if (level)
-  {
-    level--;
-    level_index <<= 2;
-
-    cell_mid_x = (cell_min_x + cell_max_x)/2;
-    cell_mid_y = (cell_min_y + cell_max_y)/2;
+  F32 min_x;
+  F32 max_x;
+  F32 min_y;
+  F32 max_y;
+  U32 level;
+  U32 level_index;
+} LASquadtreeStackCell;
 
-    if (r_max_x <= cell_mid_x)
-    {
-      // cell_max_x = cell_mid_x;
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-      else
-      {
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-    }
-    else if (!(r_min_x < cell_mid_x))
-    {
-      // cell_min_x = cell_mid_x;
-      // level_index |= 1;
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-    }
-    else
-    {
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_rectangle_with_cells(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-    }
-  }
-  else
-  {
-    ((my_cell_vector*)current_cells)->push_back(level_index);
-  }
-}
+// at most three siblings wait per level so this suffices for all 24 levels
+#define LAS_QUADTREE_STACK_SIZE 128
 
-void LASquadtree::intersect_rectangle_with_cells_adaptive(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index)
+// iterative version of the former recursive descent. a cell is split at the float
+// midpoints and the children that overlap the query are visited in index order.
+// for the adaptive quadtree levels count up from the root and the leafs report
+// their cell index, otherwise they count down to zero and report the level index.
+void LASquadtree::intersect_with_cells(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F64* circle, U32 level)
 {
+  my_cell_vector* cells = (my_cell_vector*)current_cells;
+  LASquadtreeStackCell stack[LAS_QUADTREE_STACK_SIZE];
+  LASquadtreeStackCell cell;
   volatile float cell_mid_x;
   volatile float cell_mid_y;
-  U32 cell_index = get_cell_index(level_index, level);
-  U32 adaptive_pos = cell_index/32;
-  U32 adaptive_bit = ((U32)1) << (cell_index%32);
-  if ((level < levels) && (adaptive[adaptive_pos] & adaptive_bit))
-  {
-    level++;
-    level_index <<= 2;
+  U32 cell_index, adaptive_pos, adaptive_bit;
+  bool left, right, bottom, top;
+  I32 top_of_stack = 0;
 
-    cell_mid_x = (cell_min_x + cell_max_x)/2;
-    cell_mid_y = (cell_min_y + cell_max_y)/2;
+  stack[0].min_x = min_x;
+  stack[0].max_x = max_x;
+  stack[0].min_y = min_y;
+  stack[0].max_y = max_y;
+  stack[0].level = (adaptive ? 0 : level);
+  stack[0].level_index = 0;
 
-    if (r_max_x <= cell_mid_x)
-    {
-      // cell_max_x = cell_mid_x;
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-      else
-      {
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-    }
-    else if (!(r_min_x < cell_mid_x))
+  while (top_of_stack >= 0)
+  {
+    cell = stack[top_of_stack];
+    top_of_stack--;
+
+    if (adaptive)
     {
-      // cell_min_x = cell_mid_x;
-      // level_index |= 1;
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
+      cell_index = get_cell_index(cell.level_index, cell.level);
+      adaptive_pos = cell_index/32;
+      adaptive_bit = ((U32)1) << (cell_index%32);
+      if ((cell.level >= levels) || (adaptive_pos >= adaptive_alloc) || !(adaptive[adaptive_pos] & adaptive_bit))
       {
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
+        if ((circle == 0) || intersect_circle_with_rectangle(circle[0], circle[1], circle[2], cell.min_x, cell.max_x, cell.min_y, cell.max_y))
+        {
+          cells->push_back(cell_index);
+        }
+        continue;
       }
+      cell.level++;
     }
     else
     {
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
+      if (cell.level == 0)
       {
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_rectangle_with_cells_adaptive(r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
+        if ((circle == 0) || intersect_circle_with_rectangle(circle[0], circle[1], circle[2], cell.min_x, cell.max_x, cell.min_y, cell.max_y))
+        {
+          cells->push_back(cell.level_index);
+        }
+        continue;
       }
+      cell.level--;
     }
-  }
-  else
-  {
-    ((my_cell_vector*)current_cells)->push_back(cell_index);
-  }
-}
+    cell.level_index <<= 2;
 
-void LASquadtree::intersect_tile_with_cells(const F32 ll_x, const F32 ll_y, const F32 ur_x, const F32 ur_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index)
-{
-  volatile float cell_mid_x;
-  volatile float cell_mid_y;
-  if (level)
-  {
-    level--;
-    level_index <<= 2;
-
-    cell_mid_x = (cell_min_x + cell_max_x)/2;
-    cell_mid_y = (cell_min_y + cell_max_y)/2;
+    cell_mid_x = (cell.min_x + cell.max_x)/2;
+    cell_mid_y = (cell.min_y + cell.max_y)/2;
 
-    if (ur_x <= cell_mid_x)
+    if (r_max_x <= cell_mid_x)
     {
-      // cell_max_x = cell_mid_x;
-      if (ur_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-      }
-      else if (!(ll_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-      else
-      {
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
+      left = TRUE;
+      right = FALSE;
     }
-    else if (!(ll_x < cell_mid_x))
+    else if (!(r_min_x < cell_mid_x))
     {
-      // cell_min_x = cell_mid_x;
-      // level_index |= 1;
-      if (ur_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(ll_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
+      left = FALSE;
+      right = TRUE;
     }
     else
     {
-      if (ur_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(ll_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_tile_with_cells(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
+      left = TRUE;
+      right = TRUE;
     }
-  }
-  else
-  {
-    ((my_cell_vector*)current_cells)->push_back(level_index);
-  }
-}
-
-void LASquadtree::intersect_tile_with_cells_adaptive(const F32 ll_x, const F32 ll_y, const F32 ur_x, const F32 ur_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index)
-{
-  volatile float cell_mid_x;
-  volatile float cell_mid_y;
-  U32 cell_index = get_cell_index(level_index, level);
-  U32 adaptive_pos = cell_index/32;
-  U32 adaptive_bit = ((U32)1) << (cell_index%32);
-  if ((level < levels) && (adaptive[adaptive_pos] & adaptive_bit))
-  {
-    level++;
-    level_index <<= 2;
-
-    cell_mid_x = (cell_min_x + cell_max_x)/2;
-    cell_mid_y = (cell_min_y + cell_max_y)/2;
-
-    if (ur_x <= cell_mid_x)
+    if (r_max_y <= cell_mid_y)
     {
-      // cell_max_x = cell_mid_x;
-      if (ur_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-      }
-      else if (!(ll_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-      else
-      {
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
+      bottom = TRUE;
+      top = FALSE;
     }
-    else if (!(ll_x < cell_mid_x))
+    else if (!(r_min_y < cell_mid_y))
     {
-      // cell_min_x = cell_mid_x;
-      // level_index |= 1;
-      if (ur_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(ll_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
+      bottom = FALSE;
+      top = TRUE;
     }
     else
     {
-      if (ur_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(ll_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_tile_with_cells_adaptive(ll_x, ll_y, ur_x, ur_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
+      bottom = TRUE;
+      top = TRUE;
     }
-  }
-  else
-  {
-    ((my_cell_vector*)current_cells)->push_back(cell_index);
-  }
-}
-
-void LASquadtree::intersect_circle_with_cells(const F64 center_x, const F64 center_y, const F64 radius, const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index)
-{
-  volatile float cell_mid_x;
-  volatile float cell_mid_y;
-  if (level)
-  {
-    level--;
-    level_index <<= 2;
-
-    cell_mid_x = (cell_min_x + cell_max_x)/2;
-    cell_mid_y = (cell_min_y + cell_max_y)/2;
 
-    if (r_max_x <= cell_mid_x)
+    // push in reverse so that the children come off the stack in index order
+    if (top && right)
     {
-      // cell_max_x = cell_mid_x;
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-      else
-      {
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
+      top_of_stack++;
+      stack[top_of_stack].min_x = cell_mid_x;
+      stack[top_of_stack].max_x = cell.max_x;
+      stack[top_of_stack].min_y = cell_mid_y;
+      stack[top_of_stack].max_y = cell.max_y;
+      stack[top_of_stack].level = cell.level;
+      stack[top_of_stack].level_index = cell.level_index | 3;
     }
-    else if (!(r_min_x < cell_mid_x))
+    if (top && left)
     {
-      // cell_min_x = cell_mid_x;
-      // level_index |= 1;
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
+      top_of_stack++;
+      stack[top_of_stack].min_x = cell.min_x;
+      stack[top_of_stack].max_x = cell_mid_x;
+      stack[top_of_stack].min_y = cell_mid_y;
+      stack[top_of_stack].max_y = cell.max_y;
+      stack[top_of_stack].level = cell.level;
+      stack[top_of_stack].level_index = cell.level_index | 2;
     }
-    else
+    if (bottom && right)
     {
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_circle_with_cells(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
+      top_of_stack++;
+      stack[top_of_stack].min_x = cell_mid_x;
+      stack[top_of_stack].max_x = cell.max_x;
+      stack[top_of_stack].min_y = cell.min_y;
+      stack[top_of_stack].max_y = cell_mid_y;
+      stack[top_of_stack].level = cell.level;
+      stack[top_of_stack].level_index = cell.level_index | 1;
     }
-  }
-  else
-  {
-    if (intersect_circle_with_rectangle(center_x, center_y, radius, cell_min_x, cell_max_x, cell_min_y, cell_max_y))
+    if (bottom && left)
     {
-      ((my_cell_vector*)current_cells)->push_back(level_index);
+      top_of_stack++;
+      stack[top_of_stack].min_x = cell.min_x;
+      stack[top_of_stack].max_x = cell_mid_x;
+      stack[top_of_stack].min_y = cell.min_y;
+      stack[top_of_stack].max_y = cell_mid_y;
+      stack[top_of_stack].level = cell.level;
+      stack[top_of_stack].level_index = cell.level_index;
     }
   }
 }
 
-void LASquadtree::intersect_circle_with_cells_adaptive(const F64 center_x, const F64 center_y, const F64 radius, const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F32 cell_min_x, const F32 cell_max_x, const F32 cell_min_y, const F32 cell_max_y, U32 level, U32 level_index)
+// when the cell boundaries are exact (see setup_morton) the columns and rows that
+// the descent above reaches at the finest level are simply the ranges between
+// the quantized corners of the query. a query with an empty (or NaN) extent is
+// left to the descent as it treats these slightly differently.
+bool LASquadtree::intersect_with_ranges(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const F64* circle, U32 level)
 {
-  volatile float cell_mid_x;
-  volatile float cell_mid_y;
-  U32 cell_index = get_cell_index(level_index, level);
-  U32 adaptive_pos = cell_index/32;
-  U32 adaptive_bit = ((U32)1) << (cell_index%32);
-  if ((level < levels) && (adaptive[adaptive_pos] & adaptive_bit))
+  U32 range_level = (adaptive ? levels : level);
+  if (!use_morton(range_level)) return FALSE;
+  if (!(r_min_x < r_max_x) || !(r_min_y < r_max_y)) return FALSE;
+
+  my_cell_vector* cells = (my_cell_vector*)current_cells;
+  U32 max_cell = (1 << range_level) - 1;
+  F64 unit_x = morton_unit_x * (1 << (morton_levels - range_level));
+  F64 unit_y = morton_unit_y * (1 << (morton_levels - range_level));
+
+  // a query ending exactly on a boundary does not reach into the next cell
+  U32 col_lo = morton_quantize(r_min_x, min_x, max_x, unit_x, max_cell);
+  U32 col_hi = morton_quantize(r_max_x, min_x, max_x, unit_x, max_cell);
+  if (col_hi && (r_max_x == (min_x + col_hi*unit_x))) col_hi--;
+  U32 row_lo = morton_quantize(r_min_y, min_y, max_y, unit_y, max_cell);
+  U32 row_hi = morton_quantize(r_max_y, min_y, max_y, unit_y, max_cell);
+  if (row_hi && (r_max_y == (min_y + row_hi*unit_y))) row_hi--;
+
+  U32 col, row, size;
+  F32 cell_min_x, cell_max_x, cell_min_y, cell_max_y;
+
+  if (adaptive)
   {
-    level++;
-    level_index <<= 2;
+    // only descend into the children whose columns and rows overlap the ranges
+    LASquadtreeStackCell stack[LAS_QUADTREE_STACK_SIZE];
+    LASquadtreeStackCell cell;
+    U32 cell_index, adaptive_pos, adaptive_bit, child;
+    I32 top_of_stack = 0;
 
-    cell_mid_x = (cell_min_x + cell_max_x)/2;
-    cell_mid_y = (cell_min_y + cell_max_y)/2;
+    stack[0].level = 0;
+    stack[0].level_index = 0;
 
-    if (r_max_x <= cell_mid_x)
-    {
-      // cell_max_x = cell_mid_x;
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-      else
-      {
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-      }
-    }
-    else if (!(r_min_x < cell_mid_x))
-    {
-      // cell_min_x = cell_mid_x;
-      // level_index |= 1;
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(r_min_y < cell_mid_y))
-      {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-      else
-      {
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
-      }
-    }
-    else
+    while (top_of_stack >= 0)
     {
-      if (r_max_y <= cell_mid_y)
-      {
-        // cell_max_y = cell_mid_y;
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-      }
-      else if (!(r_min_y < cell_mid_y))
+      cell = stack[top_of_stack];
+      top_of_stack--;
+
+      cell_index = get_cell_index(cell.level_index, cell.level);
+      adaptive_pos = cell_index/32;
+      adaptive_bit = ((U32)1) << (cell_index%32);
+      if ((cell.level >= levels) || (adaptive_pos >= adaptive_alloc) || !(adaptive[adaptive_pos] & adaptive_bit))
       {
-        // cell_min_y = cell_mid_y;
-        // level_index |= 1;
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
+        if (circle)
+        {
+          size = 1 << (range_level - cell.level);
+          morton_deinterleave(cell.level_index, &col, &row);
+          cell_min_x = (F32)(min_x + (col*size)*unit_x);
+          cell_max_x = (F32)(min_x + ((col+1)*size)*unit_x);
+          cell_min_y = (F32)(min_y + (row*size)*unit_y);
+          cell_max_y = (F32)(min_y + ((row+1)*size)*unit_y);
+          if (!intersect_circle_with_rectangle(circle[0], circle[1], circle[2], cell_min_x, cell_max_x, cell_min_y, cell_max_y)) continue;
+        }
+        cells->push_back(cell_index);
+        continue;
       }
-      else
+
+      size = 1 << (range_level - cell.level - 1);
+      child = 4;
+      while (child)
       {
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_min_y, cell_mid_y, level, level_index);
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_min_y, cell_mid_y, level, level_index | 1);
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_min_x, cell_mid_x, cell_mid_y, cell_max_y, level, level_index | 2);
-        intersect_circle_with_cells_adaptive(center_x, center_y, radius, r_min_x, r_min_y, r_max_x, r_max_y, cell_mid_x, cell_max_x, cell_mid_y, cell_max_y, level, level_index | 3);
+        child--;
+        morton_deinterleave((cell.level_index << 2) | child, &col, &row);
+        if ((col*size > col_hi) || ((col+1)*size <= col_lo) || (row*size > row_hi) || ((row+1)*size <= row_lo)) continue;
+        top_of_stack++;
+        stack[top_of_stack].level = cell.level + 1;
+        stack[top_of_stack].level_index = (cell.level_index << 2) | child;
       }
     }
   }
   else
   {
-    if (intersect_circle_with_rectangle(center_x, center_y, radius, cell_min_x, cell_max_x, cell_min_y, cell_max_y))
+    for (row = row_lo; row <= row_hi; row++)
     {
-      ((my_cell_vector*)current_cells)->push_back(cell_index);
+      for (col = col_lo; col <= col_hi; col++)
+      {
+        if (circle)
+        {
+          cell_min_x = (F32)(min_x + col*unit_x);
+          cell_max_x = (F32)(min_x + (col+1)*unit_x);
+          cell_min_y = (F32)(min_y + row*unit_y);
+          cell_max_y = (F32)(min_y + (row+1)*unit_y);
+          if (!intersect_circle_with_rectangle(circle[0], circle[1], circle[2], cell_min_x, cell_max_x, cell_min_y, cell_max_y)) continue;
+        }
+        cells->push_back(morton_interleave(col, row));
+      }
     }
+    // same order in which the descent would have reported them
+    sort(cells->begin(), cells->end());
   }
+  return TRUE;
 }
 
 bool LASquadtree::intersect_circle_with_rectangle(const F64 center_x, const F64 center_y, const F64 radius, const F32 r_min_x, const F32 r_max_x, const F32 r_min_y, const F32 r_max_y)
@@ -1524,6 +1385,7 @@ bool LASquadtree::setup(F64 bb_min_x, F64 bb_max_x, F64 bb_min_y, F64 bb_max_y,
   min_y -= (c2 * cell_size);
   max_y += (c1 * cell_size);
 
+  setup_morton();
   return TRUE;
 }
 
@@ -1575,6 +1437,7 @@ bool LASquadtree::setup(F64 bb_min_x, F64 bb_max_x, F64 bb_min_y, F64 bb_max_y,
   min_y -= (c2 * cell_size);
   max_y += (c1 * cell_size);
 
+  setup_morton();
   return TRUE;
 }
 
@@ -1587,6 +1450,7 @@ bool LASquadtree::tiling_setup(F32 min_x, F32 max_x, F32 min_y, F32 max_y, U32 l
   this->levels = levels;
   this->sub_level = 0;
   this->sub_level_index = 0;
+  setup_morton();
   return TRUE;
 }
 
@@ -1606,6 +1470,7 @@ bool LASquadtree::subtiling_setup(F32 min_x, F32 max_x, F32 min_y, F32 max_y, U3
   this->sub_level = sub_level;
   this->sub_level_index = sub_level_index;
   this->levels = levels;
+  setup_morton();
   return TRUE;
 }
 
@@ -1630,6 +1495,7 @@ LASquadtree::LASquadtree()
   current_cells = 0;
   adaptive_alloc = 0;
   adaptive = 0;
+  morton = FALSE;
 }
 
 LASquadtree::~LASquadtree()
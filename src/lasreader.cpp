@@ -31,11 +31,15 @@
 #include "lasreader.hpp"
 
 #include "lasindex.hpp"
+#include "lascatalog.hpp"
+#include "lasquadtree.hpp"
+#include "lasrtree.hpp"
 #include "lasfilter.hpp"
 #include "lastransform.hpp"
 
 #include "lasreader_las.hpp"
 #include "lasreader_bin.hpp"
+#include "lasreader_col.hpp"
 #include "lasreader_shp.hpp"
 #include "lasreader_qfit.hpp"
 #include "lasreader_asc.hpp"
@@ -49,6 +53,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+
 LASreader::LASreader()
 {
   npoints = 0;
@@ -76,17 +82,122 @@ LASreader::LASreader()
   orig_min_y = 0;
   orig_max_x = 0;
   orig_max_y = 0;
+  auto_lasindex = 0;
+  auto_lasindex_file_name = 0;
+  auto_lasindex_directory = 0;
+  auto_lasindex_count = 0;
+  read_ahead = 0;
+  read_coalesce = 0;
+  preview = 0;
 }
   
 LASreader::~LASreader()
 {
   if (index) delete index;
+  if (auto_lasindex) delete auto_lasindex;
+  if (auto_lasindex_file_name) free(auto_lasindex_file_name);
+  if (auto_lasindex_directory) free(auto_lasindex_directory);
 }
 
 void LASreader::set_index(LASindex* index)
 {
   if (this->index) delete this->index;
   this->index = index;
+  if (index && (read_ahead || read_coalesce)) index->set_read_ahead(read_ahead, read_coalesce);
+}
+
+void LASreader::set_read_ahead(const U32 intervals, const U32 coalesce_bytes)
+{
+  read_ahead = intervals;
+  read_coalesce = coalesce_bytes;
+  if (index) index->set_read_ahead(read_ahead, read_coalesce);
+}
+
+void LASreader::set_preview(const U32 point_budget)
+{
+  preview = point_budget;
+  if (index == 0) return;
+  index->set_preview(preview);
+  if (inside) return;
+  // without a spatial query the preview needs the cells of the whole file
+  if (preview && index->intersect_rectangle(header.min_x, header.min_y, header.max_x, header.max_y))
+  {
+    if (filter || transform)
+    {
+      read_complex = &LASreader::read_point_preview_indexed;
+    }
+    else
+    {
+      read_simple = &LASreader::read_point_preview_indexed;
+    }
+  }
+  else
+  {
+    if (filter || transform)
+    {
+      read_complex = &LASreader::read_point_default;
+    }
+    else
+    {
+      read_simple = &LASreader::read_point_default;
+    }
+  }
+}
+
+void LASreader::set_auto_index(const CHAR* file_name, const CHAR* directory)
+{
+  if (auto_lasindex_file_name) free(auto_lasindex_file_name);
+  auto_lasindex_file_name = (file_name ? strdup(file_name) : 0);
+  if (auto_lasindex_directory) free(auto_lasindex_directory);
+  auto_lasindex_directory = (directory ? strdup(directory) : 0);
+}
+
+bool LASreader::prepare_auto_index()
+{
+  if (auto_lasindex) 
+  {
+    delete auto_lasindex;
+    auto_lasindex = 0;
+  }
+  // only a scan that starts with the first point can visit every point
+  if ((auto_lasindex_file_name == 0) || (p_count != 0) || (npoints == 0) || (npoints > U32_MAX)) return FALSE;
+  // same default tile size as the lasindex tool 
+  F64 w = orig_max_x - orig_min_x;
+  F64 h = orig_max_y - orig_min_y;
+  F32 t;
+  if ((w < 1000) && (h < 1000))
+    t = 10.0f;
+  else if ((w < 10000) && (h < 10000))
+    t = 100.0f;
+  else if ((w < 100000) && (h < 100000))
+    t = 1000.0f;
+  else if ((w < 1000000) && (h < 1000000))
+    t = 10000.0f;
+  else
+    t = 100000.0f;
+  LASquadtree* lasquadtree = new LASquadtree;
+  lasquadtree->setup(orig_min_x, orig_max_x, orig_min_y, orig_max_y, t);
+  auto_lasindex = new LASindex;
+  auto_lasindex->prepare(lasquadtree, 1000);
+  auto_lasindex_count = 0;
+  return TRUE;
+}
+
+void LASreader::complete_auto_index()
+{
+  if (auto_lasindex == 0) return;
+  // a seek during the scan means some points were never added
+  if (auto_lasindex_count == npoints)
+  {
+    auto_lasindex->complete(100000, -20);
+    auto_lasindex->write(auto_lasindex_file_name, auto_lasindex_directory);
+    set_index(auto_lasindex);
+  }
+  else
+  {
+    delete auto_lasindex;
+  }
+  auto_lasindex = 0;
 }
 
 void LASreader::set_filter(LASfilter* filter)
@@ -151,6 +262,11 @@ bool LASreader::inside_none()
     header.max_y = orig_max_y;
     inside = 0;
   }
+  if (auto_lasindex)
+  {
+    delete auto_lasindex;
+    auto_lasindex = 0;
+  }
   return TRUE;
 }
 
@@ -190,6 +306,10 @@ bool LASreader::inside_tile(const F32 ll_x, const F32 ll_y, const F32 size)
       if (index) index->intersect_tile(ll_x, ll_y, size);
       read_complex = &LASreader::read_point_inside_tile_indexed;
     }
+    else if (prepare_auto_index())
+    {
+      read_complex = &LASreader::read_point_inside_tile_auto_indexed;
+    }
     else
     {
       read_complex = &LASreader::read_point_inside_tile;
@@ -202,6 +322,10 @@ bool LASreader::inside_tile(const F32 ll_x, const F32 ll_y, const F32 size)
       if (index) index->intersect_tile(ll_x, ll_y, size);
       read_simple = &LASreader::read_point_inside_tile_indexed;
     }
+    else if (prepare_auto_index())
+    {
+      read_simple = &LASreader::read_point_inside_tile_auto_indexed;
+    }
     else
     {
       read_simple = &LASreader::read_point_inside_tile;
@@ -243,6 +367,10 @@ bool LASreader::inside_circle(const F64 center_x, const F64 center_y, const F64
       if (index) index->intersect_circle(center_x, center_y, radius);
       read_complex = &LASreader::read_point_inside_circle_indexed;
     }
+    else if (prepare_auto_index())
+    {
+      read_complex = &LASreader::read_point_inside_circle_auto_indexed;
+    }
     else
     {
       read_complex = &LASreader::read_point_inside_circle;
@@ -255,6 +383,10 @@ bool LASreader::inside_circle(const F64 center_x, const F64 center_y, const F64
       if (index) index->intersect_circle(center_x, center_y, radius);
       read_simple = &LASreader::read_point_inside_circle_indexed;
     }
+    else if (prepare_auto_index())
+    {
+      read_simple = &LASreader::read_point_inside_circle_auto_indexed;
+    }
     else
     {
       read_simple = &LASreader::read_point_inside_circle;
@@ -296,6 +428,10 @@ bool LASreader::inside_rectangle(const F64 min_x, const F64 min_y, const F64 max
       index->intersect_rectangle(min_x, min_y, max_x, max_y);
       read_complex = &LASreader::read_point_inside_rectangle_indexed;
     }
+    else if (prepare_auto_index())
+    {
+      read_complex = &LASreader::read_point_inside_rectangle_auto_indexed;
+    }
     else
     {
       read_complex = &LASreader::read_point_inside_rectangle;
@@ -308,6 +444,10 @@ bool LASreader::inside_rectangle(const F64 min_x, const F64 min_y, const F64 max
       index->intersect_rectangle(min_x, min_y, max_x, max_y);
       read_simple = &LASreader::read_point_inside_rectangle_indexed;
     }
+    else if (prepare_auto_index())
+    {
+      read_simple = &LASreader::read_point_inside_rectangle_auto_indexed;
+    }
     else
     {
       read_simple = &LASreader::read_point_inside_rectangle;
@@ -370,6 +510,48 @@ bool LASreader::read_point_inside_rectangle_indexed()
   return FALSE;
 }
 
+bool LASreader::read_point_preview_indexed()
+{
+  while (index->seek_next((LASreader*)this))
+  {
+    if (read_point_default()) return TRUE;
+  }
+  return FALSE;
+}
+
+bool LASreader::read_point_inside_tile_auto_indexed()
+{
+  while (read_point_default())
+  {
+    if (auto_lasindex && (auto_lasindex_count == (p_count-1))) auto_lasindex->add(&point, auto_lasindex_count++);
+    if (point.inside_tile(t_ll_x, t_ll_y, t_ur_x, t_ur_y)) return TRUE;
+  }
+  complete_auto_index();
+  return FALSE;
+}
+
+bool LASreader::read_point_inside_circle_auto_indexed()
+{
+  while (read_point_default())
+  {
+    if (auto_lasindex && (auto_lasindex_count == (p_count-1))) auto_lasindex->add(&point, auto_lasindex_count++);
+    if (point.inside_circle(c_center_x, c_center_y, c_radius_squared)) return TRUE;
+  }
+  complete_auto_index();
+  return FALSE;
+}
+
+bool LASreader::read_point_inside_rectangle_auto_indexed()
+{
+  while (read_point_default())
+  {
+    if (auto_lasindex && (auto_lasindex_count == (p_count-1))) auto_lasindex->add(&point, auto_lasindex_count++);
+    if (point.inside_rectangle(r_min_x, r_min_y, r_max_x, r_max_y)) return TRUE;
+  }
+  complete_auto_index();
+  return FALSE;
+}
+
 bool LASreader::read_point_none()
 {
   return FALSE;
@@ -434,18 +616,34 @@ I32 LASreadOpener::unparse_inside(CHAR* string) const
 
 bool LASreadOpener::is_buffered() const
 {
-  return ((buffer_size > 0) && ((file_name_number > 1) || (neighbor_file_name_number > 0)));
+  if (buffer_size <= 0) return FALSE;
+  if ((file_name_number > 1) || (neighbor_file_name_number > 0)) return TRUE;
+  // a single tile is only buffered when it can find its neighbors
+  return ((file_name_number == 1) && has_lastiling(file_names[0]));
+}
+
+bool LASreadOpener::has_lastiling(const CHAR* file_name) const
+{
+  if (file_name != lastiling_file_name)
+  {
+    LASreaderLAS lasreaderlas;
+    ((LASreadOpener*)this)->lastiling_found = (lasreaderlas.open(file_name) && (lasreaderlas.header.vlr_lastiling != 0));
+    lasreaderlas.close();
+    ((LASreadOpener*)this)->lastiling_file_name = file_name;
+  }
+  return lastiling_found;
 }
 
 bool LASreadOpener::is_header_populated() const
 {
-  return (populate_header || (file_name && (strstr(file_name, ".las") || strstr(file_name, ".laz") || strstr(file_name, ".LAS") || strstr(file_name, ".LAZ"))));
+  return (populate_header || (file_name && (strstr(file_name, ".las") || strstr(file_name, ".laz") || strstr(file_name, ".LAS") || strstr(file_name, ".LAZ") || strstr(file_name, ".laf") || strstr(file_name, ".LAF") || strstr(file_name, ".lac") || strstr(file_name, ".LAC"))));
 }
 
 void LASreadOpener::reset()
 {
   file_name_current = 0;
   file_name = 0;
+  file_release_next = 0;
 }
 
 LASreader* LASreadOpener::open(const CHAR* other_file_name)
@@ -465,6 +663,15 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
       lasreadermerged->set_skip_lines(skip_lines);
       lasreadermerged->set_populate_header(populate_header);
       lasreadermerged->set_keep_lastiling(keep_lastiling);
+      lasreadermerged->set_auto_index(auto_index);
+      lasreadermerged->set_auto_index_directory(auto_index_directory);
+      lasreadermerged->set_read_ahead(read_ahead, read_coalesce);
+      lasreadermerged->set_peek_threads(peek_threads);
+      lasreadermerged->set_prefetch_files(prefetch_files);
+      lasreadermerged->set_interleave(interleave);
+      lasreadermerged->set_gps_time_merge(gps_time_merge, gps_time_check);
+      lasreadermerged->set_catalog(catalog);
+      lasreadermerged->set_write_catalog(write_catalog);
       lasreadermerged->set_translate_intensity(translate_intensity);
       lasreadermerged->set_scale_intensity(scale_intensity);
       lasreadermerged->set_translate_scan_angle(translate_scan_angle);
@@ -484,9 +691,11 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
       if (inside_tile) lasreadermerged->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
       if (inside_circle) lasreadermerged->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
       if (inside_rectangle) lasreadermerged->inside_rectangle(inside_rectangle[0], inside_rectangle[1], inside_rectangle[2], inside_rectangle[3]);
+      if (preview) fprintf(stderr,"WARNING: '-preview' only works for single files and reads all merged points\n");
       if (pipe_on)
       {
         LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+        lasreaderpipeon->set_shared_pipe(pipe_on_shared);
         if (!lasreaderpipeon->open(lasreadermerged))
         {
           fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreadermerged\n");
@@ -500,9 +709,14 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
         return lasreadermerged;
       }
     }
-    else if ((buffer_size > 0) && ((file_name_number > 1) || (neighbor_file_name_number > 0)))
+    else if (is_buffered())
     {
       U32 i;
+      if (buffered_cache)
+      {
+        LASreaderBuffered::set_cache_budget((I64)buffered_cache*1024*1024);
+        if ((file_name_current == 0) && (file_last_use == 0)) schedule_buffered_tiles();
+      }
       if (other_file_name)
       {
         file_name = other_file_name;
@@ -512,6 +726,15 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
       {
         file_name = file_names[file_name_current];
         file_name_current++;
+        if (file_release)
+        {
+          // neighbors that no later tile needs are dropped from the cache
+          while ((file_release_next < file_name_number) && (file_last_use[file_release[file_release_next]] < file_name_current-1))
+          {
+            LASreaderBuffered::release_cached(file_names[file_release[file_release_next]]);
+            file_release_next++;
+          }
+        }
       }
       LASreaderBuffered* lasreaderbuffered = new LASreaderBuffered();
       lasreaderbuffered->set_buffer_size(buffer_size);
@@ -525,6 +748,8 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
       lasreaderbuffered->set_translate_scan_angle(translate_scan_angle);
       lasreaderbuffered->set_scale_scan_angle(scale_scan_angle);
       lasreaderbuffered->set_file_name(file_name);
+      // a single tile finds its neighbors with the help of its lastiling VLR
+      if ((file_name_number == 1) && (neighbor_file_name_number == 0)) lasreaderbuffered->set_lastiling_neighbors(TRUE, catalog);
       for (i = 0; i < file_name_number; i++)
       {
         if (file_name != file_names[i])
@@ -553,6 +778,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
       if (pipe_on)
       {
         LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+        lasreaderpipeon->set_shared_pipe(pipe_on_shared);
         if (!lasreaderpipeon->open(lasreaderbuffered))
         {
           fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreaderbuffered\n");
@@ -582,7 +808,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
       {
         transform->setPointSource(file_name_current);
       }
-      if (strstr(file_name, ".las") || strstr(file_name, ".laz") || strstr(file_name, ".LAS") || strstr(file_name, ".LAZ"))
+      if (strstr(file_name, ".las") || strstr(file_name, ".laz") || strstr(file_name, ".LAS") || strstr(file_name, ".LAZ") || strstr(file_name, ".laf") || strstr(file_name, ".LAF"))
       {
         LASreaderLAS* lasreaderlas;
         if (scale_factor == 0 && offset == 0)
@@ -610,10 +836,14 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
           return 0;
         }
         LASindex* index = new LASindex();
-        if (index->read(file_name))
+        if (index->read(file_name, auto_index_directory))
           lasreaderlas->set_index(index);
         else
+        {
           delete index;
+          if (auto_index) lasreaderlas->set_auto_index(file_name, auto_index_directory);
+        }
+        if (read_ahead || read_coalesce) lasreaderlas->set_read_ahead(read_ahead, read_coalesce);
         if (files_are_flightlines)
         {
           lasreaderlas->header.file_source_ID = file_name_current;
@@ -627,9 +857,11 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
         if (inside_tile) lasreaderlas->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
         if (inside_circle) lasreaderlas->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
         if (inside_rectangle) lasreaderlas->inside_rectangle(inside_rectangle[0], inside_rectangle[1], inside_rectangle[2], inside_rectangle[3]);
+        if (preview) lasreaderlas->set_preview(preview);
         if (pipe_on)
         {
           LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
           if (!lasreaderpipeon->open(lasreaderlas))
           {
             fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreaderlas\n");
@@ -661,19 +893,25 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
           return 0;
         }
         LASindex* index = new LASindex();
-        if (index->read(file_name))
+        if (index->read(file_name, auto_index_directory))
           lasreaderbin->set_index(index);
         else
+        {
           delete index;
+          if (auto_index) lasreaderbin->set_auto_index(file_name, auto_index_directory);
+        }
+        if (read_ahead || read_coalesce) lasreaderbin->set_read_ahead(read_ahead, read_coalesce);
         if (files_are_flightlines) lasreaderbin->header.file_source_ID = file_name_current;
         if (filter) lasreaderbin->set_filter(filter);
         if (transform) lasreaderbin->set_transform(transform);
         if (inside_tile) lasreaderbin->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
         if (inside_circle) lasreaderbin->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
         if (inside_rectangle) lasreaderbin->inside_rectangle(inside_rectangle[0], inside_rectangle[1], inside_rectangle[2], inside_rectangle[3]);
+        if (preview) lasreaderbin->set_preview(preview);
         if (pipe_on)
         {
           LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
           if (!lasreaderpipeon->open(lasreaderbin))
           {
             fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreaderbin\n");
@@ -687,6 +925,52 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
           return lasreaderbin;
         }
       }
+      else if (strstr(file_name, ".lac") || strstr(file_name, ".LAC"))
+      {
+        if (scale_factor || offset)
+        {
+          fprintf(stderr,"ERROR: cannot rescale or reoffset columnar file '%s'\n", file_name);
+          return 0;
+        }
+        LASreaderCOL* lasreadercol = new LASreaderCOL();
+        if (!lasreadercol->open(file_name, io_ibuffer_size))
+        {
+          fprintf(stderr,"ERROR: cannot open lasreadercol with file name '%s'\n", file_name);
+          delete lasreadercol;
+          return 0;
+        }
+        LASindex* index = new LASindex();
+        if (index->read(file_name, auto_index_directory))
+          lasreadercol->set_index(index);
+        else
+        {
+          delete index;
+          if (auto_index) lasreadercol->set_auto_index(file_name, auto_index_directory);
+        }
+        if (files_are_flightlines) lasreadercol->header.file_source_ID = file_name_current;
+        if (filter) lasreadercol->set_filter(filter);
+        if (transform) lasreadercol->set_transform(transform);
+        if (inside_tile) lasreadercol->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
+        if (inside_circle) lasreadercol->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
+        if (inside_rectangle) lasreadercol->inside_rectangle(inside_rectangle[0], inside_rectangle[1], inside_rectangle[2], inside_rectangle[3]);
+        if (preview) lasreadercol->set_preview(preview);
+        if (pipe_on)
+        {
+          LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
+          if (!lasreaderpipeon->open(lasreadercol))
+          {
+            fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreadercol\n");
+            delete lasreaderpipeon;
+            return 0;
+          }
+          return lasreaderpipeon;
+        }
+        else
+        {
+          return lasreadercol;
+        }
+      }
       else if (strstr(file_name, ".shp") || strstr(file_name, ".SHP"))
       {
         LASreaderSHP* lasreadershp;
@@ -713,6 +997,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
         if (pipe_on)
         {
           LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
           if (!lasreaderpipeon->open(lasreadershp))
           {
             fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreadershp\n");
@@ -744,19 +1029,25 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
           return 0;
         }
         LASindex* index = new LASindex();
-        if (index->read(file_name))
+        if (index->read(file_name, auto_index_directory))
           lasreaderqfit->set_index(index);
         else
+        {
           delete index;
+          if (auto_index) lasreaderqfit->set_auto_index(file_name, auto_index_directory);
+        }
+        if (read_ahead || read_coalesce) lasreaderqfit->set_read_ahead(read_ahead, read_coalesce);
         if (files_are_flightlines) lasreaderqfit->header.file_source_ID = file_name_current;
         if (filter) lasreaderqfit->set_filter(filter);
         if (transform) lasreaderqfit->set_transform(transform);
         if (inside_tile) lasreaderqfit->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
         if (inside_circle) lasreaderqfit->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
         if (inside_rectangle) lasreaderqfit->inside_rectangle(inside_rectangle[0], inside_rectangle[1], inside_rectangle[2], inside_rectangle[3]);
+        if (preview) lasreaderqfit->set_preview(preview);
         if (pipe_on)
         {
           LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
           if (!lasreaderpipeon->open(lasreaderqfit))
           {
             fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreaderqfit\n");
@@ -796,6 +1087,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
         if (pipe_on)
         {
           LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
           if (!lasreaderpipeon->open(lasreaderasc))
           {
             fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreaderasc\n");
@@ -835,6 +1127,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
         if (pipe_on)
         {
           LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
           if (!lasreaderpipeon->open(lasreaderbil))
           {
             fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreaderbil\n");
@@ -874,6 +1167,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
         if (pipe_on)
         {
           LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
           if (!lasreaderpipeon->open(lasreaderdtm))
           {
             fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreaderdtm\n");
@@ -920,6 +1214,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
         if (pipe_on)
         {
           LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+          lasreaderpipeon->set_shared_pipe(pipe_on_shared);
           if (!lasreaderpipeon->open(lasreadertxt))
           {
             fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreadertxt\n");
@@ -971,6 +1266,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
       if (pipe_on)
       {
         LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+        lasreaderpipeon->set_shared_pipe(pipe_on_shared);
         if (!lasreaderpipeon->open(lasreadertxt))
         {
           fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreadertxt\n");
@@ -1009,6 +1305,7 @@ LASreader* LASreadOpener::open(const CHAR* other_file_name)
       if (pipe_on)
       {
         LASreaderPipeOn* lasreaderpipeon = new LASreaderPipeOn();
+        lasreaderpipeon->set_shared_pipe(pipe_on_shared);
         if (!lasreaderpipeon->open(lasreaderlas))
         {
           fprintf(stderr,"ERROR: cannot open lasreaderpipeon with lasreaderlas from stdin\n");
@@ -1068,7 +1365,7 @@ bool LASreadOpener::reopen(LASreader* lasreader, bool remain_buffered)
       }
       return TRUE;
     }
-    else if ((buffer_size > 0) && ((file_name_number > 1) || (neighbor_file_name_number > 0)))
+    else if (is_buffered())
     {
       LASreaderBuffered* lasreaderbuffered = (LASreaderBuffered*)lasreader;
       if (!lasreaderbuffered->reopen())
@@ -1089,7 +1386,7 @@ bool LASreadOpener::reopen(LASreader* lasreader, bool remain_buffered)
     else
     {
       if (!file_name) return FALSE;
-      if (strstr(file_name, ".las") || strstr(file_name, ".laz") || strstr(file_name, ".LAS") || strstr(file_name, ".LAZ"))
+      if (strstr(file_name, ".las") || strstr(file_name, ".laz") || strstr(file_name, ".LAS") || strstr(file_name, ".LAZ") || strstr(file_name, ".laf") || strstr(file_name, ".LAF"))
       {
         LASreaderLAS* lasreaderlas = (LASreaderLAS*)lasreader;
         if (!lasreaderlas->open(file_name, io_ibuffer_size))
@@ -1109,6 +1406,7 @@ bool LASreadOpener::reopen(LASreader* lasreader, bool remain_buffered)
           else if (inside_tile) lasreaderlas->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
           else lasreaderlas->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
         }
+        if (preview) lasreaderlas->set_preview(preview);
         return TRUE;
       }
       else if (strstr(file_name, ".bin") || strstr(file_name, ".BIN"))
@@ -1126,6 +1424,25 @@ bool LASreadOpener::reopen(LASreader* lasreader, bool remain_buffered)
           else if (inside_tile) lasreaderbin->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
           else lasreaderbin->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
         }
+        if (preview) lasreaderbin->set_preview(preview);
+        return TRUE;
+      }
+      else if (strstr(file_name, ".lac") || strstr(file_name, ".LAC"))
+      {
+        LASreaderCOL* lasreadercol = (LASreaderCOL*)lasreader;
+        if (!lasreadercol->reopen(file_name, io_ibuffer_size))
+        {
+          fprintf(stderr,"ERROR: cannot reopen lasreadercol with file name '%s'\n", file_name);
+          return FALSE;
+        }
+        if (inside_rectangle || inside_tile || inside_circle)
+        {
+          lasreadercol->inside_none();
+          if (inside_rectangle) lasreadercol->inside_rectangle(inside_rectangle[0], inside_rectangle[1], inside_rectangle[2], inside_rectangle[3]);
+          else if (inside_tile) lasreadercol->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
+          else lasreadercol->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
+        }
+        if (preview) lasreadercol->set_preview(preview);
         return TRUE;
       }
       else if (strstr(file_name, ".shp") || strstr(file_name, ".SHP"))
@@ -1160,6 +1477,7 @@ bool LASreadOpener::reopen(LASreader* lasreader, bool remain_buffered)
           else if (inside_tile) lasreaderqfit->inside_tile(inside_tile[0], inside_tile[1], inside_tile[2]);
           else lasreaderqfit->inside_circle(inside_circle[0], inside_circle[1], inside_circle[2]);
         }
+        if (preview) lasreaderqfit->set_preview(preview);
         return TRUE;
       }
       else if (strstr(file_name, ".asc") || strstr(file_name, ".ASC"))
@@ -1268,6 +1586,8 @@ void LASreadOpener::usage() const
   fprintf(stderr,"Supported LAS Inputs\n");
   fprintf(stderr,"  -i lidar.las\n");
   fprintf(stderr,"  -i lidar.laz\n");
+  fprintf(stderr,"  -i lidar.laf\n");
+  fprintf(stderr,"  -i lidar.lac\n");
   fprintf(stderr,"  -i lidar1.las lidar2.las lidar3.las -merged\n");
   fprintf(stderr,"  -i *.las - merged\n");
   fprintf(stderr,"  -i flight0??.laz flight1??.laz\n");
@@ -1277,11 +1597,26 @@ void LASreadOpener::usage() const
   fprintf(stderr,"  -i lidar.txt -iparse xyzti -iskip 2 (on-the-fly from ASCII)\n");
   fprintf(stderr,"  -i lidar.txt -iparse xyzi -itranslate_intensity 1024\n");
   fprintf(stderr,"  -lof file_list.txt\n");
+  fprintf(stderr,"  -catalog tiles.lacat (file list with headers of all files)\n");
+  fprintf(stderr,"  -lof file_list.txt -merged -write_catalog tiles.lacat\n");
   fprintf(stderr,"  -stdin (pipe from stdin)\n");
   fprintf(stderr,"  -rescale 0.01 0.01 0.001\n");
   fprintf(stderr,"  -rescale_xy 0.01 0.01\n");
   fprintf(stderr,"  -rescale_z 0.01\n");
   fprintf(stderr,"  -reoffset 600000 4000000 0\n");
+  fprintf(stderr,"  -auto_index (create LAX during first spatial query)\n");
+  fprintf(stderr,"  -auto_index_cache c:\\lax_cache\n");
+  fprintf(stderr,"  -read_ahead 8 (prefetch next LAX intervals)\n");
+  fprintf(stderr,"  -read_coalesce 65536 (read through gaps between LAX intervals)\n");
+  fprintf(stderr,"  -preview 100000 (read about that many points spread evenly via the LAX)\n");
+  fprintf(stderr,"  -peek_threads 16 (open headers of merged files in parallel)\n");
+  fprintf(stderr,"  -prefetch_files 2 (open next merged files in the background)\n");
+  fprintf(stderr,"  -interleave 4 (read merged files concurrently in no particular order)\n");
+  fprintf(stderr,"  -buffered 25 -i tile.laz (neighbors from lastiling VLR and directory or catalog)\n");
+  fprintf(stderr,"  -buffered_cache 512 (decode neighbor rims once and visit tiles row by row)\n");
+  fprintf(stderr,"  -merge_gps_time (merged flightlines come out in GPS time order, up to 256 files)\n");
+  fprintf(stderr,"  -merge_gps_time_check (also warn about files that are not sorted)\n");
+  fprintf(stderr,"  -pipe_on_shared (like -pipe_on but points go through shared memory to a LASlib stage)\n");
 }
 
 bool LASreadOpener::parse(int argc, char* argv[])
@@ -1384,6 +1719,30 @@ bool LASreadOpener::parse(int argc, char* argv[])
       }
       *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
     }
+    else if (strcmp(argv[i],"-catalog") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: catalog\n", argv[i]);
+        return FALSE;
+      }
+      if (!add_catalog(argv[i+1], unique))
+      {
+        fprintf(stderr, "ERROR: cannot load catalog '%s'\n", argv[i+1]);
+        return FALSE;
+      }
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
+    else if (strcmp(argv[i],"-write_catalog") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: catalog\n", argv[i]);
+        return FALSE;
+      }
+      set_write_catalog(argv[i+1]);
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
     else if (strcmp(argv[i],"-rescale") == 0)
     {
       if ((i+3) >= argc)
@@ -1611,6 +1970,108 @@ bool LASreadOpener::parse(int argc, char* argv[])
       set_pipe_on(TRUE);
       *argv[i]='\0';
     }
+    else if (strcmp(argv[i],"-pipe_on_shared") == 0)
+    {
+      set_pipe_on(TRUE);
+      set_pipe_on_shared(TRUE);
+      *argv[i]='\0';
+    }
+    else if (strcmp(argv[i],"-auto_index") == 0)
+    {
+      set_auto_index(TRUE);
+      *argv[i]='\0';
+    }
+    else if (strcmp(argv[i],"-read_ahead") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: intervals\n", argv[i]);
+        return FALSE;
+      }
+      set_read_ahead((U32)atoi(argv[i+1]));
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
+    else if (strcmp(argv[i],"-read_coalesce") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: bytes\n", argv[i]);
+        return FALSE;
+      }
+      set_read_coalesce((U32)atoi(argv[i+1]));
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
+    else if (strcmp(argv[i],"-preview") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: number of points\n", argv[i]);
+        return FALSE;
+      }
+      set_preview((U32)atoi(argv[i+1]));
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
+    else if (strcmp(argv[i],"-peek_threads") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: number\n", argv[i]);
+        return FALSE;
+      }
+      set_peek_threads((U32)atoi(argv[i+1]));
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
+    else if (strcmp(argv[i],"-prefetch_files") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: number\n", argv[i]);
+        return FALSE;
+      }
+      set_prefetch_files((U32)atoi(argv[i+1]));
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
+    else if (strcmp(argv[i],"-interleave") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: number\n", argv[i]);
+        return FALSE;
+      }
+      set_interleave((U32)atoi(argv[i+1]));
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
+    else if (strcmp(argv[i],"-buffered_cache") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: megabytes\n", argv[i]);
+        return FALSE;
+      }
+      set_buffered_cache((U32)atoi(argv[i+1]));
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
+    else if (strcmp(argv[i],"-merge_gps_time") == 0)
+    {
+      set_gps_time_merge(TRUE);
+      *argv[i]='\0';
+    }
+    else if (strcmp(argv[i],"-merge_gps_time_check") == 0)
+    {
+      set_gps_time_merge(TRUE, TRUE);
+      *argv[i]='\0';
+    }
+    else if (strcmp(argv[i],"-auto_index_cache") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: directory\n", argv[i]);
+        return FALSE;
+      }
+      set_auto_index(TRUE);
+      set_auto_index_directory(argv[i+1]);
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
     else if (strcmp(argv[i],"-populate") == 0)
     {
       set_populate_header(TRUE);
@@ -1725,6 +2186,14 @@ I32 LASreadOpener::get_file_format(U32 number) const
   {
     return LAS_TOOLS_FORMAT_LAZ;
   }
+  else if (strstr(file_names[number], ".laf") || strstr(file_names[number], ".LAF"))
+  {
+    return LAS_TOOLS_FORMAT_LAF;
+  }
+  else if (strstr(file_names[number], ".lac") || strstr(file_names[number], ".LAC"))
+  {
+    return LAS_TOOLS_FORMAT_LAC;
+  }
   else if (strstr(file_names[number], ".bin") || strstr(file_names[number], ".BIN"))
   {
     return LAS_TOOLS_FORMAT_BIN;
@@ -1906,6 +2375,33 @@ bool LASreadOpener::add_list_of_files(const CHAR* list_of_files, bool unique)
   return TRUE;
 }
 
+bool LASreadOpener::add_catalog(const CHAR* catalog_file_name, bool unique)
+{
+  if (catalog == 0) catalog = new LAScatalog();
+  U32 i, number = catalog->get_number_entries();
+  if (!catalog->read(catalog_file_name))
+  {
+    return FALSE;
+  }
+  // the entries are only checked against the files once they are opened
+  for (i = number; i < catalog->get_number_entries(); i++)
+  {
+#ifdef _WIN32
+    // the names are exact and must not be expanded as wildcards
+    add_file_name_single(catalog->get_file_name(i), unique);
+#else
+    add_file_name(catalog->get_file_name(i), unique);
+#endif
+  }
+  return TRUE;
+}
+
+void LASreadOpener::set_write_catalog(const CHAR* write_catalog)
+{
+  if (this->write_catalog) free(this->write_catalog);
+  this->write_catalog = (write_catalog ? strdup(write_catalog) : 0);
+}
+
 void LASreadOpener::delete_file_name(U32 file_name_id)
 {
   if (file_name_id < file_name_number)
@@ -2112,6 +2608,167 @@ void LASreadOpener::set_pipe_on(bool pipe_on)
   this->pipe_on = pipe_on;
 }
 
+void LASreadOpener::set_pipe_on_shared(bool pipe_on_shared)
+{
+  this->pipe_on_shared = pipe_on_shared;
+}
+
+void LASreadOpener::set_read_ahead(U32 read_ahead)
+{
+  this->read_ahead = read_ahead;
+}
+
+void LASreadOpener::set_read_coalesce(U32 read_coalesce)
+{
+  this->read_coalesce = read_coalesce;
+}
+
+void LASreadOpener::set_preview(U32 preview)
+{
+  this->preview = preview;
+}
+
+void LASreadOpener::set_peek_threads(U32 peek_threads)
+{
+  this->peek_threads = peek_threads;
+}
+
+void LASreadOpener::set_prefetch_files(U32 prefetch_files)
+{
+  this->prefetch_files = prefetch_files;
+}
+
+void LASreadOpener::set_interleave(U32 interleave)
+{
+  this->interleave = interleave;
+}
+
+void LASreadOpener::set_buffered_cache(U32 megabytes)
+{
+  buffered_cache = megabytes;
+}
+
+// orders the tiles row by row (in alternating directions) so that consecutive
+// tiles share most of their neighbors and notes for each file which tile last
+// needs it as a neighbor
+
+class LASreadOpenerTile
+{
+public:
+  I64 row;
+  F64 x;
+  U32 file;
+  bool operator<(const LASreadOpenerTile& other) const
+  {
+    if (row != other.row) return (row < other.row);
+    if (x != other.x) return ((row & 1) ? (x > other.x) : (x < other.x));
+    return (file < other.file);
+  }
+};
+
+bool LASreadOpener::schedule_buffered_tiles()
+{
+  U32 i;
+  F64* bounding_boxes = new F64[4*file_name_number];
+  for (i = 0; i < file_name_number; i++)
+  {
+    I32 c = (catalog ? catalog->find_entry(file_names[i]) : -1);
+    if ((c >= 0) && catalog->is_current(c))
+    {
+      const LAScatalogEntry* entry = catalog->get_entry(c);
+      bounding_boxes[4*i+0] = entry->min_x;
+      bounding_boxes[4*i+1] = entry->min_y;
+      bounding_boxes[4*i+2] = entry->max_x;
+      bounding_boxes[4*i+3] = entry->max_y;
+      continue;
+    }
+    LASreaderLAS lasreaderlas;
+    if (!(strstr(file_names[i], ".las") || strstr(file_names[i], ".laz") || strstr(file_names[i], ".LAS") || strstr(file_names[i], ".LAZ") || strstr(file_names[i], ".laf") || strstr(file_names[i], ".LAF")) || !lasreaderlas.open(file_names[i]))
+    {
+      // keep the order of the files as it is
+      delete [] bounding_boxes;
+      return FALSE;
+    }
+    bounding_boxes[4*i+0] = lasreaderlas.header.min_x;
+    bounding_boxes[4*i+1] = lasreaderlas.header.min_y;
+    bounding_boxes[4*i+2] = lasreaderlas.header.max_x;
+    bounding_boxes[4*i+3] = lasreaderlas.header.max_y;
+    lasreaderlas.close();
+  }
+
+  // rows are as high as the first tile
+
+  F64 min_y = bounding_boxes[1];
+  F64 height = bounding_boxes[3] - bounding_boxes[1];
+  for (i = 1; i < file_name_number; i++) if (bounding_boxes[4*i+1] < min_y) min_y = bounding_boxes[4*i+1];
+  if (height <= 0.0) height = 1.0;
+  LASreadOpenerTile* tiles = new LASreadOpenerTile[file_name_number];
+  for (i = 0; i < file_name_number; i++)
+  {
+    tiles[i].row = I64_FLOOR(((bounding_boxes[4*i+1] + bounding_boxes[4*i+3])/2 - min_y)/height);
+    tiles[i].x = (bounding_boxes[4*i+0] + bounding_boxes[4*i+2])/2;
+    tiles[i].file = i;
+  }
+  std::sort(tiles, tiles + file_name_number);
+  CHAR** sorted_file_names = (CHAR**)malloc(sizeof(CHAR*)*file_name_allocated);
+  F64* sorted_bounding_boxes = new F64[4*file_name_number];
+  for (i = 0; i < file_name_number; i++)
+  {
+    sorted_file_names[i] = file_names[tiles[i].file];
+    memcpy(&sorted_bounding_boxes[4*i], &bounding_boxes[4*tiles[i].file], 4*sizeof(F64));
+  }
+  free(file_names);
+  file_names = sorted_file_names;
+  delete [] bounding_boxes;
+  delete [] tiles;
+
+  // the last tile that has each file within its buffer
+
+  LASrtree lasrtree;
+  lasrtree.build(file_name_number, sorted_bounding_boxes);
+  file_last_use = new U32[file_name_number];
+  for (i = 0; i < file_name_number; i++) file_last_use[i] = i;
+  for (i = 0; i < file_name_number; i++)
+  {
+    U32 h, number = lasrtree.intersect_rectangle(sorted_bounding_boxes[4*i+0] - buffer_size, sorted_bounding_boxes[4*i+1] - buffer_size, sorted_bounding_boxes[4*i+2] + buffer_size, sorted_bounding_boxes[4*i+3] + buffer_size);
+    const U32* hits = lasrtree.get_hits();
+    for (h = 0; h < number; h++)
+    {
+      if (file_last_use[hits[h]] < i) file_last_use[hits[h]] = i;
+    }
+  }
+  delete [] sorted_bounding_boxes;
+
+  // the files ordered by their last use so each tile releases only its share
+
+  U32* count = new U32[file_name_number+1];
+  memset(count, 0, sizeof(U32)*(file_name_number+1));
+  for (i = 0; i < file_name_number; i++) count[file_last_use[i]+1]++;
+  for (i = 0; i < file_name_number; i++) count[i+1] += count[i];
+  file_release = new U32[file_name_number];
+  for (i = 0; i < file_name_number; i++) file_release[count[file_last_use[i]]++] = i;
+  delete [] count;
+  file_release_next = 0;
+  return TRUE;
+}
+
+void LASreadOpener::set_gps_time_merge(bool gps_time_merge, bool gps_time_check)
+{
+  this->gps_time_merge = gps_time_merge;
+  this->gps_time_check = gps_time_check;
+}
+
+void LASreadOpener::set_auto_index(bool auto_index)
+{
+  this->auto_index = auto_index;
+}
+
+void LASreadOpener::set_auto_index_directory(const CHAR* auto_index_directory)
+{
+  if (this->auto_index_directory) free(this->auto_index_directory);
+  this->auto_index_directory = (auto_index_directory ? strdup(auto_index_directory) : 0);
+}
+
 void LASreadOpener::set_inside_tile(const F32 ll_x, const F32 ll_y, const F32 size)
 {
   if (inside_tile == 0) inside_tile = new F32[3];
@@ -2178,6 +2835,25 @@ LASreadOpener::LASreadOpener()
   populate_header = FALSE;
   keep_lastiling = FALSE;
   pipe_on = FALSE;
+  pipe_on_shared = FALSE;
+  lastiling_file_name = 0;
+  lastiling_found = FALSE;
+  auto_index = FALSE;
+  auto_index_directory = 0;
+  read_ahead = 0;
+  read_coalesce = 0;
+  preview = 0;
+  peek_threads = 8;
+  prefetch_files = 0;
+  interleave = 0;
+  gps_time_merge = FALSE;
+  gps_time_check = FALSE;
+  buffered_cache = 0;
+  file_last_use = 0;
+  file_release = 0;
+  file_release_next = 0;
+  catalog = 0;
+  write_catalog = 0;
   unique = FALSE;
   file_name_number = 0;
   file_name_allocated = 0;
@@ -2206,6 +2882,11 @@ LASreadOpener::~LASreadOpener()
     free(neighbor_file_names);
   }
   if (parse_string) free(parse_string);
+  if (auto_index_directory) free(auto_index_directory);
+  if (catalog) delete catalog;
+  if (write_catalog) free(write_catalog);
+  if (file_last_use) delete [] file_last_use;
+  if (file_release) delete [] file_release;
   if (scale_factor) delete [] scale_factor;
   if (offset) delete [] offset;
   if (inside_tile) delete [] inside_tile;
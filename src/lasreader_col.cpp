@@ -0,0 +1,619 @@
+/*
+===============================================================================
+
+  FILE:  lasreader_col.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "lasreader_col.hpp"
+
+#include "lasreader_las.hpp"
+#include "laspointfast.hpp"
+#include "bytestreamin.hpp"
+#include "bytestreamin_file.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool LASreaderCOL::open(const char* file_name, U32 io_buffer_size)
+{
+  U32 i;
+
+  if (file_name == 0)
+  {
+    fprintf(stderr,"ERROR: file name pointer is zero\n");
+    return FALSE;
+  }
+
+  if (!IS_LITTLE_ENDIAN())
+  {
+    fprintf(stderr,"ERROR: columnar files need a little-endian machine\n");
+    return FALSE;
+  }
+
+  file = fopen(file_name, "rb");
+  if (file == 0)
+  {
+    fprintf(stderr, "ERROR: cannot open file '%s'\n", file_name);
+    return FALSE;
+  }
+
+  if (setvbuf(file, NULL, _IOFBF, io_buffer_size) != 0)
+  {
+    fprintf(stderr, "WARNING: setvbuf() failed with buffer size %u\n", io_buffer_size);
+  }
+
+  stream = new ByteStreamInFileLE(file);
+
+  CHAR magic[4];
+  U32 version;
+  try
+  {
+    stream->getBytes((U8*)magic, 4);
+    stream->get32bitsLE((U8*)&version);
+  }
+  catch (...)
+  {
+    fprintf(stderr,"ERROR: reading start of columnar file '%s'\n", file_name);
+    return FALSE;
+  }
+  if (strncmp(magic, LAS_COLUMN_MAGIC, 4) != 0)
+  {
+    fprintf(stderr,"ERROR: '%s' is not a columnar file\n", file_name);
+    return FALSE;
+  }
+  if (version != LAS_COLUMN_VERSION)
+  {
+    fprintf(stderr,"ERROR: columnar file '%s' has unknown version %u\n", file_name, version);
+    return FALSE;
+  }
+
+  if (!read_footer())
+  {
+    fprintf(stderr,"ERROR: reading footer of columnar file '%s'\n", file_name);
+    return FALSE;
+  }
+
+  npoints = chunk_firsts[number_chunks];
+  p_count = 0;
+
+  if (!point.init(&header, header.point_data_format, header.point_data_record_length, &header)) return FALSE;
+
+  // buffers for the values of the largest chunk
+
+  U32 max_points = 0;
+  U32 max_width = 0;
+  for (i = 0; i < number_chunks; i++)
+  {
+    if (chunk_points[i] > max_points) max_points = chunk_points[i];
+  }
+  selected = (U8*)malloc(number_columns);
+  ranged = (U8*)calloc(number_columns, 1);
+  range_min = (F64*)calloc(number_columns, sizeof(F64));
+  range_max = (F64*)calloc(number_columns, sizeof(F64));
+  loaded = (U32*)calloc(number_columns, sizeof(U32));
+  values = (U8**)calloc(number_columns, sizeof(U8*));
+  if ((selected == 0) || (ranged == 0) || (range_min == 0) || (range_max == 0) || (loaded == 0) || (values == 0))
+  {
+    fprintf(stderr,"ERROR: cannot allocate %u columns\n", number_columns);
+    return FALSE;
+  }
+  memset(selected, 1, number_columns);
+  for (i = 0; i < number_columns; i++)
+  {
+    values[i] = (U8*)malloc((size_t)max_points*columns[i].width + 1);
+    if (values[i] == 0)
+    {
+      fprintf(stderr,"ERROR: cannot allocate column '%s' for chunks of %u points\n", columns[i].name, max_points);
+      return FALSE;
+    }
+    if (columns[i].width > max_width) max_width = columns[i].width;
+  }
+  planes = (U8*)malloc((size_t)max_points*max_width + 1);
+  compressed = (U8*)malloc(max_points + 1);
+  if ((planes == 0) || (compressed == 0))
+  {
+    fprintf(stderr,"ERROR: cannot allocate buffers for chunks of %u points\n", max_points);
+    return FALSE;
+  }
+
+  column_X = get_column_index("X");
+  column_Y = get_column_index("Y");
+  current_chunk = U32_MAX;
+  points_in_chunk = 0;
+  point_in_chunk = 0;
+  number_loaded = 0;
+
+  return TRUE;
+}
+
+bool LASreaderCOL::reopen(const char* file_name, U32 io_buffer_size)
+{
+  // take the selection and the ranges away from close()
+  U32 number = number_columns;
+  U8* old_selected = selected;
+  U8* old_ranged = ranged;
+  F64* old_range_min = range_min;
+  F64* old_range_max = range_max;
+  selected = 0;
+  ranged = 0;
+  range_min = 0;
+  range_max = 0;
+  close();
+  bool success = open(file_name, io_buffer_size);
+  if (success && old_selected && (number == number_columns))
+  {
+    memcpy(selected, old_selected, number);
+    memcpy(ranged, old_ranged, number);
+    memcpy(range_min, old_range_min, sizeof(F64)*number);
+    memcpy(range_max, old_range_max, sizeof(F64)*number);
+  }
+  if (old_selected) free(old_selected);
+  if (old_ranged) free(old_ranged);
+  if (old_range_min) free(old_range_min);
+  if (old_range_max) free(old_range_max);
+  return success;
+}
+
+bool LASreaderCOL::read_footer()
+{
+  U32 i, c;
+  I64 footer_start;
+  CHAR magic[4];
+  U32 size;
+  U8* blob = 0;
+
+  try
+  {
+    stream->seekEnd(12);
+    stream->get64bitsLE((U8*)&footer_start);
+    stream->getBytes((U8*)magic, 4);
+    if (strncmp(magic, LAS_COLUMN_MAGIC, 4) != 0)
+    {
+      fprintf(stderr,"ERROR: columnar file has no footer. maybe it was truncated\n");
+      return FALSE;
+    }
+    stream->seek(footer_start);
+    stream->get32bitsLE((U8*)&size);
+    blob = (U8*)malloc(size);
+    if (blob == 0) return FALSE;
+    stream->getBytes(blob, size);
+  }
+  catch (...)
+  {
+    if (blob) free(blob);
+    return FALSE;
+  }
+
+  // the header with all its VLRs is read by the LAS reader
+
+  istringstream headerstream(string((const char*)blob, size));
+  free(blob);
+  LASreaderLAS lasreaderlas;
+  if (!lasreaderlas.open(headerstream))
+  {
+    fprintf(stderr,"ERROR: reading LAS header of columnar file\n");
+    return FALSE;
+  }
+  header.clean();
+  header = lasreaderlas.header;
+
+  // unlink pointers in other header so their data does not get deallocated twice
+  lasreaderlas.header.unlink();
+
+  // special check for attributes in extra bytes
+  if (header.number_attributes)
+  {
+    header.number_attributes = 0;
+    header.init_attributes(lasreaderlas.header.number_attributes, lasreaderlas.header.attributes);
+  }
+
+  try
+  {
+    stream->get32bitsLE((U8*)&number_columns);
+    columns = (LAScolumn*)calloc(number_columns, sizeof(LAScolumn));
+    if (columns == 0) return FALSE;
+    for (c = 0; c < number_columns; c++)
+    {
+      LAScolumn* column = &(columns[c]);
+      stream->getBytes((U8*)column->name, 32);
+      stream->getBytes(&(column->type), 1);
+      stream->getBytes(&(column->delta), 1);
+      stream->get16bitsLE((U8*)&(column->width));
+      if ((column->width == 0) || (column->delta && (column->width != 2) && (column->width != 4) && (column->width != 8)))
+      {
+        fprintf(stderr,"ERROR: column %u has width %u\n", c, column->width);
+        return FALSE;
+      }
+      if (!column->set_field(&header))
+      {
+        fprintf(stderr,"ERROR: no point field for column '%.32s'\n", column->name);
+        return FALSE;
+      }
+    }
+    stream->get32bitsLE((U8*)&number_chunks);
+    chunk_points = (U32*)malloc(sizeof(U32)*(number_chunks+1));
+    chunk_firsts = (I64*)malloc(sizeof(I64)*(number_chunks+1));
+    column_chunks = (LAScolumnChunk*)malloc(sizeof(LAScolumnChunk)*((size_t)number_chunks*number_columns+1));
+    if ((chunk_points == 0) || (chunk_firsts == 0) || (column_chunks == 0))
+    {
+      fprintf(stderr,"ERROR: cannot allocate footer for %u chunks\n", number_chunks);
+      return FALSE;
+    }
+    chunk_firsts[0] = 0;
+    for (i = 0; i < number_chunks; i++)
+    {
+      stream->get32bitsLE((U8*)&(chunk_points[i]));
+      chunk_firsts[i+1] = chunk_firsts[i] + chunk_points[i];
+      for (c = 0; c < number_columns; c++)
+      {
+        LAScolumnChunk* column_chunk = &(column_chunks[(size_t)i*number_columns + c]);
+        stream->get64bitsLE((U8*)&(column_chunk->offset));
+        stream->get32bitsLE((U8*)&(column_chunk->bytes));
+        stream->get64bitsLE((U8*)&(column_chunk->min));
+        stream->get64bitsLE((U8*)&(column_chunk->max));
+      }
+    }
+  }
+  catch (...)
+  {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+const CHAR* LASreaderCOL::get_column_name(U32 index) const
+{
+  if (index < number_columns) return columns[index].name;
+  return 0;
+}
+
+I32 LASreaderCOL::get_column_index(const CHAR* name) const
+{
+  U32 c;
+  for (c = 0; c < number_columns; c++)
+  {
+    if (strncmp(columns[c].name, name, 32) == 0) return (I32)c;
+  }
+  return -1;
+}
+
+bool LASreaderCOL::select_columns(const CHAR* names)
+{
+  if (names == 0)
+  {
+    memset(selected, 1, number_columns);
+    return TRUE;
+  }
+  memset(selected, 0, number_columns);
+  CHAR name[33];
+  const CHAR* start = names;
+  while (*start)
+  {
+    const CHAR* end = start;
+    while (*end && (*end != ',')) end++;
+    U32 length = (U32)(end - start);
+    if (length > 32) length = 32;
+    strncpy(name, start, length);
+    name[length] = '\0';
+    if (length)
+    {
+      I32 c = get_column_index(name);
+      if (c < 0)
+      {
+        fprintf(stderr,"ERROR: no column '%s'\n", name);
+        return FALSE;
+      }
+      selected[c] = 1;
+    }
+    start = (*end ? end + 1 : end);
+  }
+  return TRUE;
+}
+
+bool LASreaderCOL::add_range(const CHAR* name, F64 min, F64 max)
+{
+  I32 c = get_column_index(name);
+  if (c < 0)
+  {
+    fprintf(stderr,"ERROR: no column '%s'\n", name);
+    return FALSE;
+  }
+  if (columns[c].type == LAS_COLUMN_BYTES)
+  {
+    fprintf(stderr,"ERROR: column '%s' has no statistics\n", name);
+    return FALSE;
+  }
+  // the coordinates are compared as the integers they are stored as
+  if (columns[c].field == LAS_COLUMN_X)
+  {
+    min = (min - header.x_offset) / header.x_scale_factor;
+    max = (max - header.x_offset) / header.x_scale_factor;
+  }
+  else if (columns[c].field == LAS_COLUMN_Y)
+  {
+    min = (min - header.y_offset) / header.y_scale_factor;
+    max = (max - header.y_offset) / header.y_scale_factor;
+  }
+  else if (columns[c].field == LAS_COLUMN_Z)
+  {
+    min = (min - header.z_offset) / header.z_scale_factor;
+    max = (max - header.z_offset) / header.z_scale_factor;
+  }
+  ranged[c] = 1;
+  range_min[c] = min;
+  range_max[c] = max;
+  return TRUE;
+}
+
+void LASreaderCOL::clear_ranges()
+{
+  memset(ranged, 0, number_columns);
+}
+
+bool LASreaderCOL::chunk_qualifies(U32 chunk) const
+{
+  U32 c;
+  const LAScolumnChunk* column_chunk = &(column_chunks[(size_t)chunk*number_columns]);
+  for (c = 0; c < number_columns; c++)
+  {
+    if (ranged[c] && ((column_chunk[c].max < range_min[c]) || (range_max[c] < column_chunk[c].min))) return FALSE;
+  }
+  // during a spatial query the header has the bounding box of the query
+  if (inside && (column_X >= 0) && (column_Y >= 0))
+  {
+    if (header.get_x((I32)column_chunk[column_X].max) < header.min_x) return FALSE;
+    if (header.get_x((I32)column_chunk[column_X].min) > header.max_x) return FALSE;
+    if (header.get_y((I32)column_chunk[column_Y].max) < header.min_y) return FALSE;
+    if (header.get_y((I32)column_chunk[column_Y].min) > header.max_y) return FALSE;
+  }
+  return TRUE;
+}
+
+bool LASreaderCOL::load_column(U32 chunk, U32 c)
+{
+  U32 i, b, size;
+  U32 number = chunk_points[chunk];
+  const LAScolumn* column = &(columns[c]);
+  const LAScolumnChunk* column_chunk = &(column_chunks[(size_t)chunk*number_columns + c]);
+  U32 width = column->width;
+
+  try
+  {
+    stream->seek(column_chunk->offset);
+    for (b = 0; b < width; b++)
+    {
+      U8* plane = planes + (size_t)b*number;
+      stream->get32bitsLE((U8*)&size);
+      if (size & LAS_FAST_RAW_COLUMN)
+      {
+        if ((size & ~LAS_FAST_RAW_COLUMN) != number) return FALSE;
+        stream->getBytes(plane, number);
+      }
+      else
+      {
+        if (size >= number) return FALSE;
+        stream->getBytes(compressed, size);
+        if (!LASfastCoder::decompress(compressed, size, plane, number)) return FALSE;
+      }
+    }
+  }
+  catch (...)
+  {
+    return FALSE;
+  }
+
+  // put the byte planes back into values and undo the deltas
+
+  U8* value = values[c];
+  for (b = 0; b < width; b++)
+  {
+    const U8* plane = planes + (size_t)b*number;
+    U8* v = value + b;
+    for (i = 0; i < number; i++, v += width) *v = plane[i];
+  }
+  if (column->delta)
+  {
+    LASfastCoder::delta_decode(value, number, width, width);
+  }
+  return TRUE;
+}
+
+bool LASreaderCOL::load_chunk(U32 chunk)
+{
+  U32 c;
+  number_loaded = 0;
+  points_in_chunk = 0;
+  point_in_chunk = 0;
+  for (c = 0; c < number_columns; c++)
+  {
+    if (selected[c] || ranged[c] || (inside && (((I32)c == column_X) || ((I32)c == column_Y))))
+    {
+      if (!load_column(chunk, c))
+      {
+        fprintf(stderr,"ERROR: corrupt column '%.32s' in chunk %u\n", columns[c].name, chunk);
+        return FALSE;
+      }
+      loaded[number_loaded] = c;
+      number_loaded++;
+    }
+  }
+  current_chunk = chunk;
+  points_in_chunk = chunk_points[chunk];
+  return TRUE;
+}
+
+bool LASreaderCOL::seek(const I64 p_index)
+{
+  if ((p_index < 0) || (p_index >= npoints)) return FALSE;
+  U32 lo = 0, hi = number_chunks;
+  while ((hi - lo) > 1)
+  {
+    U32 mid = (lo + hi) / 2;
+    if (chunk_firsts[mid] <= p_index) lo = mid; else hi = mid;
+  }
+  if ((lo != current_chunk) || (points_in_chunk == 0))
+  {
+    if (!load_chunk(lo)) return FALSE;
+  }
+  point_in_chunk = (U32)(p_index - chunk_firsts[lo]);
+  p_count = p_index;
+  return TRUE;
+}
+
+bool LASreaderCOL::read_point_default()
+{
+  U32 i, c;
+  // a spatial index (or a preview) calls seek() and then reads point by point
+  bool indexed = (index && (inside || preview));
+  while (TRUE)
+  {
+    if (point_in_chunk == points_in_chunk)
+    {
+      U32 chunk = current_chunk + 1;
+      // a spatial index already skips what the statistics would
+      if (!indexed)
+      {
+        while ((chunk < number_chunks) && !chunk_qualifies(chunk)) chunk++;
+      }
+      if (chunk >= number_chunks)
+      {
+        current_chunk = number_chunks;
+        points_in_chunk = point_in_chunk = 0;
+        p_count = npoints;
+        return FALSE;
+      }
+      if (!load_chunk(chunk)) return FALSE;
+      p_count = chunk_firsts[chunk];
+    }
+    for (i = 0; i < number_loaded; i++)
+    {
+      c = loaded[i];
+      columns[c].set(&point, values[c] + (size_t)point_in_chunk*columns[c].width);
+    }
+    point_in_chunk++;
+    p_count++;
+    for (i = 0; i < number_loaded; i++)
+    {
+      c = loaded[i];
+      if (ranged[c])
+      {
+        F64 value = columns[c].get_value(values[c] + (size_t)(point_in_chunk-1)*columns[c].width);
+        if ((value < range_min[c]) || (range_max[c] < value)) break;
+      }
+    }
+    if (i == number_loaded) return TRUE;
+    // the index asks for the next point itself
+    if (indexed) return FALSE;
+  }
+}
+
+ByteStreamIn* LASreaderCOL::get_stream() const
+{
+  return stream;
+}
+
+void LASreaderCOL::close(bool close_stream)
+{
+  if (close_stream)
+  {
+    if (stream)
+    {
+      delete stream;
+      stream = 0;
+    }
+    if (file)
+    {
+      fclose(file);
+      file = 0;
+    }
+  }
+  if (values)
+  {
+    U32 c;
+    for (c = 0; c < number_columns; c++) if (values[c]) free(values[c]);
+    free(values);
+    values = 0;
+  }
+  if (columns) free(columns);
+  if (selected) free(selected);
+  if (ranged) free(ranged);
+  if (range_min) free(range_min);
+  if (range_max) free(range_max);
+  if (loaded) free(loaded);
+  if (chunk_points) free(chunk_points);
+  if (chunk_firsts) free(chunk_firsts);
+  if (column_chunks) free(column_chunks);
+  if (planes) free(planes);
+  if (compressed) free(compressed);
+  columns = 0;
+  selected = 0;
+  ranged = 0;
+  range_min = 0;
+  range_max = 0;
+  loaded = 0;
+  chunk_points = 0;
+  chunk_firsts = 0;
+  column_chunks = 0;
+  planes = 0;
+  compressed = 0;
+  number_columns = 0;
+  number_chunks = 0;
+  number_loaded = 0;
+  points_in_chunk = 0;
+  point_in_chunk = 0;
+}
+
+LASreaderCOL::LASreaderCOL()
+{
+  file = 0;
+  stream = 0;
+  number_columns = 0;
+  columns = 0;
+  selected = 0;
+  ranged = 0;
+  range_min = 0;
+  range_max = 0;
+  column_X = -1;
+  column_Y = -1;
+  number_chunks = 0;
+  chunk_points = 0;
+  chunk_firsts = 0;
+  column_chunks = 0;
+  current_chunk = U32_MAX;
+  points_in_chunk = 0;
+  point_in_chunk = 0;
+  number_loaded = 0;
+  loaded = 0;
+  values = 0;
+  planes = 0;
+  compressed = 0;
+}
+
+LASreaderCOL::~LASreaderCOL()
+{
+  if (stream || columns) close();
+}
@@ -34,12 +34,20 @@
 #include "bytestreamin_file.hpp"
 #include "bytestreamin_istream.hpp"
 #include "lasreadpoint.hpp"
+#include "laspointfast.hpp"
+#include "laspointraw.hpp"
+#include "arithmeticdecoder.hpp"
+#include "integercompressor.hpp"
 #include "lasindex.hpp"
+#include "lassharedpipe.hpp"
+#include "lasoctree.hpp"
 
 #ifdef _WIN32
 #include <fcntl.h>
 #include <io.h>
 #include <math.h>
+#else
+#include <fcntl.h>
 #endif
 
 #include <stdlib.h>
@@ -119,6 +127,7 @@ bool LASreaderLAS::open(istream& stream, bool peek_only)
 bool LASreaderLAS::open(ByteStreamIn* stream, bool peek_only)
 {
   U32 i,j;
+  bool fast_compressed = FALSE;
 
   if (stream == 0)
   {
@@ -398,8 +407,8 @@ bool LASreaderLAS::open(ByteStreamIn* stream, bool peek_only)
 
   if (peek_only)
   {
-    // at least repair point type in incomplete header (no VLRs, no LASzip, no LAStiling) 
-    header.point_data_format &= 127;
+    // at least repair point type in incomplete header (no VLRs, no LASzip, no LAStiling, no fast compression) 
+    header.point_data_format &= 63;
     return TRUE;
   }
 
@@ -568,6 +577,35 @@ bool LASreaderLAS::open(ByteStreamIn* stream, bool peek_only)
             header.laszip->items[j].version = version;
           }
         }
+        else if ((strcmp(header.vlrs[i].user_id, LAS_POINT_FAST_USER_ID) == 0) && (header.vlrs[i].record_id == LAS_POINT_FAST_RECORD_ID))
+        {
+          // read the payload of this VLR which contains 8 bytes
+          //   U16  version                                        2 bytes 
+          //   U16  coder                                          2 bytes 
+          //   U32  chunk_size                                     4 bytes 
+
+          if (header.vlrs[i].record_length_after_header == 8)
+          {
+            U16 version, coder;
+            U32 chunk_size;
+            try { stream->get16bitsLE((U8*)&version); stream->get16bitsLE((U8*)&coder); stream->get32bitsLE((U8*)&chunk_size); } catch(...)
+            {
+              fprintf(stderr,"ERROR: reading payload of fast compression VLR\n");
+              return FALSE;
+            }
+            if ((version != LAS_POINT_FAST_VERSION) || (coder != LAS_POINT_FAST_CODER_LZ))
+            {
+              fprintf(stderr,"ERROR: unknown version %d or coder %d of fast compression\n", version, coder);
+              return FALSE;
+            }
+            fast_compressed = TRUE;
+          }
+          else
+          {
+            fprintf(stderr,"ERROR: record_length_after_header of VLR %s (%d) is %d instead of 8\n", header.vlrs[i].user_id, header.vlrs[i].record_id, header.vlrs[i].record_length_after_header);
+            return FALSE;
+          }
+        }
         else if (((strcmp(header.vlrs[i].user_id, "LAStools") == 0) && (header.vlrs[i].record_id == 10)) || (strcmp(header.vlrs[i].user_id, "lastools tile") == 0))
         {
           header.clean_lastiling();
@@ -830,7 +868,7 @@ bool LASreaderLAS::open(ByteStreamIn* stream, bool peek_only)
           fprintf(stderr,"WARNING: no payload for LASF_Spec (not specification-conform).\n");
         }
       }
-      else if ((strcmp(header.vlrs[i].user_id, "laszip encoded") == 0) || ((strcmp(header.vlrs[i].user_id, "LAStools") == 0) && (header.vlrs[i].record_id < 2000)) || (strcmp(header.vlrs[i].user_id, "lastools tile") == 0))
+      else if ((strcmp(header.vlrs[i].user_id, "laszip encoded") == 0) || ((strcmp(header.vlrs[i].user_id, "LAStools") == 0) && (header.vlrs[i].record_id < 2000)) || (strcmp(header.vlrs[i].user_id, "lastools tile") == 0) || ((strcmp(header.vlrs[i].user_id, LAS_POINT_FAST_USER_ID) == 0) && (header.vlrs[i].record_id == LAS_POINT_FAST_RECORD_ID)))
       {
         // we take our own VLRs with record IDs below 2000 away from everywhere
         header.offset_to_point_data -= (54+header.vlrs[i].record_length_after_header);
@@ -838,6 +876,15 @@ bool LASreaderLAS::open(ByteStreamIn* stream, bool peek_only)
         i--;
         header.number_of_variable_length_records--;
       }
+      else if (!keep_octree && LASoctree::is_octree_vlr(&(header.vlrs[i])))
+      {
+        // the octree hierarchy only describes the point order of this file
+        if (header.vlrs[i].data) delete [] header.vlrs[i].data;
+        header.offset_to_point_data -= (54+header.vlrs[i].record_length_after_header);
+        vlrs_size -= (54+header.vlrs[i].record_length_after_header);
+        i--;
+        header.number_of_variable_length_records--;
+      }
     }
   }
 
@@ -1201,7 +1248,16 @@ bool LASreaderLAS::open(ByteStreamIn* stream, bool peek_only)
 
   // remove extra bits in point data type
 
-  if ((header.point_data_format & 128) || (header.point_data_format & 64)) 
+  if (fast_compressed)
+  {
+    if (header.laszip || !(header.point_data_format & 64) || (header.point_data_format & 128))
+    {
+      fprintf(stderr,"ERROR: fast compression VLR does not match point data format %d\n", header.point_data_format);
+      return FALSE;
+    }
+    header.point_data_format &= 63;
+  }
+  else if ((header.point_data_format & 128) || (header.point_data_format & 64)) 
   {
     if (!header.laszip)
     {
@@ -1212,23 +1268,44 @@ bool LASreaderLAS::open(ByteStreamIn* stream, bool peek_only)
     header.point_data_format &= 127;
   }
 
-  // create the point reader
-
-  reader = new LASreadPoint();
+  // create the point reader and initialize point and the reader
 
-  // initialize point and the reader
-
-  if (header.laszip)
+  if (fast_compressed)
+  {
+    fastreader = new LASreadPointFast();
+    if (!point.init(&header, header.point_data_format, header.point_data_record_length, &header)) return FALSE;
+    if (!fastreader->setup(point.num_items, point.items)) return FALSE;
+  }
+  else if (header.laszip)
   {
+    reader = new LASreadPoint();
     if (!point.init(&header, header.laszip->num_items, header.laszip->items, &header)) return FALSE;
     if (!reader->setup(header.laszip->num_items, header.laszip->items, header.laszip)) return FALSE;
   }
   else
   {
+    reader = new LASreadPoint();
     if (!point.init(&header, header.point_data_format, header.point_data_record_length, &header)) return FALSE;
     if (!reader->setup(point.num_items, point.items)) return FALSE;
   }
 
+  // uncompressed standard points are unpacked from blocks of records with a routine for their format
+
+  if (rawreader) delete rawreader;
+  rawreader = 0;
+  raw_number = 0;
+  raw_current = 0;
+  raw_block = LAS_POINT_RAW_BLOCK;
+  if (reader && ((header.laszip == 0) || (header.laszip->compressor == LASZIP_COMPRESSOR_NONE)))
+  {
+    rawreader = new LASpointRaw();
+    if (!rawreader->setup(&point, header.point_data_format, header.point_data_record_length))
+    {
+      delete rawreader;
+      rawreader = 0;
+    }
+  }
+
   // maybe has internal EVLRs
 
   if (header.laszip && (header.laszip->number_of_special_evlrs > 0) && (header.laszip->offset_to_special_evlrs >= header.offset_to_point_data) && stream->isSeekable())
@@ -1275,13 +1352,41 @@ bool LASreaderLAS::open(ByteStreamIn* stream, bool peek_only)
     stream->seek(here);
   }
 
-  if (!reader->init(stream)) return FALSE;
+  // maybe the previous LASlib stage offers its points in shared memory
+
+  const LASvlr* vlr = (stream->isSeekable() ? 0 : header.get_vlr(LAS_SHARED_PIPE_USER_ID, LAS_SHARED_PIPE_RECORD_ID));
+  if (vlr)
+  {
+    if (vlr->record_length_after_header && (vlr->data[vlr->record_length_after_header-1] == '\0'))
+    {
+      sharedpipe = new LASsharedpipe();
+      if (!sharedpipe->attach((const CHAR*)vlr->data, point.total_point_size))
+      {
+        delete sharedpipe;
+        sharedpipe = 0;
+      }
+    }
+    header.remove_vlr(LAS_SHARED_PIPE_USER_ID, LAS_SHARED_PIPE_RECORD_ID);
+  }
+
+  if (fastreader)
+  {
+    if (!fastreader->init(stream)) return FALSE;
+  }
+  else if (!reader->init(stream))
+  {
+    return FALSE;
+  }
 
   return TRUE;
 }
 
 I32 LASreaderLAS::get_format() const
 {
+  if (fastreader)
+  {
+    return LAS_TOOLS_FORMAT_LAF;
+  }
   if (header.laszip)
   {
     return (header.laszip->compressor == LASZIP_COMPRESSOR_NONE ? LAS_TOOLS_FORMAT_LAS : LAS_TOOLS_FORMAT_LAZ);
@@ -1293,8 +1398,12 @@ bool LASreaderLAS::seek(const I64 p_index)
 {
   if (p_index < npoints)
   {
-    if (reader->seek((U32)p_count, (U32)p_index))
+    if (fastreader ? fastreader->seek((U32)p_count, (U32)p_index) : reader->seek((U32)p_count, (U32)p_index))
     {
+      raw_number = 0;
+      raw_current = 0;
+      // the next LAX interval may be short
+      raw_block = LAS_POINT_RAW_BLOCK_AFTER_SEEK;
       p_count = p_index;
       return TRUE;
     }
@@ -1302,11 +1411,46 @@ bool LASreaderLAS::seek(const I64 p_index)
   return FALSE;
 }
 
+// only uncompressed points have a fixed byte offset that can be prefetched
+bool LASreaderLAS::prefetch(const I64 p_start, const I64 p_end)
+{
+#ifdef POSIX_FADV_WILLNEED
+  if ((file == 0) || header.laszip || fastreader || (p_start > p_end) || (p_start >= npoints)) return FALSE;
+  I64 offset = header.offset_to_point_data + p_start*header.point_data_record_length;
+  I64 length = (p_end - p_start + 1)*header.point_data_record_length;
+  return (posix_fadvise(fileno(file), (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED) == 0);
+#else
+  return FALSE;
+#endif
+}
+
 bool LASreaderLAS::read_point_default()
 {
   if (p_count < npoints)
   {
-    if (reader->read(point.point) == FALSE)
+    if (sharedpipe)
+    {
+      if (!sharedpipe->read_point(&point))
+      {
+        fprintf(stderr,"WARNING: end-of-pipe after %u of %u points\n", (U32)p_count, (U32)npoints);
+        return FALSE;
+      }
+      p_count++;
+      return TRUE;
+    }
+    if (rawreader)
+    {
+      if ((raw_current == raw_number) && !read_raw_block())
+      {
+        fprintf(stderr,"WARNING: end-of-file after %u of %u points\n", (U32)p_count, (U32)npoints);
+        return FALSE;
+      }
+      rawreader->unpack(&point, &(raw_records[raw_current*rawreader->record_size]));
+      raw_current++;
+      p_count++;
+      return TRUE;
+    }
+    if ((fastreader ? fastreader->read(point.point) : reader->read(point.point)) == FALSE)
     {
       fprintf(stderr,"WARNING: end-of-file after %u of %u points\n", (U32)p_count, (U32)npoints);
       return FALSE;
@@ -1340,6 +1484,158 @@ bool LASreaderLAS::read_point_default()
   return FALSE;
 }
 
+bool LASreaderLAS::has_raw_points() const
+{
+  if ((reader == 0) || sharedpipe || filter || transform || inside) return FALSE;
+  if (header.laszip && (header.laszip->compressor != LASZIP_COMPRESSOR_NONE)) return FALSE;
+  return (header.point_data_format <= 5);
+}
+
+U32 LASreaderLAS::read_raw_points(U8* records, U32 number)
+{
+  if (!has_raw_points()) return 0;
+  if ((I64)number > (npoints - p_count)) number = (U32)(npoints - p_count);
+  if (number == 0) return 0;
+  // records that read_point() has already taken from the stream come first
+  U32 buffered = raw_number - raw_current;
+  if (buffered)
+  {
+    if (buffered > number) buffered = number;
+    memcpy(records, &(raw_records[raw_current*header.point_data_record_length]), buffered*header.point_data_record_length);
+    raw_current += buffered;
+    p_count += buffered;
+    return buffered;
+  }
+  try { stream->getBytes(records, number*header.point_data_record_length); } catch(...)
+  {
+    fprintf(stderr,"WARNING: end-of-file after %u of %u points\n", (U32)p_count, (U32)npoints);
+    return 0;
+  }
+  p_count += number;
+  return number;
+}
+
+bool LASreaderLAS::read_raw_block()
+{
+  if (raw_records == 0) raw_records = new U8[LAS_POINT_RAW_BLOCK*rawreader->record_size];
+  raw_current = 0;
+  raw_number = ((npoints - p_count) < raw_block ? (U32)(npoints - p_count) : raw_block);
+  if (raw_block < LAS_POINT_RAW_BLOCK) raw_block *= 2;
+  I64 start = stream->tell();
+  try { stream->getBytes(raw_records, raw_number*rawreader->record_size); } catch(...)
+  {
+    // keep the records that are complete in a truncated file
+    U32 number = raw_number;
+    raw_number = 0;
+    try
+    {
+      stream->seek(start);
+      while (raw_number < number)
+      {
+        stream->getBytes(&(raw_records[raw_number*rawreader->record_size]), rawreader->record_size);
+        raw_number++;
+      }
+    }
+    catch(...)
+    {
+    }
+    return (raw_number != 0);
+  }
+  return TRUE;
+}
+
+// decodes the chunk table in the same way as LASreadPoint does
+
+bool LASreaderLAS::read_chunk_table()
+{
+  if (chunk_starts) return TRUE;
+  if ((stream == 0) || (header.laszip == 0) || (header.laszip->compressor != LASZIP_COMPRESSOR_CHUNKED)) return FALSE;
+  if (!stream->isSeekable()) return FALSE;
+  U32 i;
+  I64 position = stream->tell();
+  I64 chunk_table_start_position;
+  U32 version;
+  bool success = FALSE;
+  try
+  {
+    stream->seek(header.offset_to_point_data);
+    stream->get64bitsLE((U8*)&chunk_table_start_position);
+    if (chunk_table_start_position == -1)
+    {
+      // written to a non-seekable stream the position is at the very end
+      stream->seekEnd(8);
+      stream->get64bitsLE((U8*)&chunk_table_start_position);
+    }
+    stream->seek(chunk_table_start_position);
+    stream->get32bitsLE((U8*)&version);
+    if (version == 0)
+    {
+      stream->get32bitsLE((U8*)&number_chunks);
+      chunk_points = new U32[number_chunks+1];
+      chunk_starts = new I64[number_chunks+1];
+      chunk_starts[0] = header.offset_to_point_data + 8;
+      if (number_chunks)
+      {
+        ArithmeticDecoder dec;
+        dec.init(stream);
+        IntegerCompressor ic(&dec, 32, 2);
+        ic.initDecompressor();
+        U32 chunk_size = header.laszip->chunk_size;
+        I32 bytes = 0;
+        for (i = 0; i < number_chunks; i++)
+        {
+          if (chunk_size == U32_MAX)
+            chunk_points[i] = (U32)ic.decompress((i ? (I32)chunk_points[i-1] : 0), 0);
+          else if (i < (number_chunks-1))
+            chunk_points[i] = chunk_size;
+          else
+            chunk_points[i] = (U32)(npoints - (I64)i*chunk_size);
+          bytes = ic.decompress(bytes, 1);
+          chunk_starts[i+1] = chunk_starts[i] + bytes;
+        }
+        dec.done();
+      }
+      success = TRUE;
+    }
+  }
+  catch (...)
+  {
+    fprintf(stderr,"WARNING: cannot read chunk table\n");
+  }
+  if (!success)
+  {
+    if (chunk_points) delete [] chunk_points;
+    if (chunk_starts) delete [] chunk_starts;
+    chunk_points = 0;
+    chunk_starts = 0;
+    number_chunks = 0;
+  }
+  stream->seek(position);
+  return success;
+}
+
+U32 LASreaderLAS::get_number_chunks()
+{
+  if (!read_chunk_table()) return 0;
+  return number_chunks;
+}
+
+bool LASreaderLAS::read_chunk(U32 chunk, U8* bytes)
+{
+  if (!read_chunk_table() || (chunk >= number_chunks)) return FALSE;
+  try
+  {
+    stream->seek(chunk_starts[chunk]);
+    stream->getBytes(bytes, get_chunk_bytes(chunk));
+  }
+  catch (...)
+  {
+    fprintf(stderr,"ERROR: cannot read %u bytes of chunk %u\n", get_chunk_bytes(chunk), chunk);
+    return FALSE;
+  }
+  return TRUE;
+}
+
 ByteStreamIn* LASreaderLAS::get_stream() const
 {
   return stream;
@@ -1347,12 +1643,44 @@ ByteStreamIn* LASreaderLAS::get_stream() const
 
 void LASreaderLAS::close(bool close_stream)
 {
+  if (sharedpipe)
+  {
+    delete sharedpipe;
+    sharedpipe = 0;
+  }
+  if (chunk_starts)
+  {
+    delete [] chunk_points;
+    delete [] chunk_starts;
+    chunk_points = 0;
+    chunk_starts = 0;
+    number_chunks = 0;
+  }
+  if (fastreader)
+  {
+    fastreader->done();
+    delete fastreader;
+    fastreader = 0;
+  }
   if (reader) 
   {
     reader->done();
     delete reader;
     reader = 0;
   }
+  if (rawreader)
+  {
+    delete rawreader;
+    rawreader = 0;
+  }
+  if (raw_records)
+  {
+    delete [] raw_records;
+    raw_records = 0;
+  }
+  raw_number = 0;
+  raw_current = 0;
+  raw_block = LAS_POINT_RAW_BLOCK;
   if (close_stream)
   {
     if (stream)
@@ -1373,11 +1701,22 @@ LASreaderLAS::LASreaderLAS()
   file = 0;
   stream = 0;
   reader = 0;
+  fastreader = 0;
+  sharedpipe = 0;
+  number_chunks = 0;
+  chunk_points = 0;
+  chunk_starts = 0;
+  keep_octree = FALSE;
+  rawreader = 0;
+  raw_records = 0;
+  raw_number = 0;
+  raw_current = 0;
+  raw_block = LAS_POINT_RAW_BLOCK;
 }
 
 LASreaderLAS::~LASreaderLAS()
 {
-  if (reader || stream) close(TRUE);
+  if (reader || stream || sharedpipe) close(TRUE);
 }
 
 LASreaderLASrescale::LASreaderLASrescale(F64 x_scale_factor, F64 y_scale_factor, F64 z_scale_factor) : LASreaderLAS()
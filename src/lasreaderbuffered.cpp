@@ -33,62 +33,85 @@
 #include "lasindex.hpp"
 #include "lasfilter.hpp"
 #include "lastransform.hpp"
+#include "bytestreamin_array.hpp"
+#include "bytestreamout_array.hpp"
+#include "lasreadpoint.hpp"
+#include "laswritepoint.hpp"
+#include "lasreader_las.hpp"
+#include "lasquadtree.hpp"
+#include "lascatalog.hpp"
+#include "lasthread.hpp"
 
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
 void LASreaderBuffered::set_scale_factor(const F64* scale_factor)
 {
   lasreadopener.set_scale_factor(scale_factor);
   lasreadopener_neighbors.set_scale_factor(scale_factor);
+  lasreadopener_cache.set_scale_factor(scale_factor);
 }
 
 void LASreaderBuffered::set_offset(const F64* offset)
 {
   lasreadopener.set_offset(offset);
   lasreadopener_neighbors.set_offset(offset);
+  lasreadopener_cache.set_offset(offset);
 }
 
 void LASreaderBuffered::set_translate_intensity(F32 translate_intensity)
 {
   lasreadopener.set_translate_intensity(translate_intensity);
   lasreadopener_neighbors.set_translate_intensity(translate_intensity);
+  lasreadopener_cache.set_translate_intensity(translate_intensity);
 }
 
 void LASreaderBuffered::set_scale_intensity(F32 scale_intensity)
 {
   lasreadopener.set_scale_intensity(scale_intensity);
   lasreadopener_neighbors.set_scale_intensity(scale_intensity);
+  lasreadopener_cache.set_scale_intensity(scale_intensity);
 }
 
 void LASreaderBuffered::set_translate_scan_angle(F32 translate_scan_angle)
 {
   lasreadopener.set_translate_scan_angle(translate_scan_angle);
   lasreadopener_neighbors.set_translate_scan_angle(translate_scan_angle);
+  lasreadopener_cache.set_translate_scan_angle(translate_scan_angle);
 }
 
 void LASreaderBuffered::set_scale_scan_angle(F32 scale_scan_angle)
 {
   lasreadopener.set_scale_scan_angle(scale_scan_angle);
   lasreadopener_neighbors.set_scale_scan_angle(scale_scan_angle);
+  lasreadopener_cache.set_scale_scan_angle(scale_scan_angle);
 }
 
 void LASreaderBuffered::set_parse_string(const char* parse_string)
 {
   lasreadopener.set_parse_string(parse_string);
   lasreadopener_neighbors.set_parse_string(parse_string);
+  lasreadopener_cache.set_parse_string(parse_string);
 }
 
 void LASreaderBuffered::set_skip_lines(I32 skip_lines)
 {
   lasreadopener.set_skip_lines(skip_lines);
   lasreadopener_neighbors.set_skip_lines(skip_lines);
+  lasreadopener_cache.set_skip_lines(skip_lines);
 }
 
 void LASreaderBuffered::set_populate_header(bool populate_header)
 {
   lasreadopener.set_populate_header(populate_header);
   lasreadopener_neighbors.set_populate_header(populate_header);
+  lasreadopener_cache.set_populate_header(populate_header);
 }
 
 bool LASreaderBuffered::set_file_name(const char* file_name)
@@ -138,6 +161,12 @@ void LASreaderBuffered::set_buffer_size(const F32 buffer_size)
   this->buffer_size = buffer_size;
 }
 
+void LASreaderBuffered::set_lastiling_neighbors(const bool lastiling_neighbors, const LAScatalog* catalog)
+{
+  this->lastiling_neighbors = lastiling_neighbors;
+  this->catalog = catalog;
+}
+
 bool LASreaderBuffered::open()
 {
   if (!lasreadopener.active())
@@ -179,82 +208,58 @@ bool LASreaderBuffered::open()
     if (!point.init(&header, header.point_data_format, header.point_data_record_length)) return FALSE;
   }
 
+  // maybe the tiling VLR tells us where the neighbors are
+
+  if (lastiling_neighbors && !lasreadopener_neighbors.active())
+  {
+    add_lastiling_neighbors();
+  }
+
   // maybe we have to look for neighbors from which we load buffer points
 
   if (lasreadopener_neighbors.active())
   {
-    F64 xyz;
-
     lasreadopener_neighbors.set_inside_rectangle(header.min_x - buffer_size, header.min_y - buffer_size, header.max_x + buffer_size, header.max_y + buffer_size);
 
     // store current counts and bounding box in LASoriginal VLR
 
     header.set_lasoriginal();
 
-    LASreader* lasreader_neighbor = lasreadopener_neighbors.open();
-    if (lasreader_neighbor == 0)
+    if (cache_budget)
     {
-      fprintf(stderr, "ERROR: opening neighbor '%s'\n", lasreadopener_neighbors.get_file_name());
-      return FALSE;
+      if (!read_neighbors_cached(header.min_x - buffer_size, header.min_y - buffer_size, header.max_x + buffer_size, header.max_y + buffer_size)) return FALSE;
     }
-
-    // a point type change could be problematic
-    if (header.point_data_format != lasreader_neighbor->header.point_data_format)
-    {
-      if (!point_type_change) fprintf(stderr, "WARNING: files have different point types: %d vs %d\n", header.point_data_format, lasreader_neighbor->header.point_data_format);
-      point_type_change = TRUE;
-    }
-    // a point size change could be problematic
-    if (header.point_data_record_length != lasreader_neighbor->header.point_data_record_length)
+    else if (lastiling_neighbors)
     {
-      if (!point_size_change) fprintf(stderr, "WARNING: files have different point sizes: %d vs %d\n", header.point_data_record_length, lasreader_neighbor->header.point_data_record_length);
-      point_size_change = TRUE;
+      if (!read_neighbors_concurrently(header.min_x - buffer_size, header.min_y - buffer_size, header.max_x + buffer_size, header.max_y + buffer_size)) return FALSE;
     }
-
-    while (lasreader_neighbor->read_point())
+    else
     {
-      // copy
-      point = lasreader_neighbor->point;
-      // copy_point_to_buffer
-      copy_point_to_buffer();
-      // increment number of points by return
-      if (point.return_number == 1)
-      {
-        header.number_of_points_by_return[0]++;
-      }
-      else if (point.return_number == 2)
-      {
-        header.number_of_points_by_return[1]++;
-      }
-      else if (point.return_number == 3)
+      LASreader* lasreader_neighbor = lasreadopener_neighbors.open();
+      if (lasreader_neighbor == 0)
       {
-        header.number_of_points_by_return[2]++;
+        fprintf(stderr, "ERROR: opening neighbor '%s'\n", lasreadopener_neighbors.get_file_name());
+        return FALSE;
       }
-      else if (point.return_number == 4)
-      {
-        header.number_of_points_by_return[3]++;
-      }
-      else if (point.return_number == 5)
+
+      check_point_type(lasreader_neighbor);
+
+      while (lasreader_neighbor->read_point())
       {
-        header.number_of_points_by_return[4]++;
+        // copy
+        point = lasreader_neighbor->point;
+        // copy_point_to_buffer and update header
+        add_neighbor_point();
       }
-      // grow bounding box
-      xyz = point.get_x();
-      if (header.min_x > xyz) header.min_x = xyz;
-      else if (header.max_x < xyz) header.max_x = xyz;
-      xyz = point.get_y();
-      if (header.min_y > xyz) header.min_y = xyz;
-      else if (header.max_y < xyz) header.max_y = xyz;
-      xyz = point.get_z();
-      if (header.min_z > xyz) header.min_z = xyz;
-      else if (header.max_z < xyz) header.max_z = xyz;
-    }
-    lasreader_neighbor->close();
-    delete lasreader_neighbor;
+      lasreader_neighbor->close();
+      delete lasreader_neighbor;
+    }
+
+    done_point_buffer();
 
     header.number_of_point_records += buffered_points;
 
-    fprintf(stderr, "LASreaderBuffered: adding %u buffer points.\n", buffered_points);
+    fprintf(stderr, "LASreaderBuffered: adding %u buffer points (%u bytes).\n", buffered_points, get_buffer_bytes());
   }
 
   // check if the header can support the enlarged bounding box
@@ -343,6 +348,73 @@ bool LASreaderBuffered::open()
   return TRUE;
 }
 
+void LASreaderBuffered::check_point_type(const LASreader* lasreader_neighbor)
+{
+  // a point type change could be problematic
+  if (header.point_data_format != lasreader_neighbor->header.point_data_format)
+  {
+    if (!point_type_change) fprintf(stderr, "WARNING: files have different point types: %d vs %d\n", header.point_data_format, lasreader_neighbor->header.point_data_format);
+    point_type_change = TRUE;
+  }
+  // a point size change could be problematic
+  if (header.point_data_record_length != lasreader_neighbor->header.point_data_record_length)
+  {
+    if (!point_size_change) fprintf(stderr, "WARNING: files have different point sizes: %d vs %d\n", header.point_data_record_length, lasreader_neighbor->header.point_data_record_length);
+    point_size_change = TRUE;
+  }
+}
+
+void LASreaderBuffered::add_neighbor_point()
+{
+  F64 xyz;
+  // copy_point_to_buffer
+  copy_point_to_buffer();
+  // increment number of points by return
+  if (point.return_number == 1)
+  {
+    header.number_of_points_by_return[0]++;
+  }
+  else if (point.return_number == 2)
+  {
+    header.number_of_points_by_return[1]++;
+  }
+  else if (point.return_number == 3)
+  {
+    header.number_of_points_by_return[2]++;
+  }
+  else if (point.return_number == 4)
+  {
+    header.number_of_points_by_return[3]++;
+  }
+  else if (point.return_number == 5)
+  {
+    header.number_of_points_by_return[4]++;
+  }
+  // grow bounding box
+  xyz = point.get_x();
+  if (header.min_x > xyz) header.min_x = xyz;
+  else if (header.max_x < xyz) header.max_x = xyz;
+  xyz = point.get_y();
+  if (header.min_y > xyz) header.min_y = xyz;
+  else if (header.max_y < xyz) header.max_y = xyz;
+  xyz = point.get_z();
+  if (header.min_z > xyz) header.min_z = xyz;
+  else if (header.max_z < xyz) header.max_z = xyz;
+}
+
+// neighbors may have their own scale and offset so their points are
+// quantized again with those of this file
+
+void LASreaderBuffered::copy_neighbor_point(const LASpoint* neighbor_point)
+{
+  point = *neighbor_point;
+  const LASquantizer* quantizer = neighbor_point->quantizer;
+  if ((quantizer == 0) || (quantizer == &header)) return;
+  if ((quantizer->x_scale_factor != header.x_scale_factor) || (quantizer->x_offset != header.x_offset)) point.set_x(neighbor_point->get_x());
+  if ((quantizer->y_scale_factor != header.y_scale_factor) || (quantizer->y_offset != header.y_offset)) point.set_y(neighbor_point->get_y());
+  if ((quantizer->z_scale_factor != header.z_scale_factor) || (quantizer->z_offset != header.z_offset)) point.set_z(neighbor_point->get_z());
+}
+
 bool LASreaderBuffered::reopen()
 {
   p_count = 0;
@@ -478,6 +550,31 @@ void LASreaderBuffered::clean()
 
 void LASreaderBuffered::clean_buffer()
 {
+  if (buffer_reader)
+  {
+    delete buffer_reader;
+    buffer_reader = 0;
+  }
+  if (buffer_stream_in)
+  {
+    delete buffer_stream_in;
+    buffer_stream_in = 0;
+  }
+  if (buffer_writer)
+  {
+    delete buffer_writer;
+    buffer_writer = 0;
+  }
+  if (buffer_stream_out)
+  {
+    delete buffer_stream_out;
+    buffer_stream_out = 0;
+  }
+  if (buffer_laszip)
+  {
+    delete buffer_laszip;
+    buffer_laszip = 0;
+  }
   if (buffers)
   {
     U32 i;
@@ -487,6 +584,8 @@ void LASreaderBuffered::clean_buffer()
     }
     free(buffers);
     buffers = 0;
+    free(buffer_bytes);
+    buffer_bytes = 0;
   }
   number_of_buffers = 0;
   current_buffer = 0;
@@ -494,31 +593,85 @@ void LASreaderBuffered::clean_buffer()
   point_count = 0;
 }
 
+// the buffer points are kept LAZ compressed in blocks of 'points_per_buffer'
+// points that are decompressed on the fly. points that LASzip cannot handle
+// are kept uncompressed.
+
 bool LASreaderBuffered::copy_point_to_buffer()
 {
   U32 point_count_in_buffer = (buffered_points % points_per_buffer);
   if (point_count_in_buffer == 0)
   {
+    done_point_buffer();
     if (buffers == 0)
     {
       size_of_buffers_array = 1024;
       buffers = (U8**)malloc(sizeof(U8*)*size_of_buffers_array);
+      buffer_bytes = (U32*)malloc(sizeof(U32)*size_of_buffers_array);
       number_of_buffers = 0;
+      buffer_laszip = new LASzip();
+      if (!buffer_laszip->setup(point.num_items, point.items, LASZIP_COMPRESSOR_POINTWISE))
+      {
+        delete buffer_laszip;
+        buffer_laszip = 0;
+      }
     }
     else if (number_of_buffers == size_of_buffers_array)
     {
       size_of_buffers_array *= 2;
       buffers = (U8**)realloc(buffers, sizeof(U8*)*size_of_buffers_array);
+      buffer_bytes = (U32*)realloc(buffer_bytes, sizeof(U32)*size_of_buffers_array);
+    }
+    if (buffer_laszip)
+    {
+      if (IS_LITTLE_ENDIAN())
+        buffer_stream_out = new ByteStreamOutArrayLE();
+      else
+        buffer_stream_out = new ByteStreamOutArrayBE();
+      buffer_writer = new LASwritePoint();
+      if (!buffer_writer->setup(buffer_laszip->num_items, buffer_laszip->items, buffer_laszip) || !buffer_writer->init(buffer_stream_out))
+      {
+        fprintf(stderr, "ERROR: cannot compress buffer points\n");
+        return FALSE;
+      }
+      buffers[number_of_buffers] = 0;
+      buffer_bytes[number_of_buffers] = 0;
+    }
+    else
+    {
+      buffers[number_of_buffers] = (U8*)malloc(point.total_point_size * points_per_buffer);
+      buffer_bytes[number_of_buffers] = point.total_point_size * points_per_buffer;
+      current_buffer = buffers[number_of_buffers];
     }
-    buffers[number_of_buffers] = (U8*)malloc(point.total_point_size * points_per_buffer);
-    current_buffer = buffers[number_of_buffers];
     number_of_buffers++;
   }
-  point.copy_to(&(current_buffer[point_count_in_buffer*point.total_point_size]));
+  if (buffer_writer)
+  {
+    buffer_writer->write(point.point);
+  }
+  else
+  {
+    point.copy_to(&(current_buffer[point_count_in_buffer*point.total_point_size]));
+  }
   buffered_points++;
   return TRUE;
 }
 
+// finishes the compressed block that is currently being written
+void LASreaderBuffered::done_point_buffer()
+{
+  if (buffer_writer)
+  {
+    buffer_writer->done();
+    delete buffer_writer;
+    buffer_writer = 0;
+    buffer_bytes[number_of_buffers-1] = (U32)buffer_stream_out->getSize();
+    buffers[number_of_buffers-1] = buffer_stream_out->takeData();
+    delete buffer_stream_out;
+    buffer_stream_out = 0;
+  }
+}
+
 bool LASreaderBuffered::copy_point_from_buffer()
 {
   if (point_count >= buffered_points)
@@ -530,19 +683,59 @@ bool LASreaderBuffered::copy_point_from_buffer()
   {
     U32 buffer_count = (point_count / points_per_buffer);
     current_buffer = buffers[buffer_count];
+    if (buffer_laszip)
+    {
+      if (buffer_reader) delete buffer_reader;
+      if (buffer_stream_in) delete buffer_stream_in;
+      if (IS_LITTLE_ENDIAN())
+        buffer_stream_in = new ByteStreamInArrayLE(current_buffer, buffer_bytes[buffer_count]);
+      else
+        buffer_stream_in = new ByteStreamInArrayBE(current_buffer, buffer_bytes[buffer_count]);
+      buffer_reader = new LASreadPoint();
+      if (!buffer_reader->setup(buffer_laszip->num_items, buffer_laszip->items, buffer_laszip) || !buffer_reader->init(buffer_stream_in))
+      {
+        fprintf(stderr, "ERROR: cannot decompress buffer points\n");
+        return FALSE;
+      }
+    }
+  }
+  if (buffer_reader)
+  {
+    buffer_reader->read(point.point);
+  }
+  else
+  {
+    point.copy_from(&(current_buffer[point_count_in_buffer*point.total_point_size]));
   }
-  point.copy_from(&(current_buffer[point_count_in_buffer*point.total_point_size]));
   point_count++;
   return TRUE;
 }
 
+U32 LASreaderBuffered::get_buffer_bytes() const
+{
+  U32 i, bytes = 0;
+  for (i = 0; i < number_of_buffers; i++)
+  {
+    bytes += buffer_bytes[i];
+  }
+  return bytes;
+}
+
 LASreaderBuffered::LASreaderBuffered() : points_per_buffer(10000)
 {
   lasreader = 0;
   lasreadopener_neighbors.set_merged(TRUE);
 
   buffer_size = 0.0f;
+  lastiling_neighbors = FALSE;
+  catalog = 0;
   buffers = 0;
+  buffer_bytes = 0;
+  buffer_laszip = 0;
+  buffer_writer = 0;
+  buffer_stream_out = 0;
+  buffer_reader = 0;
+  buffer_stream_in = 0;
   clean();
   clean_buffer();
 }
@@ -556,3 +749,620 @@ LASreaderBuffered::~LASreaderBuffered()
   if (lasreader) delete lasreader;
   clean_buffer();
 }
+
+// the points along the border (the rim) of each neighbor file are kept in a
+// process-wide cache so that consecutive tiles of a grid decode them once
+
+class LASreaderBufferedCached
+{
+public:
+  CHAR* file_name;
+  F64 min_x, min_y, max_x, max_y;
+  F32 rim;
+  bool loaded;
+  LASquantizer quantizer;
+  LASpoint point;
+  LASzip* laszip;
+  U8* data;
+  U32 bytes;
+  U32 number;
+  U32 stamp;
+  // are all points of this file inside the rectangle also in the rim
+  bool covers(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y) const
+  {
+    if ((min_x + rim) >= (max_x - rim)) return TRUE;
+    if ((min_y + rim) >= (max_y - rim)) return TRUE;
+    if (r_max_x <= (min_x + rim)) return TRUE;
+    if (r_min_x >= (max_x - rim)) return TRUE;
+    if (r_max_y <= (min_y + rim)) return TRUE;
+    if (r_min_y >= (max_y - rim)) return TRUE;
+    return FALSE;
+  }
+  bool in_rim(const LASpoint* point) const
+  {
+    F64 xy = point->get_x();
+    if ((xy < (min_x + rim)) || (xy >= (max_x - rim))) return TRUE;
+    xy = point->get_y();
+    if ((xy < (min_y + rim)) || (xy >= (max_y - rim))) return TRUE;
+    return FALSE;
+  }
+  void unload()
+  {
+    if (data) free(data);
+    data = 0;
+    bytes = 0;
+    number = 0;
+    loaded = FALSE;
+  }
+  LASreaderBufferedCached(const CHAR* file_name, const LASheader* header, const F32 rim)
+  {
+    this->file_name = strdup(file_name);
+    min_x = header->min_x;
+    min_y = header->min_y;
+    max_x = header->max_x;
+    max_y = header->max_y;
+    this->rim = rim;
+    loaded = FALSE;
+    laszip = 0;
+    data = 0;
+    bytes = 0;
+    number = 0;
+    stamp = 0;
+  }
+  ~LASreaderBufferedCached()
+  {
+    unload();
+    if (laszip) delete laszip;
+    free(file_name);
+  }
+};
+
+static LASreaderBufferedCached** cache_entries = 0;
+static U32 cache_number = 0;
+static U32 cache_alloc = 0;
+static I64 cache_bytes = 0;
+static U32 cache_stamp = 0;
+I64 LASreaderBuffered::cache_budget = 0;
+
+void LASreaderBuffered::set_cache_budget(const I64 bytes)
+{
+  cache_budget = bytes;
+  if (cache_budget == 0)
+  {
+    while (cache_number)
+    {
+      cache_number--;
+      delete cache_entries[cache_number];
+    }
+    free(cache_entries);
+    cache_entries = 0;
+    cache_alloc = 0;
+    cache_bytes = 0;
+  }
+}
+
+// the file will not be a neighbor again (e.g. says the tile scheduler)
+void LASreaderBuffered::release_cached(const CHAR* file_name)
+{
+  for (U32 i = 0; i < cache_number; i++)
+  {
+    if (strcmp(cache_entries[i]->file_name, file_name) == 0)
+    {
+      cache_bytes -= cache_entries[i]->bytes;
+      delete cache_entries[i];
+      cache_number--;
+      cache_entries[i] = cache_entries[cache_number];
+      return;
+    }
+  }
+}
+
+// evicts the least recently used rims until the cache fits into the budget
+static void evict_cached(const LASreaderBufferedCached* keep)
+{
+  while (cache_bytes > LASreaderBuffered::get_cache_budget())
+  {
+    LASreaderBufferedCached* oldest = 0;
+    for (U32 i = 0; i < cache_number; i++)
+    {
+      if (cache_entries[i]->loaded && (cache_entries[i] != keep) && ((oldest == 0) || (cache_entries[i]->stamp < oldest->stamp)))
+      {
+        oldest = cache_entries[i];
+      }
+    }
+    if (oldest == 0) break;
+    cache_bytes -= oldest->bytes;
+    oldest->unload();
+  }
+}
+
+bool LASreaderBuffered::read_neighbors_cached(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y)
+{
+  U32 i, j;
+  for (i = 0; i < lasreadopener_neighbors.get_file_name_number(); i++)
+  {
+    const CHAR* file_name = lasreadopener_neighbors.get_file_name(i);
+    LASreaderBufferedCached* cached = 0;
+    for (j = 0; j < cache_number; j++)
+    {
+      if (strcmp(cache_entries[j]->file_name, file_name) == 0)
+      {
+        cached = cache_entries[j];
+        break;
+      }
+    }
+    if (cached && (cached->rim != buffer_size))
+    {
+      release_cached(file_name);
+      cached = 0;
+    }
+    // skip files whose bounding box does not overlap
+    if (cached && ((cached->min_x >= r_max_x) || (cached->min_y >= r_max_y) || (cached->max_x < r_min_x) || (cached->max_y < r_min_y)))
+    {
+      continue;
+    }
+    LASreader* lasreader_neighbor = 0;
+    if ((cached == 0) || !cached->loaded || !cached->covers(r_min_x, r_min_y, r_max_x, r_max_y))
+    {
+      lasreader_neighbor = lasreadopener_cache.open(file_name);
+      if (lasreader_neighbor == 0)
+      {
+        fprintf(stderr, "ERROR: opening neighbor '%s'\n", file_name);
+        return FALSE;
+      }
+      check_point_type(lasreader_neighbor);
+      if (cached == 0)
+      {
+        // first time this file is seen
+        cached = new LASreaderBufferedCached(file_name, &lasreader_neighbor->header, buffer_size);
+        cached->quantizer = lasreader_neighbor->header;
+        cached->point.init(&cached->quantizer, lasreader_neighbor->point.num_items, lasreader_neighbor->point.items);
+        // the rim is kept LAZ compressed like the buffer points
+        cached->laszip = new LASzip();
+        if (!cached->laszip->setup(cached->point.num_items, cached->point.items, LASZIP_COMPRESSOR_POINTWISE))
+        {
+          delete cached->laszip;
+          cached->laszip = 0;
+        }
+        if (cache_number == cache_alloc)
+        {
+          cache_alloc = (cache_alloc ? 2*cache_alloc : 256);
+          cache_entries = (LASreaderBufferedCached**)realloc(cache_entries, sizeof(LASreaderBufferedCached*)*cache_alloc);
+        }
+        cache_entries[cache_number] = cached;
+        cache_number++;
+        if ((cached->min_x >= r_max_x) || (cached->min_y >= r_max_y) || (cached->max_x < r_min_x) || (cached->max_y < r_min_y))
+        {
+          lasreader_neighbor->close();
+          delete lasreader_neighbor;
+          continue;
+        }
+      }
+      if (!cached->loaded && cached->covers(r_min_x, r_min_y, r_max_x, r_max_y))
+      {
+        load_cached(lasreader_neighbor, cached);
+        lasreader_neighbor->close();
+        delete lasreader_neighbor;
+        lasreader_neighbor = 0;
+      }
+    }
+    if (lasreader_neighbor)
+    {
+      // the rim is not enough (e.g. overlapping tiles or a huge buffer)
+      if (filter) lasreader_neighbor->set_filter(filter);
+      if (transform) lasreader_neighbor->set_transform(transform);
+      lasreader_neighbor->inside_rectangle(r_min_x, r_min_y, r_max_x, r_max_y);
+      while (lasreader_neighbor->read_point())
+      {
+        copy_neighbor_point(&lasreader_neighbor->point);
+        add_neighbor_point();
+      }
+      lasreader_neighbor->close();
+      delete lasreader_neighbor;
+      continue;
+    }
+    cached->stamp = ++cache_stamp;
+    U32 size = cached->point.total_point_size;
+    ByteStreamInArray* stream = 0;
+    LASreadPoint* reader = 0;
+    if (cached->laszip && cached->number)
+    {
+      if (IS_LITTLE_ENDIAN())
+        stream = new ByteStreamInArrayLE(cached->data, cached->bytes);
+      else
+        stream = new ByteStreamInArrayBE(cached->data, cached->bytes);
+      reader = new LASreadPoint();
+      if (!reader->setup(cached->laszip->num_items, cached->laszip->items, cached->laszip) || !reader->init(stream))
+      {
+        fprintf(stderr, "ERROR: cannot decompress cached rim of '%s'\n", cached->file_name);
+        delete reader;
+        delete stream;
+        return FALSE;
+      }
+    }
+    for (j = 0; j < cached->number; j++)
+    {
+      if (reader)
+      {
+        if (!reader->read(cached->point.point)) break;
+      }
+      else
+      {
+        cached->point.copy_from(&(cached->data[j*size]));
+      }
+      if (!cached->point.inside_rectangle(r_min_x, r_min_y, r_max_x, r_max_y)) continue;
+      copy_neighbor_point(&cached->point);
+      if (filter && filter->filter(&point)) continue;
+      if (transform) transform->transform(&point);
+      add_neighbor_point();
+    }
+    if (reader)
+    {
+      reader->done();
+      delete reader;
+      delete stream;
+    }
+    if (cache_bytes > cache_budget)
+    {
+      evict_cached(0);
+    }
+  }
+  return TRUE;
+}
+
+// decodes the rim of the neighbor. with a LAX only the four strips are read
+void LASreaderBuffered::load_cached(LASreader* lasreader_neighbor, LASreaderBufferedCached* cached)
+{
+  U32 alloc = 0;
+  U32 size = cached->point.total_point_size;
+  ByteStreamOutArray* stream = 0;
+  LASwritePoint* writer = 0;
+  if (cached->laszip)
+  {
+    if (IS_LITTLE_ENDIAN())
+      stream = new ByteStreamOutArrayLE();
+    else
+      stream = new ByteStreamOutArrayBE();
+    writer = new LASwritePoint();
+    if (!writer->setup(cached->laszip->num_items, cached->laszip->items, cached->laszip) || !writer->init(stream))
+    {
+      // keep this rim uncompressed
+      delete writer;
+      writer = 0;
+      delete stream;
+      stream = 0;
+    }
+  }
+  F64 hi_x = cached->max_x + cached->quantizer.x_scale_factor;
+  F64 hi_y = cached->max_y + cached->quantizer.y_scale_factor;
+  F64 strips[16];
+  U32 s, number_strips = 1;
+  if (lasreader_neighbor->get_index() && ((cached->min_x + cached->rim) < (cached->max_x - cached->rim)) && ((cached->min_y + cached->rim) < (cached->max_y - cached->rim)))
+  {
+    F64 lo_x = cached->min_x + cached->rim;
+    F64 lo_y = cached->min_y + cached->rim;
+    F64 up_x = cached->max_x - cached->rim;
+    F64 up_y = cached->max_y - cached->rim;
+    F64 s0[16] = { cached->min_x, cached->min_y, hi_x, lo_y,   // bottom
+                   cached->min_x, up_y, hi_x, hi_y,            // top
+                   cached->min_x, lo_y, lo_x, up_y,            // left
+                   up_x, lo_y, hi_x, up_y };                   // right
+    memcpy(strips, s0, sizeof(strips));
+    number_strips = 4;
+  }
+  for (s = 0; s < number_strips; s++)
+  {
+    if (number_strips > 1)
+    {
+      lasreader_neighbor->inside_none();
+      lasreader_neighbor->inside_rectangle(strips[4*s+0], strips[4*s+1], strips[4*s+2], strips[4*s+3]);
+    }
+    while (lasreader_neighbor->read_point())
+    {
+      if ((number_strips == 1) && !cached->in_rim(&lasreader_neighbor->point)) continue;
+      if (writer)
+      {
+        writer->write(lasreader_neighbor->point.point);
+      }
+      else
+      {
+        if (cached->number == alloc)
+        {
+          alloc = (alloc ? 2*alloc : 1024);
+          cached->data = (U8*)realloc(cached->data, size*alloc);
+        }
+        lasreader_neighbor->point.copy_to(&(cached->data[cached->number*size]));
+      }
+      cached->number++;
+    }
+  }
+  if (writer)
+  {
+    writer->done();
+    delete writer;
+    cached->bytes = (U32)stream->getSize();
+    cached->data = stream->takeData();
+    delete stream;
+  }
+  else
+  {
+    if (cached->number) cached->data = (U8*)realloc(cached->data, size*cached->number);
+    cached->bytes = cached->number * size;
+    // so that the rim is not decompressed later
+    if (cached->laszip) delete cached->laszip;
+    cached->laszip = 0;
+  }
+  cached->loaded = TRUE;
+  cache_bytes += cached->bytes;
+  if (cache_bytes > cache_budget)
+  {
+    evict_cached(cached);
+  }
+}
+
+// the names of the LAS/LAZ files in a directory are only listed once and
+// the tiling VLR of each file is only read once when it is first needed
+
+class LASreaderBufferedTiling
+{
+public:
+  CHAR* file_name;
+  bool read;
+  bool tiled;
+  LASvlr_lastiling lastiling;
+};
+
+static CHAR** tiling_directories = 0;
+static U32 tiling_directory_number = 0;
+static LASreaderBufferedTiling* tilings = 0;
+static U32 tiling_number = 0;
+static U32 tiling_alloc = 0;
+
+static void add_tiling(const CHAR* directory, const CHAR* name)
+{
+  I32 len = (I32)strlen(name);
+  if ((len < 4) || !((strcmp(&name[len-4], ".las") == 0) || (strcmp(&name[len-4], ".laz") == 0) || (strcmp(&name[len-4], ".LAS") == 0) || (strcmp(&name[len-4], ".LAZ") == 0) || (strcmp(&name[len-4], ".laf") == 0) || (strcmp(&name[len-4], ".LAF") == 0))) return;
+  if (tiling_number == tiling_alloc)
+  {
+    tiling_alloc = (tiling_alloc ? 2*tiling_alloc : 256);
+    tilings = (LASreaderBufferedTiling*)realloc(tilings, sizeof(LASreaderBufferedTiling)*tiling_alloc);
+  }
+  CHAR* file_name = (CHAR*)malloc(strlen(directory)+len+1);
+  strcpy(file_name, directory);
+  strcat(file_name, name);
+  tilings[tiling_number].file_name = file_name;
+  tilings[tiling_number].read = FALSE;
+  tilings[tiling_number].tiled = FALSE;
+  tiling_number++;
+}
+
+static const LASvlr_lastiling* get_tiling(U32 i)
+{
+  if (!tilings[i].read)
+  {
+    LASreaderLAS lasreaderlas;
+    if (lasreaderlas.open(tilings[i].file_name) && lasreaderlas.header.vlr_lastiling)
+    {
+      tilings[i].lastiling = *(lasreaderlas.header.vlr_lastiling);
+      tilings[i].tiled = TRUE;
+    }
+    lasreaderlas.close();
+    tilings[i].read = TRUE;
+  }
+  return (tilings[i].tiled ? &(tilings[i].lastiling) : 0);
+}
+
+// lastile names the tiles after their lower left corner. when this tile is
+// named that way only the files named after a neighbor need to be opened
+
+static bool is_named_after(const CHAR* file_name, const F64 min_x, const F64 min_y)
+{
+  CHAR x[32], y[32];
+  sprintf(x, "%d", (I32)(min_x < 0 ? min_x - 0.5 : min_x + 0.5));
+  sprintf(y, "%d", (I32)(min_y < 0 ? min_y - 0.5 : min_y + 0.5));
+  const CHAR* found_x = strstr(file_name, x);
+  return (found_x && strstr(found_x + strlen(x), y));
+}
+
+static void scan_tiling_directory(const CHAR* directory)
+{
+  U32 i;
+  for (i = 0; i < tiling_directory_number; i++)
+  {
+    if (strcmp(tiling_directories[i], directory) == 0) return;
+  }
+  tiling_directories = (CHAR**)realloc(tiling_directories, sizeof(CHAR*)*(tiling_directory_number+1));
+  tiling_directories[tiling_directory_number] = strdup(directory);
+  tiling_directory_number++;
+#ifdef _WIN32
+  WIN32_FIND_DATA info;
+  CHAR* pattern = (CHAR*)malloc(strlen(directory)+6);
+  sprintf(pattern, "%s*.la?", directory);
+  HANDLE h = FindFirstFile(pattern, &info);
+  free(pattern);
+  if (h != INVALID_HANDLE_VALUE)
+  {
+    do
+    {
+      add_tiling(directory, info.cFileName);
+    } while (FindNextFile(h, &info));
+    FindClose(h);
+  }
+#else
+  DIR* dir = opendir(directory[0] ? directory : ".");
+  if (dir)
+  {
+    struct dirent* entry;
+    while ((entry = readdir(dir)))
+    {
+      add_tiling(directory, entry->d_name);
+    }
+    closedir(dir);
+  }
+#endif
+}
+
+// finds the (up to) eight tiles around this one in the same tiling
+
+void LASreaderBuffered::add_lastiling_neighbors()
+{
+  if (header.vlr_lastiling == 0)
+  {
+    fprintf(stderr, "WARNING: '%s' has no lastiling VLR. no neighbors for buffer.\n", lasreadopener.get_file_name());
+    return;
+  }
+  const LASvlr_lastiling* lastiling = header.vlr_lastiling;
+  LASquadtree lasquadtree;
+  lasquadtree.tiling_setup(lastiling->min_x, lastiling->max_x, lastiling->min_y, lastiling->max_y, lastiling->level);
+  F64 min[2], max[2];
+  lasquadtree.get_cell_bounding_box(lastiling->level_index, lastiling->level, min, max);
+  F64 size_x = max[0] - min[0];
+  F64 size_y = max[1] - min[1];
+  U32 neighbors[8];
+  F64 neighbor_min_x[8], neighbor_min_y[8];
+  U32 i, j, number_neighbors = 0;
+  I32 dx, dy;
+  for (dy = -1; dy <= 1; dy++)
+  {
+    for (dx = -1; dx <= 1; dx++)
+    {
+      if ((dx == 0) && (dy == 0)) continue;
+      F64 x = (min[0] + max[0])/2 + dx*size_x;
+      F64 y = (min[1] + max[1])/2 + dy*size_y;
+      if ((x < lastiling->min_x) || (x >= lastiling->max_x) || (y < lastiling->min_y) || (y >= lastiling->max_y)) continue;
+      neighbors[number_neighbors] = lasquadtree.get_level_index(x, y, lastiling->level);
+      neighbor_min_x[number_neighbors] = x - size_x/2;
+      neighbor_min_y[number_neighbors] = y - size_y/2;
+      number_neighbors++;
+    }
+  }
+  if (catalog)
+  {
+    // files of the catalog whose centers fall into the neighboring tiles
+    for (i = 0; i < catalog->get_number_entries(); i++)
+    {
+      const LAScatalogEntry* entry = catalog->get_entry(i);
+      F64 x = (entry->min_x + entry->max_x)/2;
+      F64 y = (entry->min_y + entry->max_y)/2;
+      for (j = 0; j < number_neighbors; j++)
+      {
+        if ((neighbor_min_x[j] <= x) && (x < (neighbor_min_x[j] + size_x)) && (neighbor_min_y[j] <= y) && (y < (neighbor_min_y[j] + size_y)))
+        {
+          add_neighbor_file_name(catalog->get_file_name(i));
+          break;
+        }
+      }
+    }
+  }
+  else
+  {
+    // files in the same directory that are the neighboring tiles
+    const CHAR* file_name = lasreadopener.get_file_name();
+    I32 len = (I32)strlen(file_name);
+    while ((len > 0) && (file_name[len-1] != '\\') && (file_name[len-1] != '/') && (file_name[len-1] != ':')) len--;
+    CHAR* directory = (CHAR*)malloc(len+1);
+    strncpy(directory, file_name, len);
+    directory[len] = '\0';
+    scan_tiling_directory(directory);
+    bool by_name = is_named_after(&(file_name[len]), min[0], min[1]);
+    for (i = 0; i < tiling_number; i++)
+    {
+      if (strncmp(tilings[i].file_name, directory, len) || strchr(&(tilings[i].file_name[len]), '/') || strchr(&(tilings[i].file_name[len]), '\\')) continue;
+      if (by_name)
+      {
+        for (j = 0; j < number_neighbors; j++)
+        {
+          if (is_named_after(&(tilings[i].file_name[len]), neighbor_min_x[j], neighbor_min_y[j])) break;
+        }
+        if (j == number_neighbors) continue;
+      }
+      const LASvlr_lastiling* other = get_tiling(i);
+      if (other == 0) continue;
+      if ((other->level != lastiling->level) || (other->min_x != lastiling->min_x) || (other->max_x != lastiling->max_x) || (other->min_y != lastiling->min_y) || (other->max_y != lastiling->max_y)) continue;
+      for (j = 0; j < number_neighbors; j++)
+      {
+        if (other->level_index == neighbors[j])
+        {
+          add_neighbor_file_name(tilings[i].file_name);
+          break;
+        }
+      }
+    }
+    free(directory);
+  }
+}
+
+// each neighbor delivers the points in its strip on a thread of its own
+
+class LASreaderBufferedStrip
+{
+public:
+  LASthread thread;
+  LASreader* lasreader;
+  U8* data;
+  U32 number;
+  U32 alloc;
+};
+
+static void read_strip(void* data)
+{
+  LASreaderBufferedStrip* strip = (LASreaderBufferedStrip*)data;
+  U32 size = strip->lasreader->point.total_point_size;
+  while (strip->lasreader->read_point())
+  {
+    if (strip->number == strip->alloc)
+    {
+      strip->alloc = (strip->alloc ? 2*strip->alloc : 1024);
+      strip->data = (U8*)realloc(strip->data, size*strip->alloc);
+    }
+    strip->lasreader->point.copy_to(&(strip->data[strip->number*size]));
+    strip->number++;
+  }
+}
+
+bool LASreaderBuffered::read_neighbors_concurrently(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y)
+{
+  U32 i, j, number_strips = lasreadopener_neighbors.get_file_name_number();
+  LASreaderBufferedStrip* strips = new LASreaderBufferedStrip[number_strips];
+  bool success = TRUE;
+  for (i = 0; i < number_strips; i++)
+  {
+    strips[i].data = 0;
+    strips[i].number = 0;
+    strips[i].alloc = 0;
+    // the opener also loads the LAX so that only the strip is decompressed
+    strips[i].lasreader = lasreadopener_cache.open(lasreadopener_neighbors.get_file_name(i));
+    if (strips[i].lasreader == 0)
+    {
+      fprintf(stderr, "ERROR: opening neighbor '%s'\n", lasreadopener_neighbors.get_file_name(i));
+      success = FALSE;
+      continue;
+    }
+    check_point_type(strips[i].lasreader);
+    strips[i].lasreader->inside_rectangle(r_min_x, r_min_y, r_max_x, r_max_y);
+    if (!strips[i].thread.start(read_strip, &strips[i]))
+    {
+      read_strip(&strips[i]);
+    }
+  }
+  for (i = 0; i < number_strips; i++)
+  {
+    strips[i].thread.join();
+    if (strips[i].lasreader == 0) continue;
+    LASpoint* neighbor_point = &(strips[i].lasreader->point);
+    U32 size = neighbor_point->total_point_size;
+    for (j = 0; j < strips[i].number; j++)
+    {
+      neighbor_point->copy_from(&(strips[i].data[j*size]));
+      copy_neighbor_point(neighbor_point);
+      if (filter && filter->filter(&point)) continue;
+      if (transform) transform->transform(&point);
+      add_neighbor_point();
+    }
+    strips[i].lasreader->close();
+    delete strips[i].lasreader;
+    if (strips[i].data) free(strips[i].data);
+  }
+  delete [] strips;
+  return success;
+}
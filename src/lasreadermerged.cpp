@@ -33,10 +33,16 @@
 #include "lasindex.hpp"
 #include "lasfilter.hpp"
 #include "lastransform.hpp"
+#include "lasthread.hpp"
+#include "lascatalog.hpp"
+#include "lasrtree.hpp"
 
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+using namespace std;
+
 void LASreaderMerged::set_io_ibuffer_size(I32 io_ibuffer_size)
 {
   this->io_ibuffer_size = io_ibuffer_size;
@@ -50,16 +56,19 @@ bool LASreaderMerged::add_file_name(const char* file_name)
     fprintf(stderr, "ERROR: file name pointer is NULL\n");
     return FALSE;
   }
-  // does the file exist
-  FILE* file = fopen(file_name, "r");
-  if (file == 0)
+  // does the file exist (unless the catalog knows it)
+  if ((catalog == 0) || (catalog->find_entry(file_name) == -1))
   {
-    fprintf(stderr, "ERROR: file '%s' cannot be opened\n", file_name);
-    return FALSE;
+    FILE* file = fopen(file_name, "r");
+    if (file == 0)
+    {
+      fprintf(stderr, "ERROR: file '%s' cannot be opened\n", file_name);
+      return FALSE;
+    }
+    fclose(file);
   }
-  fclose(file);
   // check file extension
-  if (strstr(file_name, ".las") || strstr(file_name, ".laz") || strstr(file_name, ".LAS") || strstr(file_name, ".LAZ"))
+  if (strstr(file_name, ".las") || strstr(file_name, ".laz") || strstr(file_name, ".LAS") || strstr(file_name, ".LAZ") || strstr(file_name, ".laf") || strstr(file_name, ".LAF"))
   {
     if (lasreaderbin)
     {
@@ -508,6 +517,104 @@ void LASreaderMerged::set_keep_lastiling(bool keep_lastiling)
   this->keep_lastiling = keep_lastiling;
 }
 
+void LASreaderMerged::set_auto_index(bool auto_index)
+{
+  this->auto_index = auto_index;
+}
+
+void LASreaderMerged::set_auto_index_directory(const CHAR* auto_index_directory)
+{
+  if (this->auto_index_directory) free(this->auto_index_directory);
+  this->auto_index_directory = (auto_index_directory ? strdup(auto_index_directory) : 0);
+}
+
+void LASreaderMerged::set_peek_threads(U32 peek_threads)
+{
+  this->peek_threads = peek_threads;
+}
+
+void LASreaderMerged::set_prefetch_files(U32 prefetch_files)
+{
+  stop_prefetch();
+  this->prefetch_files = prefetch_files;
+}
+
+void LASreaderMerged::set_interleave(U32 interleave)
+{
+  this->interleave = interleave;
+}
+
+void LASreaderMerged::set_gps_time_merge(bool gps_time_merge, bool gps_time_check)
+{
+  this->gps_time_merge = gps_time_merge;
+  this->gps_time_check = gps_time_check;
+}
+
+void LASreaderMerged::set_catalog(const LAScatalog* catalog)
+{
+  this->catalog = catalog;
+}
+
+void LASreaderMerged::set_write_catalog(const CHAR* write_catalog)
+{
+  if (this->write_catalog) free(this->write_catalog);
+  this->write_catalog = (write_catalog ? strdup(write_catalog) : 0);
+}
+
+// the work shared by the threads that peek into the headers
+typedef struct LASreaderMergedPeeking
+{
+  LASmutex mutex;
+  U32 next;
+  U32 number;
+  CHAR** file_names;
+  const LAScatalog* catalog;
+  bool check_catalog;
+  LAScatalogEntry* entries;
+  bool* unchecked;
+} LASreaderMergedPeeking;
+
+// each thread takes the next file until none are left. the entries are stored
+// by file so that they get merged in the same order as when done serially. a
+// file with a catalog entry is not touched at all and its entry is checked
+// against the modification time of the file once it is first used to prune
+// files in check_catalog_entries() or to read it in open_lasreaderlas(). only
+// when a new catalog is written are all entries checked right away.
+static void peek_headers(void* data)
+{
+  LASreaderMergedPeeking* peeking = (LASreaderMergedPeeking*)data;
+  LASreaderLAS lasreaderlas;
+  U32 i;
+  I32 c;
+  while (TRUE)
+  {
+    peeking->mutex.lock();
+    i = peeking->next;
+    peeking->next++;
+    peeking->mutex.unlock();
+    if (i >= peeking->number) break;
+    LAScatalogEntry* entry = &peeking->entries[i];
+    if (peeking->catalog && ((c = peeking->catalog->find_entry(peeking->file_names[i])) != -1) && peeking->catalog->get_entry(c)->valid)
+    {
+      if (!peeking->check_catalog)
+      {
+        *entry = *(peeking->catalog->get_entry(c));
+        peeking->unchecked[i] = TRUE;
+        continue;
+      }
+      if (peeking->catalog->is_current(c))
+      {
+        *entry = *(peeking->catalog->get_entry(c));
+        continue;
+      }
+    }
+    entry->mtime = LAScatalog::get_mtime(peeking->file_names[i]);
+    if (!lasreaderlas.open(peeking->file_names[i], 512, TRUE)) continue;
+    entry->set(&lasreaderlas);
+    lasreaderlas.close();
+  }
+}
+
 bool LASreaderMerged::open()
 {
   if (file_name_number == 0)
@@ -516,16 +623,63 @@ bool LASreaderMerged::open()
     return FALSE;
   }
 
+  stop_prefetch();
+  stop_interleaving();
+  stop_gps_time_merge();
+
   // allocate space for the individual bounding_boxes
   if (bounding_boxes) delete [] bounding_boxes;
   bounding_boxes = new F64[file_name_number*4];
+  if (file_rtree)
+  {
+    delete file_rtree;
+    file_rtree = 0;
+    delete [] file_hits;
+    file_hits = 0;
+  }
+  if (unchecked)
+  {
+    delete [] unchecked;
+    unchecked = 0;
+  }
 
   // clean  header
   header.clean();
 
+  U32 i;
+
+  // with many LAS files (often on a network drive) a few threads peek into the
+  // headers of all but the first file concurrently (or take them from a catalog)
+
+  LAScatalogEntry* entries = 0;
+  if (lasreaderlas && (file_name_number > 1))
+  {
+    LASreaderMergedPeeking peeking;
+    peeking.next = 1;
+    peeking.number = file_name_number;
+    peeking.file_names = file_names;
+    peeking.catalog = catalog;
+    peeking.check_catalog = (write_catalog != 0);
+    peeking.entries = entries = new LAScatalogEntry[file_name_number];
+    if (catalog)
+    {
+      unchecked = new bool[file_name_number];
+      for (i = 0; i < file_name_number; i++) unchecked[i] = FALSE;
+    }
+    peeking.unchecked = unchecked;
+    U32 number_threads = (peek_threads < file_name_number - 1 ? peek_threads : file_name_number - 1);
+    LASthread* threads = (number_threads > 1 ? new LASthread[number_threads - 1] : 0);
+    for (i = 1; i < number_threads; i++)
+    {
+      if (!threads[i-1].start(peek_headers, &peeking)) break;
+    }
+    // the calling thread helps out (or does all the work if no thread started)
+    peek_headers(&peeking);
+    if (threads) delete [] threads; // joins them
+  }
+
   // combine all headers
 
-  U32 i;
   bool first = TRUE;
   U32 buffer_warning = 0;
   for (i = 0; i < file_name_number; i++)
@@ -533,11 +687,29 @@ bool LASreaderMerged::open()
     // open the lasreader with the next file name
     if (lasreaderlas)
     {
-      if (!lasreaderlas->open(file_names[i], 512, (first == FALSE))) // starting from second just "peek" into file to get bounding box and count
+      if (entries && (first == FALSE))
+      {
+        // use what was peeked from the header
+        if (!entries[i].valid)
+        {
+          fprintf(stderr, "ERROR: could not open lasreaderlas for file '%s'\n", file_names[i]);
+          delete [] entries;
+          return FALSE;
+        }
+        entries[i].get(lasreaderlas);
+        if (entries[i].buffered) buffer_warning++;
+      }
+      else if (!lasreaderlas->open(file_names[i], 512, (first == FALSE))) // starting from second just "peek" into file to get bounding box and count
       {
         fprintf(stderr, "ERROR: could not open lasreaderlas for file '%s'\n", file_names[i]);
+        if (entries) delete [] entries;
         return FALSE;
       }
+      else if (entries)
+      {
+        entries[i].mtime = LAScatalog::get_mtime(file_names[i]);
+        entries[i].set(lasreaderlas);
+      }
     }
     else if (lasreaderbin)
     {
@@ -619,7 +791,7 @@ bool LASreaderMerged::open()
       bounding_boxes[4*i+3] = lasreader->header.max_y;
     }
     // check for buffer
-    if (lasreader->header.vlr_lastiling)
+    if ((entries == 0 || first) && lasreader->header.vlr_lastiling)
     {
       if (lasreader->header.vlr_lastiling->buffer)
       {
@@ -729,6 +901,19 @@ bool LASreaderMerged::open()
     lasreader->close();
   }
 
+  // optionally remember all entries for the next time
+
+  if (entries)
+  {
+    if (write_catalog)
+    {
+      LAScatalog lascatalog;
+      for (i = 0; i < file_name_number; i++) lascatalog.add_entry(file_names[i], &entries[i]);
+      lascatalog.write(write_catalog);
+    }
+    delete [] entries;
+  }
+
   // was it requested to rescale or reoffset
 
   if (scale_factor)
@@ -864,12 +1049,7 @@ bool LASreaderMerged::open()
     if (lasreaderlas)
     {
       delete lasreaderlas;
-      if (rescale && reoffset)
-        lasreaderlas = new LASreaderLASrescalereoffset(header.x_scale_factor, header.y_scale_factor, header.z_scale_factor, header.x_offset, header.y_offset, header.z_offset);
-      else if (rescale)
-        lasreaderlas = new LASreaderLASrescale(header.x_scale_factor, header.y_scale_factor, header.z_scale_factor);
-      else
-        lasreaderlas = new LASreaderLASreoffset(header.x_offset, header.y_offset, header.z_offset);
+      lasreaderlas = create_lasreaderlas();
       lasreader = lasreaderlas;
     }
     else if (lasreaderbin)
@@ -960,6 +1140,8 @@ bool LASreaderMerged::open()
   p_count = 0;
   file_name_current = 0;
 
+  // the prefetching starts with the first file so that it knows the query
+
   return TRUE;
 }
 
@@ -989,6 +1171,7 @@ bool LASreaderMerged::inside_tile(const F32 ll_x, const F32 ll_y, const F32 size
   header.min_y = ll_y;
   header.max_x = ll_x + size - 0.001f * header.x_scale_factor;
   header.max_y = ll_y + size - 0.001f * header.y_scale_factor;
+  prune_files(TRUE);
   return TRUE;
 }
 
@@ -1007,6 +1190,7 @@ bool LASreaderMerged::inside_circle(const F64 center_x, const F64 center_y, cons
   header.min_y = center_y - radius;
   header.max_x = center_x + radius;
   header.max_y = center_y + radius;
+  prune_files(TRUE);
   return TRUE;
 }
 
@@ -1025,9 +1209,108 @@ bool LASreaderMerged::inside_rectangle(const F64 min_x, const F64 min_y, const F
   header.min_y = min_y;
   header.max_x = max_x;
   header.max_y = max_y;
+  prune_files(FALSE);
   return TRUE;
 }
 
+// the files whose bounding box intersects the query are found with an R-tree
+// instead of testing them all. for circles the corners are also discarded.
+void LASreaderMerged::prune_files(const bool strict)
+{
+  file_hit_number = 0;
+  if (bounding_boxes == 0) return;
+  if (file_rtree == 0)
+  {
+    check_catalog_entries();
+    file_rtree = new LASrtree();
+    if (!file_rtree->build(file_name_number, bounding_boxes))
+    {
+      delete file_rtree;
+      file_rtree = 0;
+      return;
+    }
+    file_hits = new U32[file_name_number ? file_name_number : 1];
+  }
+  file_rtree->intersect_rectangle(header.min_x, header.min_y, header.max_x, header.max_y, strict);
+  const U32* hits = file_rtree->get_hits();
+  for (U32 h = 0; h < file_rtree->get_number_hits(); h++)
+  {
+    if (inside == 2)
+    {
+      const F64* bb = &bounding_boxes[4*hits[h]];
+      F64 dx = (c_center_x < bb[0] ? bb[0] - c_center_x : (c_center_x > bb[2] ? c_center_x - bb[2] : 0.0));
+      F64 dy = (c_center_y < bb[1] ? bb[1] - c_center_y : (c_center_y > bb[3] ? c_center_y - bb[3] : 0.0));
+      if ((dx*dx + dy*dy) > c_radius_squared) continue;
+    }
+    file_hits[file_hit_number] = hits[h];
+    file_hit_number++;
+  }
+}
+
+// the catalog entries that the merged header was built from are checked by the
+// modification time of their file before the R-tree prunes with their bounding
+// boxes. a file that has changed is peeked into again so that its bounding box
+// is correct and its point counts and extent are corrected in the header.
+
+void LASreaderMerged::check_catalog_entries()
+{
+  if (unchecked == 0) return;
+  U32 i, r, changed = 0;
+  LASreaderLAS peeked;
+  for (i = 0; i < file_name_number; i++)
+  {
+    if (!unchecked[i]) continue;
+    unchecked[i] = FALSE;
+    I32 c = catalog->find_entry(file_names[i]);
+    if ((c == -1) || catalog->is_current(c)) continue;
+    const LAScatalogEntry* entry = catalog->get_entry(c);
+    changed++;
+    // take the old counts out of the merged header
+    npoints -= entry->npoints;
+    header.number_of_point_records -= entry->number_of_point_records;
+    for (r = 0; r < 5; r++) header.number_of_points_by_return[r] -= entry->number_of_points_by_return[r];
+    if (!peeked.open(file_names[i], 512, TRUE))
+    {
+      fprintf(stderr, "WARNING: cannot open '%s' from catalog. skipping it.\n", file_names[i]);
+      bounding_boxes[4*i+0] = F64_MAX;
+      bounding_boxes[4*i+1] = F64_MAX;
+      bounding_boxes[4*i+2] = F64_MIN;
+      bounding_boxes[4*i+3] = F64_MIN;
+      continue;
+    }
+    // and put the current ones in
+    npoints += peeked.npoints;
+    header.number_of_point_records += peeked.header.number_of_point_records;
+    for (r = 0; r < 5; r++) header.number_of_points_by_return[r] += peeked.header.number_of_points_by_return[r];
+    if (peeked.npoints == 0)
+    {
+      bounding_boxes[4*i+0] = F64_MAX;
+      bounding_boxes[4*i+1] = F64_MAX;
+      bounding_boxes[4*i+2] = F64_MIN;
+      bounding_boxes[4*i+3] = F64_MIN;
+    }
+    else
+    {
+      bounding_boxes[4*i+0] = peeked.header.min_x;
+      bounding_boxes[4*i+1] = peeked.header.min_y;
+      bounding_boxes[4*i+2] = peeked.header.max_x;
+      bounding_boxes[4*i+3] = peeked.header.max_y;
+      // the extent can only grow as the other files are not looked at again
+      if (orig_min_x > peeked.header.min_x) orig_min_x = peeked.header.min_x;
+      if (orig_min_y > peeked.header.min_y) orig_min_y = peeked.header.min_y;
+      if (orig_max_x < peeked.header.max_x) orig_max_x = peeked.header.max_x;
+      if (orig_max_y < peeked.header.max_y) orig_max_y = peeked.header.max_y;
+      if (header.min_z > peeked.header.min_z) header.min_z = peeked.header.min_z;
+      if (header.max_z < peeked.header.max_z) header.max_z = peeked.header.max_z;
+    }
+    peeked.close();
+  }
+  if (changed)
+  {
+    fprintf(stderr, "WARNING: %u files have changed since the catalog was written. use '-write_catalog' to update it.\n", changed);
+  }
+}
+
 I32 LASreaderMerged::get_format() const
 {
   return lasreader->get_format();
@@ -1035,6 +1318,21 @@ I32 LASreaderMerged::get_format() const
 
 bool LASreaderMerged::read_point_default()
 {
+  if (interleaving || ((interleave > 1) && lasreaderlas && (p_count == 0) && start_interleaving()))
+  {
+    return read_point_interleaved();
+  }
+
+  if (gps_time_merging || (gps_time_merge && lasreaderlas && (p_count == 0) && start_gps_time_merge()))
+  {
+    return read_point_gps_time_merged();
+  }
+  else if (gps_time_merge && lasreaderlas)
+  {
+    // the merge could not be started (see the ERROR)
+    return FALSE;
+  }
+
   if (file_name_current == 0)
   {
     if (!open_next_file()) return FALSE;
@@ -1089,6 +1387,9 @@ bool LASreaderMerged::read_point_default()
 
 void LASreaderMerged::close(bool close_stream)
 {
+  stop_prefetch();
+  stop_interleaving();
+  stop_gps_time_merge();
   if (lasreader) 
   {
     lasreader->close(close_stream);
@@ -1097,6 +1398,8 @@ void LASreaderMerged::close(bool close_stream)
 
 bool LASreaderMerged::reopen()
 {
+  stop_interleaving();
+  stop_gps_time_merge();
   p_count = 0;
   file_name_current = 0;
   if (inside) inside_none();
@@ -1106,6 +1409,9 @@ bool LASreaderMerged::reopen()
 
 void LASreaderMerged::clean()
 {
+  stop_prefetch();
+  stop_interleaving();
+  stop_gps_time_merge();
   if (lasreader) 
   {
     delete lasreader;
@@ -1145,6 +1451,18 @@ void LASreaderMerged::clean()
   scale_scan_angle = 1.0f;
   populate_header = FALSE;
   keep_lastiling = FALSE;
+  auto_index = FALSE;
+  if (auto_index_directory)
+  {
+    free(auto_index_directory);
+    auto_index_directory = 0;
+  }
+  catalog = 0;
+  if (write_catalog)
+  {
+    free(write_catalog);
+    write_catalog = 0;
+  }
 
   if (file_names)
   {
@@ -1161,6 +1479,22 @@ void LASreaderMerged::clean()
     delete [] bounding_boxes;
     bounding_boxes = 0;
   }
+  if (file_rtree)
+  {
+    delete file_rtree;
+    file_rtree = 0;
+  }
+  if (file_hits)
+  {
+    delete [] file_hits;
+    file_hits = 0;
+  }
+  if (unchecked)
+  {
+    delete [] unchecked;
+    unchecked = 0;
+  }
+  file_hit_number = 0;
   file_name_current = 0;
   file_name_number = 0;
   file_name_allocated = 0;
@@ -1183,9 +1517,23 @@ LASreaderMerged::LASreaderMerged()
   files_are_flightlines = FALSE;
   apply_file_source_ID = FALSE;
   parse_string = 0;
+  auto_index_directory = 0;
+  peek_threads = 8;
+  catalog = 0;
+  write_catalog = 0;
   io_ibuffer_size = 262144;
   file_names = 0;
   bounding_boxes = 0;
+  file_rtree = 0;
+  file_hits = 0;
+  unchecked = 0;
+  prefetch_files = 0;
+  prefetches = 0;
+  interleave = 0;
+  interleaving = 0;
+  gps_time_merge = FALSE;
+  gps_time_check = FALSE;
+  gps_time_merging = 0;
   clean();
 }
 
@@ -1195,63 +1543,126 @@ LASreaderMerged::~LASreaderMerged()
   clean();
 }
 
-bool LASreaderMerged::open_next_file()
+// the next file (starting at file_name) whose bounding box overlaps the query
+U32 LASreaderMerged::find_next_file(U32 file_name) const
 {
-  while (file_name_current < file_name_number)
+  if (inside && file_rtree)
+  {
+    // skip ahead to the next file that the R-tree found
+    const U32* hit = lower_bound(file_hits, file_hits + file_hit_number, file_name);
+    file_name = (hit < file_hits + file_hit_number ? *hit : file_name_number);
+  }
+  while (file_name < file_name_number)
   {
     if (inside)
     {
       // check if bounding box overlaps requested bounding box
       if (inside < 3) // tile or circle
       {
-        if (bounding_boxes[4*file_name_current+0] >= header.max_x)
+        if (bounding_boxes[4*file_name+0] >= header.max_x)
         {
-          file_name_current++;
+          file_name++;
           continue;
         }
-        if (bounding_boxes[4*file_name_current+1] >= header.max_y)
+        if (bounding_boxes[4*file_name+1] >= header.max_y)
         {
-          file_name_current++;
+          file_name++;
           continue;
         }
       }
       else // rectangle
       {
-        if (bounding_boxes[4*file_name_current+0] > header.max_x)
+        if (bounding_boxes[4*file_name+0] > header.max_x)
         {
-          file_name_current++;
+          file_name++;
           continue;
         }
-        if (bounding_boxes[4*file_name_current+1] > header.max_y)
+        if (bounding_boxes[4*file_name+1] > header.max_y)
         {
-          file_name_current++;
+          file_name++;
           continue;
         }
       }
-      if (bounding_boxes[4*file_name_current+2] < header.min_x)
+      if (bounding_boxes[4*file_name+2] < header.min_x)
       {
-        file_name_current++;
+        file_name++;
         continue;
       }
-      if (bounding_boxes[4*file_name_current+3] < header.min_y)
+      if (bounding_boxes[4*file_name+3] < header.min_y)
       {
-        file_name_current++;
+        file_name++;
         continue;
       }
     }
+    return file_name;
+  }
+  return file_name_number;
+}
+
+LASreaderLAS* LASreaderMerged::create_lasreaderlas() const
+{
+  if (rescale && reoffset)
+    return new LASreaderLASrescalereoffset(header.x_scale_factor, header.y_scale_factor, header.z_scale_factor, header.x_offset, header.y_offset, header.z_offset);
+  else if (rescale)
+    return new LASreaderLASrescale(header.x_scale_factor, header.y_scale_factor, header.z_scale_factor);
+  else if (reoffset)
+    return new LASreaderLASreoffset(header.x_offset, header.y_offset, header.z_offset);
+  return new LASreaderLAS();
+}
+
+// opens a LAS/LAZ file together with its LAX (may run on a background thread).
+// a file whose catalog entry was not checked when pruning is checked here. by
+// now the merged header has been handed out so a change can only be reported.
+bool LASreaderMerged::open_lasreaderlas(LASreaderLAS* lasreaderlas, const U32 file_name) const
+{
+  if (!lasreaderlas->open(file_names[file_name], io_ibuffer_size))
+  {
+    return FALSE;
+  }
+  if (unchecked && unchecked[file_name])
+  {
+    I32 c = catalog->find_entry(file_names[file_name]);
+    if ((c != -1) && !catalog->is_current(c))
+    {
+      fprintf(stderr, "WARNING: file '%s' has changed since the catalog was written. the merged header used its old entry. use '-write_catalog' to update it.\n", file_names[file_name]);
+    }
+  }
+  LASindex* index = new LASindex;
+  if (index->read(file_names[file_name], auto_index_directory))
+    lasreaderlas->set_index(index);
+  else
+  {
+    delete index;
+    if (auto_index)
+    {
+      lasreaderlas->set_index(0);
+      lasreaderlas->set_auto_index(file_names[file_name], auto_index_directory);
+    }
+  }
+  if (read_ahead || read_coalesce) lasreaderlas->set_read_ahead(read_ahead, read_coalesce);
+  return TRUE;
+}
+
+bool LASreaderMerged::open_next_file()
+{
+  file_name_current = find_next_file(file_name_current);
+  if (file_name_current < file_name_number)
+  {
     // open the lasreader with the next file name
     if (lasreaderlas)
     {
-      if (!lasreaderlas->open(file_names[file_name_current], io_ibuffer_size))
+      LASreaderLAS* prefetched = take_prefetch(file_name_current);
+      if (prefetched)
+      {
+        // it was already opened in the background
+        delete lasreaderlas;
+        lasreader = lasreaderlas = prefetched;
+      }
+      else if (!open_lasreaderlas(lasreaderlas, file_name_current))
       {
         fprintf(stderr, "ERROR: could not open lasreaderlas for file '%s'\n", file_names[file_name_current]);
         return FALSE;
       }
-      LASindex* index = new LASindex;
-      if (index->read(file_names[file_name_current]))
-        lasreaderlas->set_index(index);
-      else
-        delete index;
     }
     else if (lasreaderbin)
     {
@@ -1261,10 +1672,18 @@ bool LASreaderMerged::open_next_file()
         return FALSE;
       }
       LASindex* index = new LASindex;
-      if (index->read(file_names[file_name_current]))
+      if (index->read(file_names[file_name_current], auto_index_directory))
         lasreaderbin->set_index(index);
       else
+      {
         delete index;
+        if (auto_index)
+        {
+          lasreaderbin->set_index(0);
+          lasreaderbin->set_auto_index(file_names[file_name_current], auto_index_directory);
+        }
+      }
+      if (read_ahead || read_coalesce) lasreaderbin->set_read_ahead(read_ahead, read_coalesce);
     }
     else if (lasreadershp)
     {
@@ -1282,10 +1701,18 @@ bool LASreaderMerged::open_next_file()
         return FALSE;
       }
       LASindex* index = new LASindex;
-      if (index->read(file_names[file_name_current]))
+      if (index->read(file_names[file_name_current], auto_index_directory))
         lasreaderqfit->set_index(index);
       else
+      {
         delete index;
+        if (auto_index)
+        {
+          lasreaderqfit->set_index(0);
+          lasreaderqfit->set_auto_index(file_names[file_name_current], auto_index_directory);
+        }
+      }
+      if (read_ahead || read_coalesce) lasreaderqfit->set_read_ahead(read_ahead, read_coalesce);
     }
     else if (lasreaderasc)
     {
@@ -1346,7 +1773,500 @@ bool LASreaderMerged::open_next_file()
       else if (inside == 1) lasreader->inside_tile(t_ll_x, t_ll_y, t_size);
       else lasreader->inside_circle(c_center_x, c_center_y, c_radius);
     }
+    if (lasreaderlas) start_prefetch();
     return TRUE;
   }
   return FALSE;
 }
+
+// a file opened ahead of time by a background thread
+class LASreaderMergedPrefetch
+{
+public:
+  LASthread thread;
+  const LASreaderMerged* lasreadermerged;
+  LASreaderLAS* lasreaderlas;
+  U32 file_name;
+  bool whole;
+  bool opened;
+};
+
+void LASreaderMerged::prefetch_file(void* data)
+{
+  LASreaderMergedPrefetch* prefetch = (LASreaderMergedPrefetch*)data;
+  prefetch->opened = prefetch->lasreadermerged->open_lasreaderlas(prefetch->lasreaderlas, prefetch->file_name);
+  // when all of it will be read we may as well have the OS start reading it
+  if (prefetch->opened && prefetch->whole)
+  {
+    prefetch->lasreaderlas->prefetch(0, prefetch->lasreaderlas->npoints);
+  }
+}
+
+// makes sure that the next few files that will be read are being opened
+void LASreaderMerged::start_prefetch()
+{
+  if ((lasreaderlas == 0) || (prefetch_files == 0) || (interleave > 1) || gps_time_merge) return;
+  if (prefetches == 0) prefetches = new LASreaderMergedPrefetch[prefetch_files];
+  U32 i, j, file_name = file_name_current;
+  U32* wanted = new U32[prefetch_files];
+  for (i = 0; i < prefetch_files; i++)
+  {
+    file_name = find_next_file(file_name);
+    wanted[i] = file_name;
+    if (file_name < file_name_number) file_name++;
+  }
+  // discard what is no longer needed (e.g. after a new spatial query)
+  for (j = 0; j < prefetch_files; j++)
+  {
+    if (prefetches[j].lasreaderlas == 0) continue;
+    for (i = 0; i < prefetch_files; i++) if (wanted[i] == prefetches[j].file_name) break;
+    if (i < prefetch_files) continue;
+    prefetches[j].thread.join();
+    delete prefetches[j].lasreaderlas;
+    prefetches[j].lasreaderlas = 0;
+  }
+  // and start what is missing
+  for (i = 0; i < prefetch_files; i++)
+  {
+    if (wanted[i] >= file_name_number) break;
+    for (j = 0; j < prefetch_files; j++) if (prefetches[j].lasreaderlas && (prefetches[j].file_name == wanted[i])) break;
+    if (j < prefetch_files) continue;
+    for (j = 0; j < prefetch_files; j++) if (prefetches[j].lasreaderlas == 0) break;
+    prefetches[j].lasreadermerged = this;
+    prefetches[j].lasreaderlas = create_lasreaderlas();
+    prefetches[j].file_name = wanted[i];
+    prefetches[j].whole = (inside == 0);
+    prefetches[j].opened = FALSE;
+    if (!prefetches[j].thread.start(prefetch_file, &prefetches[j]))
+    {
+      delete prefetches[j].lasreaderlas;
+      prefetches[j].lasreaderlas = 0;
+      break;
+    }
+  }
+  delete [] wanted;
+}
+
+// returns the reader if this file was opened in the background
+LASreaderLAS* LASreaderMerged::take_prefetch(const U32 file_name)
+{
+  if (prefetches == 0) return 0;
+  for (U32 j = 0; j < prefetch_files; j++)
+  {
+    if (prefetches[j].lasreaderlas && (prefetches[j].file_name == file_name))
+    {
+      prefetches[j].thread.join();
+      LASreaderLAS* lasreaderlas = prefetches[j].lasreaderlas;
+      prefetches[j].lasreaderlas = 0;
+      if (prefetches[j].opened) return lasreaderlas;
+      delete lasreaderlas;
+      return 0;
+    }
+  }
+  return 0;
+}
+
+void LASreaderMerged::stop_prefetch()
+{
+  if (prefetches == 0) return;
+  for (U32 j = 0; j < prefetch_files; j++)
+  {
+    if (prefetches[j].lasreaderlas)
+    {
+      prefetches[j].thread.join();
+      delete prefetches[j].lasreaderlas;
+    }
+  }
+  delete [] prefetches;
+  prefetches = 0;
+}
+
+// the points of the interleaved files are handed over in blocks
+#define LAS_MERGED_BLOCK_SIZE 1024
+
+class LASreaderMergedBlock
+{
+public:
+  LASpoint* points;
+  U32 number;
+  U32 file_name;
+  U16 file_source_ID;
+  LASreaderMergedBlock* next;
+};
+
+class LASreaderMergedInterleave
+{
+public:
+  LASmutex mutex;
+  LAScondition filled;
+  LAScondition emptied;
+  LASreaderMerged* lasreadermerged;
+  LASthread* threads;
+  U32 running;
+  U32 next_file_name;
+  bool stop;
+  LASreaderMergedBlock* blocks;
+  U32 number_blocks;
+  LASreaderMergedBlock* full_first;
+  LASreaderMergedBlock* full_last;
+  LASreaderMergedBlock* empty;
+  LASreaderMergedBlock* current;
+  U32 current_point;
+};
+
+// each thread reads whole files and hands over their points in blocks
+void LASreaderMerged::interleave_files(void* data)
+{
+  LASreaderMergedInterleave* interleaving = (LASreaderMergedInterleave*)data;
+  LASreaderMerged* lasreadermerged = interleaving->lasreadermerged;
+  LASreaderLAS* lasreaderlas = lasreadermerged->create_lasreaderlas();
+  LASreaderMergedBlock* block;
+  U32 file_name;
+  while (TRUE)
+  {
+    interleaving->mutex.lock();
+    file_name = (interleaving->stop ? lasreadermerged->file_name_number : lasreadermerged->find_next_file(interleaving->next_file_name));
+    interleaving->next_file_name = file_name + 1;
+    interleaving->mutex.unlock();
+    if (file_name >= lasreadermerged->file_name_number) break;
+    if (!lasreadermerged->open_lasreaderlas(lasreaderlas, file_name))
+    {
+      fprintf(stderr, "ERROR: could not open lasreaderlas for file '%s'\n", lasreadermerged->file_names[file_name]);
+      interleaving->mutex.lock();
+      interleaving->stop = TRUE;
+      interleaving->mutex.unlock();
+      break;
+    }
+    if (lasreadermerged->inside == 3) lasreaderlas->inside_rectangle(lasreadermerged->r_min_x, lasreadermerged->r_min_y, lasreadermerged->r_max_x, lasreadermerged->r_max_y);
+    else if (lasreadermerged->inside == 1) lasreaderlas->inside_tile(lasreadermerged->t_ll_x, lasreadermerged->t_ll_y, lasreadermerged->t_size);
+    else if (lasreadermerged->inside == 2) lasreaderlas->inside_circle(lasreadermerged->c_center_x, lasreadermerged->c_center_y, lasreadermerged->c_radius);
+    block = 0;
+    while (lasreaderlas->read_point())
+    {
+      if (block == 0)
+      {
+        interleaving->mutex.lock();
+        while ((interleaving->empty == 0) && !interleaving->stop) interleaving->emptied.wait(&interleaving->mutex);
+        if (!interleaving->stop)
+        {
+          block = interleaving->empty;
+          interleaving->empty = block->next;
+        }
+        interleaving->mutex.unlock();
+        if (block == 0) break;
+        block->number = 0;
+        block->file_name = file_name;
+        block->file_source_ID = lasreaderlas->header.file_source_ID;
+      }
+      block->points[block->number] = lasreaderlas->point;
+      block->number++;
+      if (block->number == LAS_MERGED_BLOCK_SIZE)
+      {
+        interleaving->mutex.lock();
+        block->next = 0;
+        if (interleaving->full_last) interleaving->full_last->next = block;
+        else interleaving->full_first = block;
+        interleaving->full_last = block;
+        interleaving->filled.signal();
+        interleaving->mutex.unlock();
+        block = 0;
+      }
+    }
+    if (block)
+    {
+      interleaving->mutex.lock();
+      block->next = 0;
+      if (interleaving->full_last) interleaving->full_last->next = block;
+      else interleaving->full_first = block;
+      interleaving->full_last = block;
+      interleaving->filled.signal();
+      interleaving->mutex.unlock();
+    }
+    lasreaderlas->close();
+  }
+  delete lasreaderlas;
+  interleaving->mutex.lock();
+  interleaving->running--;
+  interleaving->filled.broadcast();
+  interleaving->mutex.unlock();
+}
+
+bool LASreaderMerged::start_interleaving()
+{
+  stop_prefetch();
+  U32 i, j, number_threads = (interleave < file_name_number ? interleave : file_name_number);
+  interleaving = new LASreaderMergedInterleave();
+  interleaving->lasreadermerged = this;
+  interleaving->running = 0;
+  interleaving->next_file_name = 0;
+  interleaving->stop = FALSE;
+  interleaving->number_blocks = 4*number_threads;
+  interleaving->blocks = new LASreaderMergedBlock[interleaving->number_blocks];
+  interleaving->empty = 0;
+  for (i = 0; i < interleaving->number_blocks; i++)
+  {
+    interleaving->blocks[i].points = new LASpoint[LAS_MERGED_BLOCK_SIZE];
+    for (j = 0; j < LAS_MERGED_BLOCK_SIZE; j++)
+    {
+      if (header.laszip)
+        interleaving->blocks[i].points[j].init(&header, header.laszip->num_items, header.laszip->items);
+      else
+        interleaving->blocks[i].points[j].init(&header, header.point_data_format, header.point_data_record_length);
+    }
+    interleaving->blocks[i].next = interleaving->empty;
+    interleaving->empty = &interleaving->blocks[i];
+  }
+  interleaving->full_first = 0;
+  interleaving->full_last = 0;
+  interleaving->current = 0;
+  interleaving->current_point = 0;
+  interleaving->threads = new LASthread[number_threads];
+  interleaving->mutex.lock();
+  for (i = 0; i < number_threads; i++)
+  {
+    if (!interleaving->threads[i].start(interleave_files, interleaving)) break;
+    interleaving->running++;
+  }
+  interleaving->mutex.unlock();
+  if (interleaving->running == 0)
+  {
+    // read the files one after the other
+    stop_interleaving();
+    interleave = 0;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+bool LASreaderMerged::read_point_interleaved()
+{
+  while (TRUE)
+  {
+    if (interleaving->current)
+    {
+      while (interleaving->current_point < interleaving->current->number)
+      {
+        point = interleaving->current->points[interleaving->current_point];
+        interleaving->current_point++;
+        if (filter && filter->filter(&point)) continue;
+        if (transform) transform->transform(&point);
+        p_count++;
+        return TRUE;
+      }
+      interleaving->mutex.lock();
+      interleaving->current->next = interleaving->empty;
+      interleaving->empty = interleaving->current;
+      interleaving->emptied.signal();
+      interleaving->mutex.unlock();
+      interleaving->current = 0;
+    }
+    interleaving->mutex.lock();
+    while ((interleaving->full_first == 0) && interleaving->running) interleaving->filled.wait(&interleaving->mutex);
+    interleaving->current = interleaving->full_first;
+    if (interleaving->current)
+    {
+      interleaving->full_first = interleaving->current->next;
+      if (interleaving->full_first == 0) interleaving->full_last = 0;
+    }
+    interleaving->mutex.unlock();
+    if (interleaving->current == 0) return FALSE;
+    interleaving->current_point = 0;
+    if (files_are_flightlines)
+    {
+      transform->setPointSource(interleaving->current->file_name + 1);
+    }
+    else if (apply_file_source_ID)
+    {
+      transform->setPointSource(interleaving->current->file_source_ID);
+    }
+  }
+}
+
+void LASreaderMerged::stop_interleaving()
+{
+  if (interleaving == 0) return;
+  interleaving->mutex.lock();
+  interleaving->stop = TRUE;
+  interleaving->emptied.broadcast();
+  interleaving->mutex.unlock();
+  delete [] interleaving->threads; // joins them
+  for (U32 i = 0; i < interleaving->number_blocks; i++) delete [] interleaving->blocks[i].points;
+  delete [] interleaving->blocks;
+  delete interleaving;
+  interleaving = 0;
+}
+
+// all files are open at once and a heap of their current points is
+// popped in the order of the GPS time stamps. the number of files that
+// can be open at once is limited (the C runtime of Windows allows 512
+// by default) so more files than this are refused up front.
+
+#define LAS_MERGED_GPS_TIME_MAX_FILES 256
+
+class LASreaderMergedGPStime
+{
+public:
+  LASreaderLAS** lasreaderlas;
+  U32* file_names;
+  F64* last_gps_time;
+  bool* unsorted;
+  U32* heap;
+  U32 heap_size;
+  U32 number;
+  U32 point_source;
+  inline bool less(const U32 a, const U32 b) const
+  {
+    if (lasreaderlas[a]->point.gps_time < lasreaderlas[b]->point.gps_time) return TRUE;
+    if (lasreaderlas[a]->point.gps_time > lasreaderlas[b]->point.gps_time) return FALSE;
+    return (a < b); // equal time stamps come in the order of the files
+  }
+  void sift_up(U32 i)
+  {
+    U32 r = heap[i];
+    while (i)
+    {
+      U32 parent = (i - 1) / 2;
+      if (!less(r, heap[parent])) break;
+      heap[i] = heap[parent];
+      i = parent;
+    }
+    heap[i] = r;
+  }
+  void sift_down(U32 i)
+  {
+    U32 r = heap[i];
+    while (TRUE)
+    {
+      U32 child = 2 * i + 1;
+      if (child >= heap_size) break;
+      if (((child + 1) < heap_size) && less(heap[child + 1], heap[child])) child++;
+      if (!less(heap[child], r)) break;
+      heap[i] = heap[child];
+      i = child;
+    }
+    heap[i] = r;
+  }
+};
+
+bool LASreaderMerged::start_gps_time_merge()
+{
+  if (!point.have_gps_time)
+  {
+    fprintf(stderr, "WARNING: point type %d has no GPS time. merging files in order.\n", header.point_data_format);
+    gps_time_merge = FALSE;
+    return FALSE;
+  }
+  U32 r, file_name, number = 0;
+  for (file_name = find_next_file(0); file_name < file_name_number; file_name = find_next_file(file_name + 1))
+  {
+    number++;
+  }
+  if (number > LAS_MERGED_GPS_TIME_MAX_FILES)
+  {
+    fprintf(stderr, "ERROR: cannot merge %u files in GPS time order. the limit is %u open files. merge them in groups first.\n", number, LAS_MERGED_GPS_TIME_MAX_FILES);
+    return FALSE;
+  }
+  stop_prefetch();
+  gps_time_merging = new LASreaderMergedGPStime();
+  gps_time_merging->lasreaderlas = new LASreaderLAS*[file_name_number];
+  gps_time_merging->file_names = new U32[file_name_number];
+  gps_time_merging->last_gps_time = new F64[file_name_number];
+  gps_time_merging->unsorted = new bool[file_name_number];
+  gps_time_merging->heap = new U32[file_name_number];
+  gps_time_merging->heap_size = 0;
+  gps_time_merging->number = 0;
+  gps_time_merging->point_source = U32_MAX;
+  for (file_name = find_next_file(0); file_name < file_name_number; file_name = find_next_file(file_name + 1))
+  {
+    LASreaderLAS* lasreaderlas = create_lasreaderlas();
+    if (!open_lasreaderlas(lasreaderlas, file_name))
+    {
+      fprintf(stderr, "ERROR: could not open lasreaderlas for file '%s'\n", file_names[file_name]);
+      delete lasreaderlas;
+      stop_gps_time_merge();
+      return FALSE;
+    }
+    if (inside == 3) lasreaderlas->inside_rectangle(r_min_x, r_min_y, r_max_x, r_max_y);
+    else if (inside == 1) lasreaderlas->inside_tile(t_ll_x, t_ll_y, t_size);
+    else if (inside == 2) lasreaderlas->inside_circle(c_center_x, c_center_y, c_radius);
+    if (!lasreaderlas->read_point())
+    {
+      lasreaderlas->close();
+      delete lasreaderlas;
+      continue;
+    }
+    r = gps_time_merging->number;
+    gps_time_merging->lasreaderlas[r] = lasreaderlas;
+    gps_time_merging->file_names[r] = file_name;
+    gps_time_merging->last_gps_time[r] = lasreaderlas->point.gps_time;
+    gps_time_merging->unsorted[r] = FALSE;
+    gps_time_merging->number++;
+    gps_time_merging->heap[gps_time_merging->heap_size] = r;
+    gps_time_merging->heap_size++;
+    gps_time_merging->sift_up(gps_time_merging->heap_size - 1);
+  }
+  return TRUE;
+}
+
+bool LASreaderMerged::read_point_gps_time_merged()
+{
+  while (gps_time_merging->heap_size)
+  {
+    U32 r = gps_time_merging->heap[0];
+    LASreaderLAS* lasreaderlas = gps_time_merging->lasreaderlas[r];
+    point = lasreaderlas->point;
+    if (gps_time_merging->point_source != r)
+    {
+      if (files_are_flightlines)
+      {
+        transform->setPointSource(gps_time_merging->file_names[r] + 1);
+      }
+      else if (apply_file_source_ID)
+      {
+        transform->setPointSource(lasreaderlas->header.file_source_ID);
+      }
+      gps_time_merging->point_source = r;
+    }
+    // advance this file and restore the heap
+    if (lasreaderlas->read_point())
+    {
+      if (gps_time_check && !gps_time_merging->unsorted[r])
+      {
+        if (lasreaderlas->point.gps_time < gps_time_merging->last_gps_time[r])
+        {
+          fprintf(stderr, "WARNING: GPS time of file '%s' decreases at point %u. output will not be sorted.\n", file_names[gps_time_merging->file_names[r]], (U32)lasreaderlas->p_count);
+          gps_time_merging->unsorted[r] = TRUE;
+        }
+        gps_time_merging->last_gps_time[r] = lasreaderlas->point.gps_time;
+      }
+    }
+    else
+    {
+      gps_time_merging->heap_size--;
+      gps_time_merging->heap[0] = gps_time_merging->heap[gps_time_merging->heap_size];
+    }
+    if (gps_time_merging->heap_size) gps_time_merging->sift_down(0);
+    if (filter && filter->filter(&point)) continue;
+    if (transform) transform->transform(&point);
+    p_count++;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+void LASreaderMerged::stop_gps_time_merge()
+{
+  if (gps_time_merging == 0) return;
+  for (U32 r = 0; r < gps_time_merging->number; r++)
+  {
+    gps_time_merging->lasreaderlas[r]->close();
+    delete gps_time_merging->lasreaderlas[r];
+  }
+  delete [] gps_time_merging->lasreaderlas;
+  delete [] gps_time_merging->file_names;
+  delete [] gps_time_merging->last_gps_time;
+  delete [] gps_time_merging->unsorted;
+  delete [] gps_time_merging->heap;
+  delete gps_time_merging;
+  gps_time_merging = 0;
+}
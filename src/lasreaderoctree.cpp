@@ -0,0 +1,252 @@
+/*
+===============================================================================
+
+  FILE:  lasreaderoctree.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "lasreaderoctree.hpp"
+
+#include "lasreader_las.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool LASreaderOctree::open(const char* file_name, I32 io_buffer_size)
+{
+  if (file_name == 0)
+  {
+    fprintf(stderr,"ERROR: file name pointer is zero\n");
+    return FALSE;
+  }
+
+  close();
+  if (lasreaderlas) delete lasreaderlas;
+  lasreaderlas = new LASreaderLAS();
+  lasreaderlas->set_keep_octree(TRUE);
+  if (!lasreaderlas->open(file_name, io_buffer_size))
+  {
+    fprintf(stderr,"ERROR: cannot open '%s'\n", file_name);
+    return FALSE;
+  }
+  if (!octree.read_vlrs(&lasreaderlas->header))
+  {
+    fprintf(stderr,"ERROR: '%s' has no octree hierarchy\n", file_name);
+    return FALSE;
+  }
+
+  // take over the header but without the hierarchy so it is not copied into other files
+
+  header = lasreaderlas->header;
+  lasreaderlas->header.unlink();
+  if (header.number_attributes)
+  {
+    header.number_attributes = 0;
+    header.init_attributes(lasreaderlas->header.number_attributes, lasreaderlas->header.attributes);
+  }
+  octree.remove_vlrs(&header);
+
+  if (header.laszip)
+  {
+    if (!point.init(&header, header.laszip->num_items, header.laszip->items)) return FALSE;
+  }
+  else
+  {
+    if (!point.init(&header, header.point_data_format, header.point_data_record_length)) return FALSE;
+  }
+
+  selected = FALSE;
+  return select_nodes();
+}
+
+I32 LASreaderOctree::get_format() const
+{
+  return (lasreaderlas ? lasreaderlas->get_format() : LAS_TOOLS_FORMAT_LAZ);
+}
+
+void LASreaderOctree::set_max_level(const I32 max_level)
+{
+  this->max_level = max_level;
+  selected = FALSE;
+}
+
+void LASreaderOctree::set_point_budget(const I64 point_budget)
+{
+  this->point_budget = point_budget;
+  selected = FALSE;
+}
+
+bool LASreaderOctree::inside_none()
+{
+  selected = FALSE;
+  return LASreader::inside_none();
+}
+
+bool LASreaderOctree::inside_tile(const F32 ll_x, const F32 ll_y, const F32 size)
+{
+  selected = FALSE;
+  return LASreader::inside_tile(ll_x, ll_y, size);
+}
+
+bool LASreaderOctree::inside_circle(const F64 center_x, const F64 center_y, const F64 radius)
+{
+  selected = FALSE;
+  return LASreader::inside_circle(center_x, center_y, radius);
+}
+
+bool LASreaderOctree::inside_rectangle(const F64 min_x, const F64 min_y, const F64 max_x, const F64 max_y)
+{
+  selected = FALSE;
+  return LASreader::inside_rectangle(min_x, min_y, max_x, max_y);
+}
+
+// the nodes are stored level by level so the levels are taken one after the
+// other for as long as all their nodes that intersect the query fit
+
+bool LASreaderOctree::select_nodes()
+{
+  U32 n, first_of_level;
+  F64 min[3], max[3];
+
+  if (selected_nodes == 0) selected_nodes = new U32[octree.number_nodes ? octree.number_nodes : 1];
+  number_selected = 0;
+  npoints = 0;
+
+  n = 0;
+  while (n < octree.number_nodes)
+  {
+    I32 node_level = octree.nodes[n].level;
+    if ((max_level >= 0) && (node_level > max_level)) break;
+    first_of_level = number_selected;
+    I64 level_points = 0;
+    for (; (n < octree.number_nodes) && (octree.nodes[n].level == node_level); n++)
+    {
+      if (inside)
+      {
+        // during a spatial query the header has the bounding box of the query
+        octree.get_bounding_box(&(octree.nodes[n]), min, max);
+        if ((max[0] < header.min_x) || (min[0] > header.max_x) || (max[1] < header.min_y) || (min[1] > header.max_y)) continue;
+      }
+      selected_nodes[number_selected] = n;
+      number_selected++;
+      level_points += octree.nodes[n].number;
+    }
+    // the first level with points is always read so that there is a preview
+    if (point_budget && npoints && ((npoints + level_points) > point_budget))
+    {
+      number_selected = first_of_level;
+      break;
+    }
+    npoints += level_points;
+  }
+
+  selected = TRUE;
+  current_node = 0;
+  point_in_node = 0;
+  next_point = -1;
+  p_count = 0;
+  return TRUE;
+}
+
+bool LASreaderOctree::seek(const I64 p_index)
+{
+  if (!selected && !select_nodes()) return FALSE;
+  if ((p_index < 0) || (p_index >= npoints)) return FALSE;
+  I64 count = 0;
+  for (current_node = 0; current_node < number_selected; current_node++)
+  {
+    U32 number = octree.nodes[selected_nodes[current_node]].number;
+    if (p_index < (count + number)) break;
+    count += number;
+  }
+  point_in_node = (U32)(p_index - count);
+  next_point = -1;
+  p_count = p_index;
+  return TRUE;
+}
+
+bool LASreaderOctree::read_point_default()
+{
+  if (!selected && !select_nodes()) return FALSE;
+  while (current_node < number_selected)
+  {
+    const LASoctreeNode* node = &(octree.nodes[selected_nodes[current_node]]);
+    if (point_in_node < node->number)
+    {
+      // adjacent nodes are read without seeking
+      if (next_point != (node->first + point_in_node))
+      {
+        next_point = node->first + point_in_node;
+        if (!lasreaderlas->seek(next_point)) return FALSE;
+      }
+      if (!lasreaderlas->read_point()) return FALSE;
+      point = lasreaderlas->point;
+      level = node->level;
+      point_in_node++;
+      next_point++;
+      p_count++;
+      return TRUE;
+    }
+    current_node++;
+    point_in_node = 0;
+  }
+  return FALSE;
+}
+
+ByteStreamIn* LASreaderOctree::get_stream() const
+{
+  return (lasreaderlas ? lasreaderlas->get_stream() : 0);
+}
+
+void LASreaderOctree::close(bool close_stream)
+{
+  if (lasreaderlas) lasreaderlas->close(close_stream);
+  if (selected_nodes) delete [] selected_nodes;
+  selected_nodes = 0;
+  number_selected = 0;
+  selected = FALSE;
+}
+
+LASreaderOctree::LASreaderOctree()
+{
+  lasreaderlas = 0;
+  max_level = -1;
+  point_budget = 0;
+  level = 0;
+  selected = FALSE;
+  number_selected = 0;
+  selected_nodes = 0;
+  current_node = 0;
+  point_in_node = 0;
+  next_point = -1;
+}
+
+LASreaderOctree::~LASreaderOctree()
+{
+  close();
+  if (lasreaderlas) delete lasreaderlas;
+}
@@ -35,6 +35,7 @@
 #include "lastransform.hpp"
 
 #include "laswriter_las.hpp"
+#include "lassharedpipe.hpp"
 
 #include <stdlib.h>
 #include <string.h>
@@ -84,6 +85,27 @@ bool LASreaderPipeOn::open(LASreader* lasreader)
 
   if (laswriter) delete laswriter;
   laswriter = 0;
+  if (sharedpipe) delete sharedpipe;
+  sharedpipe = 0;
+
+  // offer the next stage a ring in shared memory in a VLR of the header
+
+  if (shared_pipe && LASsharedpipe::is_pipe(stdout))
+  {
+    sharedpipe = new LASsharedpipe();
+    if (sharedpipe->create(point.total_point_size))
+    {
+      U16 length = (U16)strlen(sharedpipe->get_name()) + 1;
+      U8* data = new U8[length];
+      memcpy(data, sharedpipe->get_name(), length);
+      header.add_vlr(LAS_SHARED_PIPE_USER_ID, LAS_SHARED_PIPE_RECORD_ID, length, data);
+    }
+    else
+    {
+      delete sharedpipe;
+      sharedpipe = 0;
+    }
+  }
 
   LASwriterLAS* laswriterlas = new LASwriterLAS();
 
@@ -102,6 +124,25 @@ bool LASreaderPipeOn::open(LASreader* lasreader)
 
   laswriter = laswriterlas;
 
+  if (sharedpipe)
+  {
+    header.remove_vlr(LAS_SHARED_PIPE_USER_ID, LAS_SHARED_PIPE_RECORD_ID);
+    fflush(stdout);
+    if (sharedpipe->wait_attached(250))
+    {
+      // the points go through shared memory. only the header was piped
+      laswriter->npoints = 0;
+      laswriter->close(FALSE);
+      delete laswriter;
+      laswriter = 0;
+    }
+    else
+    {
+      delete sharedpipe;
+      sharedpipe = 0;
+    }
+  }
+
   npoints = header.number_of_point_records;
   p_count = 0;
 
@@ -155,13 +196,25 @@ bool LASreaderPipeOn::read_point_default()
     if (lasreader->read_point())
     {
       point = lasreader->point;
-      if (laswriter)
+      if (sharedpipe)
+      {
+        if (!sharedpipe->write_point(&point))
+        {
+          fprintf(stderr, "ERROR: reading stage of shared pipe has gone away after %u points\n", (U32)p_count);
+          return FALSE;
+        }
+      }
+      else if (laswriter)
       {
         laswriter->write_point(&point);
       }
       p_count++;
       return TRUE;
     }
+    if (sharedpipe)
+    {
+      sharedpipe->done();
+    }
     if (laswriter)
     {
       laswriter->close();
@@ -185,10 +238,13 @@ LASreaderPipeOn::LASreaderPipeOn()
 {
   lasreader = 0;
   laswriter = 0;
+  sharedpipe = 0;
+  shared_pipe = FALSE;
 }
 
 LASreaderPipeOn::~LASreaderPipeOn()
 {
   if (lasreader || laswriter) close();
   if (lasreader) delete lasreader;
+  if (sharedpipe) delete sharedpipe;
 }
@@ -0,0 +1,258 @@
+/*
+===============================================================================
+
+  FILE:  lasrtree.cpp
+  
+  CONTENTS:
+  
+    see corresponding header file
+  
+  PROGRAMMERS:
+  
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+  
+  COPYRIGHT:
+  
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  
+  CHANGE HISTORY:
+  
+    see corresponding header file
+  
+===============================================================================
+*/
+#include "lasrtree.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+using namespace std;
+
+// orders boxes by their center along one axis (ties by index for a deterministic tree)
+class LASrtreeCenter
+{
+public:
+  LASrtreeCenter(const F64* boxes, const U32 axis) { this->boxes = boxes; this->axis = axis; };
+  bool operator()(const U32 a, const U32 b) const
+  {
+    F64 center_a = boxes[4*a+axis] + boxes[4*a+axis+2];
+    F64 center_b = boxes[4*b+axis] + boxes[4*b+axis+2];
+    if (center_a != center_b) return (center_a < center_b);
+    return (a < b);
+  };
+private:
+  const F64* boxes;
+  U32 axis;
+};
+
+// sorts the boxes by x into vertical slices of whole nodes and each slice by y
+static void str_order(const U32 number, const F64* boxes, U32* order, const U32 node_size)
+{
+  sort(order, order + number, LASrtreeCenter(boxes, 0));
+  U32 nodes = (number + node_size - 1) / node_size;
+  U32 slices = (U32)ceil(sqrt((F64)nodes));
+  U32 slice_size = ((nodes + slices - 1) / slices) * node_size;
+  for (U32 s = 0; s < number; s += slice_size)
+  {
+    sort(order + s, order + (s + slice_size < number ? s + slice_size : number), LASrtreeCenter(boxes, 1));
+  }
+}
+
+// the parent of consecutive groups of node_size boxes gets their union as its box
+static U32 str_pack(const U32 number, const F64* boxes, const U32 first, const U32 node_size, F64* node_boxes, U32* node_first, U32* node_count)
+{
+  U32 i, n = 0;
+  for (i = 0; i < number; i += node_size, n++)
+  {
+    U32 j, count = (i + node_size < number ? node_size : number - i);
+    node_first[n] = first + i;
+    node_count[n] = count;
+    node_boxes[4*n+0] = boxes[4*i+0];
+    node_boxes[4*n+1] = boxes[4*i+1];
+    node_boxes[4*n+2] = boxes[4*i+2];
+    node_boxes[4*n+3] = boxes[4*i+3];
+    for (j = i + 1; j < i + count; j++)
+    {
+      if (node_boxes[4*n+0] > boxes[4*j+0]) node_boxes[4*n+0] = boxes[4*j+0];
+      if (node_boxes[4*n+1] > boxes[4*j+1]) node_boxes[4*n+1] = boxes[4*j+1];
+      if (node_boxes[4*n+2] < boxes[4*j+2]) node_boxes[4*n+2] = boxes[4*j+2];
+      if (node_boxes[4*n+3] < boxes[4*j+3]) node_boxes[4*n+3] = boxes[4*j+3];
+    }
+  }
+  return n;
+}
+
+bool LASrtree::build(const U32 number, const F64* bounding_boxes, const U32 node_size)
+{
+  clean();
+  if (node_size < 2)
+  {
+    fprintf(stderr, "ERROR: node size %u of R-tree too small\n", node_size);
+    return FALSE;
+  }
+  U32 i, n;
+  // collect the non-empty boxes
+  items = (U32*)malloc(sizeof(U32)*(number ? number : 1));
+  hits = (U32*)malloc(sizeof(U32)*(number ? number : 1));
+  if ((items == 0) || (hits == 0))
+  {
+    fprintf(stderr, "ERROR: cannot allocate R-tree for %u boxes\n", number);
+    return FALSE;
+  }
+  for (i = 0; i < number; i++)
+  {
+    if ((bounding_boxes[4*i+0] <= bounding_boxes[4*i+2]) && (bounding_boxes[4*i+1] <= bounding_boxes[4*i+3]))
+    {
+      items[number_items] = i;
+      number_items++;
+    }
+  }
+  if (number_items == 0) return TRUE;
+  // the leafs and the nodes above them are all stored in one array level by level
+  U32 max_nodes = 1;
+  for (n = number_items; n > 1; n = (n + node_size - 1) / node_size) max_nodes += (n + node_size - 1) / node_size;
+  node_boxes = (F64*)malloc(sizeof(F64)*4*max_nodes);
+  node_first = (U32*)malloc(sizeof(U32)*max_nodes);
+  node_count = (U32*)malloc(sizeof(U32)*max_nodes);
+  stack = (U32*)malloc(sizeof(U32)*max_nodes);
+  item_boxes = (F64*)malloc(sizeof(F64)*4*number_items);
+  U32* order = (U32*)malloc(sizeof(U32)*2*number_items);
+  F64* boxes = (F64*)malloc(sizeof(F64)*4*number_items);
+  if ((node_boxes == 0) || (node_first == 0) || (node_count == 0) || (stack == 0) || (item_boxes == 0) || (order == 0) || (boxes == 0))
+  {
+    fprintf(stderr, "ERROR: cannot allocate R-tree for %u boxes\n", number_items);
+    if (order) free(order);
+    if (boxes) free(boxes);
+    clean();
+    return FALSE;
+  }
+  // the leaf level packs the items
+  for (i = 0; i < number_items; i++)
+  {
+    memcpy(&boxes[4*i], &bounding_boxes[4*items[i]], sizeof(F64)*4);
+    order[i] = i;
+  }
+  str_order(number_items, boxes, order, node_size);
+  for (i = 0; i < number_items; i++)
+  {
+    memcpy(&item_boxes[4*i], &boxes[4*order[i]], sizeof(F64)*4);
+    order[i] = items[order[i]];
+  }
+  memcpy(items, order, sizeof(U32)*number_items);
+  number_leaves = number_nodes = str_pack(number_items, item_boxes, 0, node_size, node_boxes, node_first, node_count);
+  // each higher level packs the nodes of the level below
+  U32 level_first = 0;
+  U32 level_number = number_nodes;
+  while (level_number > 1)
+  {
+    for (i = 0; i < level_number; i++) order[i] = level_first + i;
+    str_order(level_number, node_boxes, order, node_size);
+    // store the nodes of this level in their new order
+    for (i = 0; i < level_number; i++)
+    {
+      memcpy(&boxes[4*i], &node_boxes[4*order[i]], sizeof(F64)*4);
+      order[level_number+i] = node_first[order[i]];
+    }
+    for (i = 0; i < level_number; i++) order[i] = node_count[order[i]];
+    for (i = 0; i < level_number; i++)
+    {
+      memcpy(&node_boxes[4*(level_first+i)], &boxes[4*i], sizeof(F64)*4);
+      node_first[level_first+i] = order[level_number+i];
+      node_count[level_first+i] = order[i];
+    }
+    n = str_pack(level_number, &node_boxes[4*level_first], level_first, node_size, &node_boxes[4*number_nodes], &node_first[number_nodes], &node_count[number_nodes]);
+    level_first = number_nodes;
+    level_number = n;
+    number_nodes += n;
+  }
+  free(order);
+  free(boxes);
+  return TRUE;
+}
+
+U32 LASrtree::intersect_rectangle(const F64 r_min_x, const F64 r_min_y, const F64 r_max_x, const F64 r_max_y, const bool strict)
+{
+  number_hits = 0;
+  if (number_nodes == 0) return 0;
+  U32 i, node, top_of_stack = 1;
+  const F64* box;
+  stack[0] = number_nodes - 1;
+  while (top_of_stack)
+  {
+    top_of_stack--;
+    node = stack[top_of_stack];
+    box = &node_boxes[4*node];
+    if ((box[2] < r_min_x) || (box[3] < r_min_y)) continue;
+    if (strict ? ((box[0] >= r_max_x) || (box[1] >= r_max_y)) : ((box[0] > r_max_x) || (box[1] > r_max_y))) continue;
+    if (node < number_leaves)
+    {
+      for (i = node_first[node]; i < node_first[node] + node_count[node]; i++)
+      {
+        box = &item_boxes[4*i];
+        if ((box[2] < r_min_x) || (box[3] < r_min_y)) continue;
+        if (strict ? ((box[0] >= r_max_x) || (box[1] >= r_max_y)) : ((box[0] > r_max_x) || (box[1] > r_max_y))) continue;
+        hits[number_hits] = items[i];
+        number_hits++;
+      }
+    }
+    else
+    {
+      for (i = node_first[node]; i < node_first[node] + node_count[node]; i++)
+      {
+        stack[top_of_stack] = i;
+        top_of_stack++;
+      }
+    }
+  }
+  sort(hits, hits + number_hits);
+  return number_hits;
+}
+
+void LASrtree::clean()
+{
+  if (items) free(items);
+  if (item_boxes) free(item_boxes);
+  if (node_boxes) free(node_boxes);
+  if (node_first) free(node_first);
+  if (node_count) free(node_count);
+  if (stack) free(stack);
+  if (hits) free(hits);
+  number_items = 0;
+  items = 0;
+  item_boxes = 0;
+  number_nodes = 0;
+  number_leaves = 0;
+  node_boxes = 0;
+  node_first = 0;
+  node_count = 0;
+  stack = 0;
+  number_hits = 0;
+  hits = 0;
+}
+
+LASrtree::LASrtree()
+{
+  items = 0;
+  item_boxes = 0;
+  node_boxes = 0;
+  node_first = 0;
+  node_count = 0;
+  stack = 0;
+  hits = 0;
+  clean();
+}
+
+LASrtree::~LASrtree()
+{
+  clean();
+}
@@ -0,0 +1,330 @@
+/*
+===============================================================================
+
+  FILE:  lassharedpipe.cpp
+  
+  CONTENTS:
+  
+    see corresponding header file
+  
+  PROGRAMMERS:
+  
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+  
+  COPYRIGHT:
+  
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  
+  CHANGE HISTORY:
+  
+    see corresponding header file
+  
+===============================================================================
+*/
+#include "lassharedpipe.hpp"
+
+#include "lasdefinitions.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// the state of the handshake
+#define LAS_SHARED_PIPE_OFFERED   0
+#define LAS_SHARED_PIPE_ATTACHED  1
+#define LAS_SHARED_PIPE_ABANDONED 2
+
+// lies at the start of the shared memory and is followed by the slots. each
+// slot starts with the number of points in it followed by the raw records.
+
+class LASsharedpipeControl
+{
+public:
+  volatile U32 state;
+  volatile U32 head;     // number of slots filled by the writer
+  volatile U32 tail;     // number of slots emptied by the reader
+  volatile U32 done;
+  U32 writer_pid;
+  U32 reader_pid;
+  U32 point_size;
+  U32 points_per_slot;
+  U32 number_slots;
+  U32 slot_size;
+};
+
+#ifdef _WIN32
+
+// not (yet) on Windows. the points simply go through the pipe
+
+bool LASsharedpipe::is_pipe(FILE* file) { return FALSE; }
+bool LASsharedpipe::create(const U32 point_size, const U32 points_per_slot, const U32 number_slots) { return FALSE; }
+bool LASsharedpipe::wait_attached(const U32 milliseconds) { return FALSE; }
+bool LASsharedpipe::write_point(const LASpoint* point) { return FALSE; }
+bool LASsharedpipe::done() { return FALSE; }
+bool LASsharedpipe::attach(const CHAR* name, const U32 point_size) { return FALSE; }
+bool LASsharedpipe::read_point(LASpoint* point) { return FALSE; }
+void LASsharedpipe::wait(volatile U32* address, const U32 value) {}
+void LASsharedpipe::wake(volatile U32* address) {}
+LASsharedpipe::LASsharedpipe() { control = 0; }
+LASsharedpipe::~LASsharedpipe() {}
+
+#else
+
+bool LASsharedpipe::is_pipe(FILE* file)
+{
+  struct stat info;
+  if (fstat(fileno(file), &info) != 0) return FALSE;
+  return S_ISFIFO(info.st_mode);
+}
+
+bool LASsharedpipe::create(const U32 point_size, const U32 points_per_slot, const U32 number_slots)
+{
+  static U32 counter = 0;
+  U32 slot_size = sizeof(U32) + point_size*points_per_slot;
+  slot_size = (slot_size + 7) & ~7;
+  size = sizeof(LASsharedpipeControl) + (I64)slot_size*number_slots;
+  sprintf(name, "/laslib.%u.%u", (U32)getpid(), counter++);
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd == -1)
+  {
+    return FALSE;
+  }
+  if (ftruncate(fd, (off_t)size) != 0)
+  {
+    close(fd);
+    shm_unlink(name);
+    return FALSE;
+  }
+  void* memory = mmap(0, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED)
+  {
+    shm_unlink(name);
+    return FALSE;
+  }
+  control = (LASsharedpipeControl*)memory;
+  slots = ((U8*)memory) + sizeof(LASsharedpipeControl);
+  control->state = LAS_SHARED_PIPE_OFFERED;
+  control->head = 0;
+  control->tail = 0;
+  control->done = 0;
+  control->writer_pid = (U32)getpid();
+  control->reader_pid = 0;
+  control->point_size = point_size;
+  control->points_per_slot = points_per_slot;
+  control->number_slots = number_slots;
+  control->slot_size = slot_size;
+  creator = TRUE;
+  count = 0;
+  current = 0;
+  return TRUE;
+}
+
+// returns TRUE if the reading stage took the ring. otherwise it is withdrawn
+bool LASsharedpipe::wait_attached(const U32 milliseconds)
+{
+  U32 waited = 0;
+  while ((control->state == LAS_SHARED_PIPE_OFFERED) && (waited < milliseconds))
+  {
+    struct timespec pause = { 0, 1000000 };
+    nanosleep(&pause, 0);
+    waited++;
+  }
+  bool attached = !__sync_bool_compare_and_swap(&(control->state), LAS_SHARED_PIPE_OFFERED, LAS_SHARED_PIPE_ABANDONED);
+  // the name is no longer needed once both (or just one) have it mapped
+  shm_unlink(name);
+  return attached;
+}
+
+bool LASsharedpipe::write_point(const LASpoint* point)
+{
+  if (current == 0)
+  {
+    // wait for an empty slot
+    while ((control->head - control->tail) == control->number_slots)
+    {
+      if (control->reader_pid == 0) return FALSE;
+      wait(&(control->tail), control->head - control->number_slots);
+      if (kill((pid_t)control->reader_pid, 0) != 0)
+      {
+        fprintf(stderr, "ERROR: reading stage of shared pipe has gone away\n");
+        control->reader_pid = 0;
+        return FALSE;
+      }
+    }
+    current = slots + (I64)(control->head % control->number_slots)*control->slot_size;
+    count = 0;
+  }
+  point->copy_to(current + sizeof(U32) + count*control->point_size);
+  count++;
+  if (count == control->points_per_slot)
+  {
+    *((U32*)current) = count;
+    current = 0;
+    __sync_synchronize();
+    control->head++;
+    wake(&(control->head));
+  }
+  return TRUE;
+}
+
+bool LASsharedpipe::done()
+{
+  if (control == 0) return FALSE;
+  if (current)
+  {
+    *((U32*)current) = count;
+    current = 0;
+    __sync_synchronize();
+    control->head++;
+  }
+  __sync_synchronize();
+  control->done = 1;
+  wake(&(control->head));
+  return TRUE;
+}
+
+bool LASsharedpipe::attach(const CHAR* name, const U32 point_size)
+{
+  int fd = shm_open(name, O_RDWR, 0600);
+  if (fd == -1)
+  {
+    return FALSE;
+  }
+  struct stat info;
+  if ((fstat(fd, &info) != 0) || (info.st_size < (off_t)sizeof(LASsharedpipeControl)))
+  {
+    close(fd);
+    return FALSE;
+  }
+  size = (I64)info.st_size;
+  void* memory = mmap(0, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED)
+  {
+    return FALSE;
+  }
+  control = (LASsharedpipeControl*)memory;
+  slots = ((U8*)memory) + sizeof(LASsharedpipeControl);
+  if ((control->point_size != point_size) || (size < (I64)(sizeof(LASsharedpipeControl) + (I64)control->slot_size*control->number_slots)))
+  {
+    munmap(memory, (size_t)size);
+    control = 0;
+    return FALSE;
+  }
+  control->reader_pid = (U32)getpid();
+  __sync_synchronize();
+  if (!__sync_bool_compare_and_swap(&(control->state), LAS_SHARED_PIPE_OFFERED, LAS_SHARED_PIPE_ATTACHED))
+  {
+    // too late. the writer already sends the points through the pipe
+    munmap(memory, (size_t)size);
+    control = 0;
+    return FALSE;
+  }
+  strncpy(this->name, name, 63);
+  creator = FALSE;
+  count = 0;
+  number = 0;
+  current = 0;
+  return TRUE;
+}
+
+bool LASsharedpipe::read_point(LASpoint* point)
+{
+  if (current == 0)
+  {
+    // wait for a full slot
+    while (control->tail == control->head)
+    {
+      if (control->done)
+      {
+        // the last slot may have been published right before 'done'
+        __sync_synchronize();
+        if (control->tail == control->head) return FALSE;
+        break;
+      }
+      wait(&(control->head), control->tail);
+      if ((control->tail == control->head) && !control->done && (kill((pid_t)control->writer_pid, 0) != 0))
+      {
+        fprintf(stderr, "ERROR: writing stage of shared pipe has gone away\n");
+        return FALSE;
+      }
+    }
+    __sync_synchronize();
+    current = slots + (I64)(control->tail % control->number_slots)*control->slot_size;
+    number = *((U32*)current);
+    count = 0;
+  }
+  point->copy_from(current + sizeof(U32) + count*control->point_size);
+  count++;
+  if (count == number)
+  {
+    current = 0;
+    __sync_synchronize();
+    control->tail++;
+    wake(&(control->tail));
+  }
+  return TRUE;
+}
+
+// sleeps while the value at the address is unchanged (or for a moment)
+void LASsharedpipe::wait(volatile U32* address, const U32 value)
+{
+#ifdef __linux__
+  struct timespec timeout = { 0, 100000000 };
+  syscall(SYS_futex, address, FUTEX_WAIT, value, &timeout, 0, 0);
+#else
+  struct timespec pause = { 0, 50000 };
+  if (*address == value) nanosleep(&pause, 0);
+#endif
+}
+
+void LASsharedpipe::wake(volatile U32* address)
+{
+#ifdef __linux__
+  syscall(SYS_futex, address, FUTEX_WAKE, 1, 0, 0, 0);
+#endif
+}
+
+LASsharedpipe::LASsharedpipe()
+{
+  name[0] = '\0';
+  control = 0;
+  slots = 0;
+  size = 0;
+  creator = FALSE;
+  count = 0;
+  number = 0;
+  current = 0;
+}
+
+LASsharedpipe::~LASsharedpipe()
+{
+  if (control)
+  {
+    if (creator && (control->state == LAS_SHARED_PIPE_OFFERED)) shm_unlink(name);
+    munmap((void*)control, (size_t)size);
+  }
+}
+
+#endif
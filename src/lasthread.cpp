@@ -0,0 +1,190 @@
+/*
+===============================================================================
+
+  FILE:  lasthread.cpp
+  
+  CONTENTS:
+  
+    see corresponding header file
+  
+  PROGRAMMERS:
+  
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+  
+  COPYRIGHT:
+  
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  
+  CHANGE HISTORY:
+  
+    see corresponding header file
+  
+===============================================================================
+*/
+#include "lasthread.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef _WIN32
+unsigned long __stdcall LASthread::run(void* thread)
+#else
+void* LASthread::run(void* thread)
+#endif
+{
+  ((LASthread*)thread)->function(((LASthread*)thread)->data);
+  return 0;
+}
+
+bool LASthread::start(void (*function)(void*), void* data)
+{
+  if (handle)
+  {
+    fprintf(stderr, "ERROR: thread is already running\n");
+    return FALSE;
+  }
+  this->function = function;
+  this->data = data;
+#ifdef _WIN32
+  handle = CreateThread(0, 0, run, this, 0, 0);
+  if (handle == 0)
+  {
+    fprintf(stderr, "ERROR: cannot create thread\n");
+    return FALSE;
+  }
+#else
+  pthread_t* thread = (pthread_t*)malloc(sizeof(pthread_t));
+  if (pthread_create(thread, 0, run, this) != 0)
+  {
+    fprintf(stderr, "ERROR: cannot create thread\n");
+    free(thread);
+    return FALSE;
+  }
+  handle = thread;
+#endif
+  return TRUE;
+}
+
+bool LASthread::join()
+{
+  if (handle == 0) return FALSE;
+#ifdef _WIN32
+  WaitForSingleObject((HANDLE)handle, INFINITE);
+  CloseHandle((HANDLE)handle);
+#else
+  pthread_join(*((pthread_t*)handle), 0);
+  free(handle);
+#endif
+  handle = 0;
+  return TRUE;
+}
+
+LASthread::LASthread()
+{
+  handle = 0;
+  function = 0;
+  data = 0;
+}
+
+LASthread::~LASthread()
+{
+  join();
+}
+
+void LASmutex::lock()
+{
+#ifdef _WIN32
+  EnterCriticalSection((CRITICAL_SECTION*)handle);
+#else
+  pthread_mutex_lock((pthread_mutex_t*)handle);
+#endif
+}
+
+void LASmutex::unlock()
+{
+#ifdef _WIN32
+  LeaveCriticalSection((CRITICAL_SECTION*)handle);
+#else
+  pthread_mutex_unlock((pthread_mutex_t*)handle);
+#endif
+}
+
+LASmutex::LASmutex()
+{
+#ifdef _WIN32
+  handle = malloc(sizeof(CRITICAL_SECTION));
+  InitializeCriticalSection((CRITICAL_SECTION*)handle);
+#else
+  handle = malloc(sizeof(pthread_mutex_t));
+  pthread_mutex_init((pthread_mutex_t*)handle, 0);
+#endif
+}
+
+LASmutex::~LASmutex()
+{
+#ifdef _WIN32
+  DeleteCriticalSection((CRITICAL_SECTION*)handle);
+#else
+  pthread_mutex_destroy((pthread_mutex_t*)handle);
+#endif
+  free(handle);
+}
+
+void LAScondition::wait(LASmutex* mutex)
+{
+#ifdef _WIN32
+  SleepConditionVariableCS((CONDITION_VARIABLE*)handle, (CRITICAL_SECTION*)mutex->handle, INFINITE);
+#else
+  pthread_cond_wait((pthread_cond_t*)handle, (pthread_mutex_t*)mutex->handle);
+#endif
+}
+
+void LAScondition::signal()
+{
+#ifdef _WIN32
+  WakeConditionVariable((CONDITION_VARIABLE*)handle);
+#else
+  pthread_cond_signal((pthread_cond_t*)handle);
+#endif
+}
+
+void LAScondition::broadcast()
+{
+#ifdef _WIN32
+  WakeAllConditionVariable((CONDITION_VARIABLE*)handle);
+#else
+  pthread_cond_broadcast((pthread_cond_t*)handle);
+#endif
+}
+
+LAScondition::LAScondition()
+{
+#ifdef _WIN32
+  handle = malloc(sizeof(CONDITION_VARIABLE));
+  InitializeConditionVariable((CONDITION_VARIABLE*)handle);
+#else
+  handle = malloc(sizeof(pthread_cond_t));
+  pthread_cond_init((pthread_cond_t*)handle, 0);
+#endif
+}
+
+LAScondition::~LAScondition()
+{
+#ifndef _WIN32
+  pthread_cond_destroy((pthread_cond_t*)handle);
+#endif
+  free(handle);
+}
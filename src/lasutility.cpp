@@ -68,6 +68,104 @@ bool LASinventory::add(const LASpoint* point)
   return TRUE;
 }
 
+bool LASinventory::add(const LASinventory* inventory)
+{
+  U32 i;
+  if (inventory->first) return TRUE;
+  number_of_point_records += inventory->number_of_point_records;
+  for (i = 0; i < 8; i++) number_of_points_by_return[i] += inventory->number_of_points_by_return[i];
+  if (first)
+  {
+    min_X = inventory->min_X; max_X = inventory->max_X;
+    min_Y = inventory->min_Y; max_Y = inventory->max_Y;
+    min_Z = inventory->min_Z; max_Z = inventory->max_Z;
+    first = FALSE;
+  }
+  else
+  {
+    if (inventory->min_X < min_X) min_X = inventory->min_X;
+    if (inventory->max_X > max_X) max_X = inventory->max_X;
+    if (inventory->min_Y < min_Y) min_Y = inventory->min_Y;
+    if (inventory->max_Y > max_Y) max_Y = inventory->max_Y;
+    if (inventory->min_Z < min_Z) min_Z = inventory->min_Z;
+    if (inventory->max_Z > max_Z) max_Z = inventory->max_Z;
+  }
+  return TRUE;
+}
+
+// scans raw little-endian point records of type 0 to 5 without a LASpoint
+
+bool LASinventory::add(const U8* records, U32 number, U16 record_length)
+{
+  if (number == 0) return TRUE;
+  U32 i;
+  I32 X, Y, Z;
+  U32 by_return[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  I32 lo_X, hi_X, lo_Y, hi_Y, lo_Z, hi_Z;
+  memcpy(&lo_X, records, 4); hi_X = lo_X;
+  memcpy(&lo_Y, records+4, 4); hi_Y = lo_Y;
+  memcpy(&lo_Z, records+8, 4); hi_Z = lo_Z;
+  for (i = 0; i < number; i++, records += record_length)
+  {
+    memcpy(&X, records, 4);
+    memcpy(&Y, records+4, 4);
+    memcpy(&Z, records+8, 4);
+    lo_X = (X < lo_X ? X : lo_X); hi_X = (X > hi_X ? X : hi_X);
+    lo_Y = (Y < lo_Y ? Y : lo_Y); hi_Y = (Y > hi_Y ? Y : hi_Y);
+    lo_Z = (Z < lo_Z ? Z : lo_Z); hi_Z = (Z > hi_Z ? Z : hi_Z);
+    by_return[records[14] & 7]++;
+  }
+  number_of_point_records += number;
+  for (i = 0; i < 8; i++) number_of_points_by_return[i] += by_return[i];
+  if (first)
+  {
+    min_X = lo_X; max_X = hi_X;
+    min_Y = lo_Y; max_Y = hi_Y;
+    min_Z = lo_Z; max_Z = hi_Z;
+    first = FALSE;
+  }
+  else
+  {
+    if (lo_X < min_X) min_X = lo_X;
+    if (hi_X > max_X) max_X = hi_X;
+    if (lo_Y < min_Y) min_Y = lo_Y;
+    if (hi_Y > max_Y) max_Y = hi_Y;
+    if (lo_Z < min_Z) min_Z = lo_Z;
+    if (hi_Z > max_Z) max_Z = hi_Z;
+  }
+  return TRUE;
+}
+
+// the header of a file whose points are copied without being decoded
+
+bool LASinventory::add(const LASheader* header)
+{
+  if (header->number_of_point_records == 0) return TRUE;
+  U32 i;
+  number_of_point_records += header->number_of_point_records;
+  for (i = 0; i < 5; i++) number_of_points_by_return[i+1] += header->number_of_points_by_return[i];
+  I32 lo_X = header->get_X(header->min_x), hi_X = header->get_X(header->max_x);
+  I32 lo_Y = header->get_Y(header->min_y), hi_Y = header->get_Y(header->max_y);
+  I32 lo_Z = header->get_Z(header->min_z), hi_Z = header->get_Z(header->max_z);
+  if (first)
+  {
+    min_X = lo_X; max_X = hi_X;
+    min_Y = lo_Y; max_Y = hi_Y;
+    min_Z = lo_Z; max_Z = hi_Z;
+    first = FALSE;
+  }
+  else
+  {
+    if (lo_X < min_X) min_X = lo_X;
+    if (hi_X > max_X) max_X = hi_X;
+    if (lo_Y < min_Y) min_Y = lo_Y;
+    if (hi_Y > max_Y) max_Y = hi_Y;
+    if (lo_Z < min_Z) min_Z = lo_Z;
+    if (hi_Z > max_Z) max_Z = hi_Z;
+  }
+  return TRUE;
+}
+
 LASsummary::LASsummary()
 {
   U32 i;
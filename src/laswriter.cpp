@@ -30,8 +30,10 @@
 */
 #include "laswriter.hpp"
 
+#include "lasreader.hpp"
 #include "laswriter_las.hpp"
 #include "laswriter_bin.hpp"
+#include "laswriter_col.hpp"
 #include "laswriter_qfit.hpp"
 #include "laswriter_wrl.hpp"
 #include "laswriter_txt.hpp"
@@ -45,6 +47,33 @@
 #define DIRECTORY_SLASH '/'
 #endif
 
+#define LAS_RAW_POINTS_BLOCK 8192
+
+I64 LASwriter::copy_raw_points(LASreader* lasreader, bool update_inventory)
+{
+  if (!lasreader->has_raw_points()) return -1;
+  const LASheader* header = &(lasreader->header);
+  if (!takes_raw_points(header->point_data_format, header->point_data_record_length)) return -1;
+  if ((quantizer.x_scale_factor != header->x_scale_factor) || (quantizer.y_scale_factor != header->y_scale_factor) || (quantizer.z_scale_factor != header->z_scale_factor)) return -1;
+  if ((quantizer.x_offset != header->x_offset) || (quantizer.y_offset != header->y_offset) || (quantizer.z_offset != header->z_offset)) return -1;
+  U8* records = (U8*)malloc(LAS_RAW_POINTS_BLOCK*header->point_data_record_length);
+  if (records == 0) return -1;
+  U32 number;
+  I64 count = 0;
+  while ((number = lasreader->read_raw_points(records, LAS_RAW_POINTS_BLOCK)))
+  {
+    if (!write_raw_points(records, number))
+    {
+      fprintf(stderr,"ERROR: cannot write block of %u raw points\n", number);
+      break;
+    }
+    if (update_inventory) inventory.add(records, number, header->point_data_record_length);
+    count += number;
+  }
+  free(records);
+  return count;
+}
+
 bool LASwriteOpener::is_piped() const
 {
   return ((file_name == 0) && use_stdout);
@@ -55,6 +84,7 @@ LASwriter* LASwriteOpener::open(LASheader* header)
   if (use_nil)
   {
     LASwriterLAS* laswriterlas = new LASwriterLAS();
+    laswriterlas->set_fast_compression(format == LAS_TOOLS_FORMAT_LAF);
     if (!laswriterlas->open(header, (format == LAS_TOOLS_FORMAT_LAZ ? (use_chunking ?  LASZIP_COMPRESSOR_CHUNKED : LASZIP_COMPRESSOR_NOT_CHUNKED) : LASZIP_COMPRESSOR_NONE), 2, chunk_size))
     {
       fprintf(stderr,"ERROR: cannot open laswriterlas to NULL\n");
@@ -65,9 +95,11 @@ LASwriter* LASwriteOpener::open(LASheader* header)
   }
   else if (file_name)
   {
-    if (format <= LAS_TOOLS_FORMAT_LAZ)
+    if ((format <= LAS_TOOLS_FORMAT_LAZ) || (format == LAS_TOOLS_FORMAT_LAF))
     {
       LASwriterLAS* laswriterlas = new LASwriterLAS();
+      laswriterlas->set_async_buffers(async_obuffers);
+      laswriterlas->set_fast_compression(format == LAS_TOOLS_FORMAT_LAF);
       if (!laswriterlas->open(file_name, header, (format == LAS_TOOLS_FORMAT_LAZ ? (use_chunking ? LASZIP_COMPRESSOR_CHUNKED : LASZIP_COMPRESSOR_NOT_CHUNKED) : LASZIP_COMPRESSOR_NONE), 2, chunk_size, io_obuffer_size))
       {
         fprintf(stderr,"ERROR: cannot open laswriterlas with file name '%s'\n", file_name);
@@ -93,6 +125,7 @@ LASwriter* LASwriteOpener::open(LASheader* header)
     else if (format == LAS_TOOLS_FORMAT_BIN)
     {
       LASwriterBIN* laswriterbin = new LASwriterBIN();
+      laswriterbin->set_async_buffers(async_obuffers);
       if (!laswriterbin->open(file_name, header, "ts8"))
       {
         fprintf(stderr,"ERROR: cannot open laswriterbin with file name '%s'\n", file_name);
@@ -101,9 +134,21 @@ LASwriter* LASwriteOpener::open(LASheader* header)
       }
       return laswriterbin;
     }
+    else if (format == LAS_TOOLS_FORMAT_LAC)
+    {
+      LASwriterCOL* laswritercol = new LASwriterCOL();
+      if (!laswritercol->open(file_name, header, chunk_size, io_obuffer_size))
+      {
+        fprintf(stderr,"ERROR: cannot open laswritercol with file name '%s'\n", file_name);
+        delete laswritercol;
+        return 0;
+      }
+      return laswritercol;
+    }
     else if (format == LAS_TOOLS_FORMAT_QFIT)
     {
       LASwriterQFIT* laswriterqfit = new LASwriterQFIT();
+      laswriterqfit->set_async_buffers(async_obuffers);
       if (!laswriterqfit->open(file_name, header, 40))
       {
         fprintf(stderr,"ERROR: cannot open laswriterqfit with file name '%s'\n", file_name);
@@ -131,9 +176,10 @@ LASwriter* LASwriteOpener::open(LASheader* header)
   }
   else if (use_stdout)
   {
-    if (format <= LAS_TOOLS_FORMAT_LAZ)
+    if ((format <= LAS_TOOLS_FORMAT_LAZ) || (format == LAS_TOOLS_FORMAT_LAF))
     {
       LASwriterLAS* laswriterlas = new LASwriterLAS();
+      laswriterlas->set_fast_compression(format == LAS_TOOLS_FORMAT_LAF);
       if (!laswriterlas->open(stdout, header, (format == LAS_TOOLS_FORMAT_LAZ ? (use_chunking ? LASZIP_COMPRESSOR_CHUNKED : LASZIP_COMPRESSOR_NOT_CHUNKED) : LASZIP_COMPRESSOR_NONE), 2, chunk_size))
       {
         fprintf(stderr,"ERROR: cannot open laswriterlas to stdout\n");
@@ -167,6 +213,18 @@ LASwriter* LASwriteOpener::open(LASheader* header)
       }
       return laswriterbin;
     }
+    else if (format == LAS_TOOLS_FORMAT_LAC)
+    {
+      // the footer comes last and the offsets are counted by the writer so the columns can be piped
+      LASwriterCOL* laswritercol = new LASwriterCOL();
+      if (!laswritercol->open(stdout, header, chunk_size))
+      {
+        fprintf(stderr,"ERROR: cannot open laswritercol to stdout\n");
+        delete laswritercol;
+        return 0;
+      }
+      return laswritercol;
+    }
     else if (format == LAS_TOOLS_FORMAT_QFIT)
     {
       LASwriterQFIT* laswriterqfit = new LASwriterQFIT();
@@ -221,15 +279,18 @@ void LASwriteOpener::usage() const
   fprintf(stderr,"Supported LAS Outputs\n");
   fprintf(stderr,"  -o lidar.las\n");
   fprintf(stderr,"  -o lidar.laz\n");
+  fprintf(stderr,"  -o lidar.laf (fast compression for intermediate files)\n");
+  fprintf(stderr,"  -o lidar.lac (columns that are read only when needed)\n");
   fprintf(stderr,"  -o xyzta.txt -oparse xyzta (on-the-fly to ASCII)\n");
   fprintf(stderr,"  -o terrasolid.bin\n");
   fprintf(stderr,"  -o nasa.qi\n");
   fprintf(stderr,"  -odir C:%cdata%cground (specify output directory)\n", DIRECTORY_SLASH, DIRECTORY_SLASH);
   fprintf(stderr,"  -odix _classified (specify file name appendix)\n");
   fprintf(stderr,"  -ocut 2 (cut the last two characters from name)\n");
-  fprintf(stderr,"  -olas -olaz -otxt -obin -oqfit (specify format)\n");
+  fprintf(stderr,"  -olas -olaz -olaf -olac -otxt -obin -oqfit (specify format)\n");
   fprintf(stderr,"  -stdout (pipe to stdout)\n");
   fprintf(stderr,"  -nil    (pipe to NULL)\n");
+  fprintf(stderr,"  -async_obuffers 4 (blocks in flight to the I/O thread, 0 = off)\n");
 }
 
 bool LASwriteOpener::parse(int argc, char* argv[])
@@ -303,6 +364,18 @@ bool LASwriteOpener::parse(int argc, char* argv[])
       format = LAS_TOOLS_FORMAT_LAZ;
       *argv[i]='\0';
     }
+    else if (strcmp(argv[i],"-olaf") == 0)
+    {
+      specified = TRUE;
+      format = LAS_TOOLS_FORMAT_LAF;
+      *argv[i]='\0';
+    }
+    else if (strcmp(argv[i],"-olac") == 0)
+    {
+      specified = TRUE;
+      format = LAS_TOOLS_FORMAT_LAC;
+      *argv[i]='\0';
+    }
     else if (strcmp(argv[i],"-otxt") == 0)
     {
       specified = TRUE;
@@ -409,6 +482,16 @@ bool LASwriteOpener::parse(int argc, char* argv[])
       set_io_obuffer_size((I32)atoi(argv[i+1]));
       *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
     }
+    else if (strcmp(argv[i],"-async_obuffers") == 0)
+    {
+      if ((i+1) >= argc)
+      {
+        fprintf(stderr,"ERROR: '%s' needs 1 argument: number\n", argv[i]);
+        return FALSE;
+      }
+      set_async_obuffers((U32)atoi(argv[i+1]));
+      *argv[i]='\0'; *argv[i+1]='\0'; i+=1;
+    }
   }
   return TRUE;
 }
@@ -418,6 +501,11 @@ void LASwriteOpener::set_io_obuffer_size(I32 io_obuffer_size)
   this->io_obuffer_size = io_obuffer_size;
 }
 
+void LASwriteOpener::set_async_obuffers(U32 async_obuffers)
+{
+  this->async_obuffers = async_obuffers;
+}
+
 void LASwriteOpener::set_directory(const CHAR* directory)
 {
   if (this->directory) free(this->directory);
@@ -461,6 +549,14 @@ void LASwriteOpener::set_file_name(const CHAR* file_name)
       {
         this->format = LAS_TOOLS_FORMAT_LAS;
       }
+      else if (strstr(format, ".laf") || strstr(format, ".LAF"))
+      {
+        this->format = LAS_TOOLS_FORMAT_LAF;
+      }
+      else if (strstr(format, ".lac") || strstr(format, ".LAC"))
+      {
+        this->format = LAS_TOOLS_FORMAT_LAC;
+      }
       else if (strstr(format, ".bin") || strstr(format, ".BIN")) // terrasolid
       {
         this->format = LAS_TOOLS_FORMAT_BIN;
@@ -512,7 +608,7 @@ void LASwriteOpener::set_cut(U32 cut)
 
 bool LASwriteOpener::set_format(I32 format)
 {
-  if ((format < LAS_TOOLS_FORMAT_DEFAULT) || (format > LAS_TOOLS_FORMAT_TXT))
+  if ((format < LAS_TOOLS_FORMAT_DEFAULT) || ((format > LAS_TOOLS_FORMAT_TXT) && (format != LAS_TOOLS_FORMAT_LAF) && (format != LAS_TOOLS_FORMAT_LAC)))
   {
     return FALSE;
   }
@@ -541,6 +637,18 @@ bool LASwriteOpener::set_format(I32 format)
         file_name[len+2] = 'a';
         file_name[len+3] = 'z';
 	    }
+      else if (format == LAS_TOOLS_FORMAT_LAF)
+	    {
+        file_name[len+1] = 'l';
+        file_name[len+2] = 'a';
+        file_name[len+3] = 'f';
+	    }
+      else if (format == LAS_TOOLS_FORMAT_LAC)
+	    {
+        file_name[len+1] = 'l';
+        file_name[len+2] = 'a';
+        file_name[len+3] = 'c';
+	    }
       else if (format == LAS_TOOLS_FORMAT_BIN)
 	    {
         file_name[len+1] = 'l';
@@ -587,6 +695,14 @@ bool LASwriteOpener::set_format(const CHAR* format)
     {
       return set_format(LAS_TOOLS_FORMAT_LAS);
     }
+    else if (strstr(format, "laf") || strstr(format, "LAF"))
+    {
+      return set_format(LAS_TOOLS_FORMAT_LAF);
+    }
+    else if (strstr(format, "lac") || strstr(format, "LAC"))
+    {
+      return set_format(LAS_TOOLS_FORMAT_LAC);
+    }
     else if (strstr(format, "bin") || strstr(format, "BIN")) // terrasolid
     {
       return set_format(LAS_TOOLS_FORMAT_BIN);
@@ -749,6 +865,18 @@ void LASwriteOpener::make_file_name(const CHAR* file_name, I32 file_number)
     this->file_name[len+1] = 'a';
     this->file_name[len+2] = 'z';
   }
+  else if (format == LAS_TOOLS_FORMAT_LAF)
+  {
+    this->file_name[len] = 'l';
+    this->file_name[len+1] = 'a';
+    this->file_name[len+2] = 'f';
+  }
+  else if (format == LAS_TOOLS_FORMAT_LAC)
+  {
+    this->file_name[len] = 'l';
+    this->file_name[len+1] = 'a';
+    this->file_name[len+2] = 'c';
+  }
   else if (format == LAS_TOOLS_FORMAT_BIN)
   {
     this->file_name[len] = 'b';
@@ -784,6 +912,14 @@ void LASwriteOpener::make_file_name(const CHAR* file_name, I32 file_number)
       {
         this->file_name = strdup("temp.laz");
       }
+      else if (format == LAS_TOOLS_FORMAT_LAF)
+      {
+        this->file_name = strdup("temp.laf");
+      }
+      else if (format == LAS_TOOLS_FORMAT_LAC)
+      {
+        this->file_name = strdup("temp.lac");
+      }
       else if (format == LAS_TOOLS_FORMAT_BIN)
       {
         this->file_name = strdup("temp.bin");
@@ -857,7 +993,7 @@ bool LASwriteOpener::format_was_specified() const
   return specified;
 }
 
-static const CHAR* LAS_TOOLS_FORMAT_NAMES[11] = { "las", "las", "laz", "bin", "qi", "wrl", "txt", "shp", "asc", "bil", "flt" };
+static const CHAR* LAS_TOOLS_FORMAT_NAMES[14] = { "las", "las", "laz", "bin", "qi", "wrl", "txt", "shp", "asc", "bil", "flt", "dtm", "laf", "lac" };
 
 const CHAR* LASwriteOpener::get_format_name() const
 {
@@ -880,6 +1016,14 @@ I32 LASwriteOpener::get_format() const
     {
       return LAS_TOOLS_FORMAT_LAS;
     }
+    else if (strstr(file_name, ".laf") || strstr(file_name, ".LAF"))
+    {
+      return LAS_TOOLS_FORMAT_LAF;
+    }
+    else if (strstr(file_name, ".lac") || strstr(file_name, ".LAC"))
+    {
+      return LAS_TOOLS_FORMAT_LAC;
+    }
     else if (strstr(file_name, ".bin") || strstr(file_name, ".BIN")) // terrasolid
     {
       return LAS_TOOLS_FORMAT_BIN;
@@ -1003,6 +1147,7 @@ void LASwriteOpener::cut_characters(U32 cut)
 LASwriteOpener::LASwriteOpener()
 {
   io_obuffer_size = 262144;
+  async_obuffers = 0;
   directory = 0;
   file_name = 0;
   appendix = 0;
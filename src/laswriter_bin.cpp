@@ -31,6 +31,7 @@
 #include "laswriter_bin.hpp"
 
 #include "bytestreamout_file.hpp"
+#include "bytestreamout_async.hpp"
 
 #ifdef _WIN32
 #include <fcntl.h>
@@ -82,6 +83,7 @@ bool LASwriterBIN::refile(FILE* file)
 {
   if (stream == 0) return FALSE;
   if (this->file) this->file = file;
+  if (async_stream) return async_stream->refile(file);
   return ((ByteStreamOutFile*)stream)->refile(file);
 }
 
@@ -101,16 +103,28 @@ bool LASwriterBIN::open(const char* file_name, const LASheader* header, const ch
     return FALSE;
   }
 
-  if (setvbuf(file, NULL, _IOFBF, io_buffer_size) != 0)
+  ByteStreamOut* out;
+  if (async_buffers)
   {
-    fprintf(stderr, "WARNING: setvbuf() failed with buffer size %u\n", io_buffer_size);
+    // our blocks replace the stdio buffer
+    setvbuf(file, NULL, _IONBF, 0);
+    if (IS_LITTLE_ENDIAN())
+      async_stream = new ByteStreamOutFileAsyncLE(file, io_buffer_size, async_buffers);
+    else
+      async_stream = new ByteStreamOutFileAsyncBE(file, io_buffer_size, async_buffers);
+    out = async_stream;
   }
-
-  ByteStreamOut* out;
-  if (IS_LITTLE_ENDIAN())
-    out = new ByteStreamOutFileLE(file);
   else
-    out = new ByteStreamOutFileBE(file);
+  {
+    if (setvbuf(file, NULL, _IOFBF, io_buffer_size) != 0)
+    {
+      fprintf(stderr, "WARNING: setvbuf() failed with buffer size %u\n", io_buffer_size);
+    }
+    if (IS_LITTLE_ENDIAN())
+      out = new ByteStreamOutFileLE(file);
+    else
+      out = new ByteStreamOutFileBE(file);
+  }
 
   return open(out, header, version);
 }
@@ -250,6 +264,7 @@ bool LASwriterBIN::update_header(const LASheader* header, bool use_inventory, bo
 I64 LASwriterBIN::close(bool update_header)
 {
   I64 bytes = 0;
+  bool failed = FALSE;
   
   if (stream)
   {
@@ -271,6 +286,16 @@ I64 LASwriterBIN::close(bool update_header)
       }
     }
     bytes = stream->tell();
+    if (async_stream)
+    {
+      // errors of the I/O thread surface here
+      if (!async_stream->flush())
+      {
+        fprintf(stderr, "ERROR: writing blocks to file failed\n");
+        failed = TRUE;
+      }
+      async_stream = 0;
+    }
     delete stream;
     stream = 0;
   }
@@ -284,12 +309,14 @@ I64 LASwriterBIN::close(bool update_header)
   npoints = p_count;
   p_count = 0;
 
-  return bytes;
+  return (failed ? -1 : bytes);
 }
 
 LASwriterBIN::LASwriterBIN()
 {
   stream = 0;
+  async_stream = 0;
+  async_buffers = 0;
   file = 0;
 }
 
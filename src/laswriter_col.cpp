@@ -0,0 +1,752 @@
+/*
+===============================================================================
+
+  FILE:  laswriter_col.cpp
+
+  CONTENTS:
+
+    see corresponding header file
+
+  PROGRAMMERS:
+
+    martin.isenburg@rapidlasso.com  -  http://rapidlasso.com
+
+  COPYRIGHT:
+
+    (c) 2007-2014, martin isenburg, rapidlasso - fast tools to catch reality
+
+    This is free software; you can redistribute and/or modify it under the
+    terms of the GNU Lesser General Licence as published by the Free Software
+    Foundation. See the LICENSE.txt file for more information.
+
+    This software is distributed WITHOUT ANY WARRANTY and without even the
+    implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+  CHANGE HISTORY:
+
+    see corresponding header file
+
+===============================================================================
+*/
+#include "laswriter_col.hpp"
+
+#include "laswriter_las.hpp"
+#include "laspointfast.hpp"
+#include "bytestreamout_file.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+// layout of a LAC file
+//   U8  magic "LASC"
+//   U32 version (1)
+//   for each chunk and each column
+//     for each byte of the values
+//       U32 size of the byte plane (top bit set when the plane is stored raw)
+//       U8  bytes of the byte plane
+// layout of the footer
+//   U32 size of the LAS header
+//   U8  LAS header with all VLRs (and EVLRs)
+//   U32 number of columns
+//   for each column
+//     CHAR name[32]
+//     U8  type
+//     U8  delta
+//     U16 width
+//   U32 number of chunks
+//   for each chunk
+//     U32 number of points
+//     for each column
+//       I64 offset
+//       U32 number of bytes
+//       F64 min
+//       F64 max
+//   I64 start of the footer
+//   U8  magic "LASC"
+
+static const CHAR* const las_column_names[LAS_COLUMN_ATTRIBUTE] =
+{
+  "X", "Y", "Z", "intensity", "return_number", "number_of_returns", "scan_direction_flag", "edge_of_flight_line",
+  "classification", "synthetic_flag", "keypoint_flag", "withheld_flag", "scan_angle_rank", "user_data", "point_source_ID",
+  "gps_time", "red", "green", "blue", "NIR", "wavepacket"
+};
+
+bool LAScolumn::set_field(const LASattributer* attributer)
+{
+  I32 i;
+  for (i = 0; i < LAS_COLUMN_ATTRIBUTE; i++)
+  {
+    if (strncmp(name, las_column_names[i], 32) == 0)
+    {
+      field = i;
+      start = 0;
+      return TRUE;
+    }
+  }
+  field = LAS_COLUMN_ATTRIBUTE;
+  // extra bytes that no attribute describes
+  if (strncmp(name, "extra_bytes", 32) == 0)
+  {
+    start = (attributer ? attributer->get_attributes_size() : 0);
+    return TRUE;
+  }
+  if (attributer)
+  {
+    for (i = 0; i < attributer->number_attributes; i++)
+    {
+      if ((strncmp(name, attributer->attributes[i].name, 32) == 0) && (width == attributer->attribute_sizes[i]))
+      {
+        start = attributer->attribute_starts[i];
+        return TRUE;
+      }
+    }
+  }
+  return FALSE;
+}
+
+F64 LAScolumn::get_value(const U8* value) const
+{
+  switch (type)
+  {
+  case LAS_ATTRIBUTE_U8:
+    return (F64)value[0];
+  case LAS_ATTRIBUTE_I8:
+    return (F64)((I8)value[0]);
+  case LAS_ATTRIBUTE_U16:
+    {
+      U16 u16;
+      memcpy(&u16, value, 2);
+      return (F64)u16;
+    }
+  case LAS_ATTRIBUTE_I16:
+    {
+      I16 i16;
+      memcpy(&i16, value, 2);
+      return (F64)i16;
+    }
+  case LAS_ATTRIBUTE_U32:
+    {
+      U32 u32;
+      memcpy(&u32, value, 4);
+      return (F64)u32;
+    }
+  case LAS_ATTRIBUTE_I32:
+    {
+      I32 i32;
+      memcpy(&i32, value, 4);
+      return (F64)i32;
+    }
+  case LAS_ATTRIBUTE_U64:
+    {
+      U64 u64;
+      memcpy(&u64, value, 8);
+      return (F64)(I64)u64;
+    }
+  case LAS_ATTRIBUTE_I64:
+    {
+      I64 i64;
+      memcpy(&i64, value, 8);
+      return (F64)i64;
+    }
+  case LAS_ATTRIBUTE_F32:
+    {
+      F32 f32;
+      memcpy(&f32, value, 4);
+      return (F64)f32;
+    }
+  case LAS_ATTRIBUTE_F64:
+    {
+      F64 f64;
+      memcpy(&f64, value, 8);
+      return f64;
+    }
+  }
+  return 0.0;
+}
+
+void LAScolumn::get(const LASpoint* point, U8* value) const
+{
+  switch (field)
+  {
+  case LAS_COLUMN_X:
+    memcpy(value, &(point->X), 4);
+    break;
+  case LAS_COLUMN_Y:
+    memcpy(value, &(point->Y), 4);
+    break;
+  case LAS_COLUMN_Z:
+    memcpy(value, &(point->Z), 4);
+    break;
+  case LAS_COLUMN_INTENSITY:
+    memcpy(value, &(point->intensity), 2);
+    break;
+  case LAS_COLUMN_RETURN_NUMBER:
+    value[0] = point->return_number;
+    break;
+  case LAS_COLUMN_NUMBER_OF_RETURNS:
+    value[0] = point->number_of_returns;
+    break;
+  case LAS_COLUMN_SCAN_DIRECTION_FLAG:
+    value[0] = point->scan_direction_flag;
+    break;
+  case LAS_COLUMN_EDGE_OF_FLIGHT_LINE:
+    value[0] = point->edge_of_flight_line;
+    break;
+  case LAS_COLUMN_CLASSIFICATION:
+    value[0] = point->classification;
+    break;
+  case LAS_COLUMN_SYNTHETIC_FLAG:
+    value[0] = point->synthetic_flag;
+    break;
+  case LAS_COLUMN_KEYPOINT_FLAG:
+    value[0] = point->keypoint_flag;
+    break;
+  case LAS_COLUMN_WITHHELD_FLAG:
+    value[0] = point->withheld_flag;
+    break;
+  case LAS_COLUMN_SCAN_ANGLE_RANK:
+    value[0] = (U8)point->scan_angle_rank;
+    break;
+  case LAS_COLUMN_USER_DATA:
+    value[0] = point->user_data;
+    break;
+  case LAS_COLUMN_POINT_SOURCE_ID:
+    memcpy(value, &(point->point_source_ID), 2);
+    break;
+  case LAS_COLUMN_GPS_TIME:
+    memcpy(value, &(point->gps_time), 8);
+    break;
+  case LAS_COLUMN_RED:
+  case LAS_COLUMN_GREEN:
+  case LAS_COLUMN_BLUE:
+  case LAS_COLUMN_NIR:
+    memcpy(value, &(point->rgb[field - LAS_COLUMN_RED]), 2);
+    break;
+  case LAS_COLUMN_WAVEPACKET:
+    memcpy(value, &(point->wavepacket), width);
+    break;
+  default:
+    memcpy(value, point->extra_bytes + start, width);
+  }
+}
+
+void LAScolumn::set(LASpoint* point, const U8* value) const
+{
+  switch (field)
+  {
+  case LAS_COLUMN_X:
+    memcpy(&(point->X), value, 4);
+    break;
+  case LAS_COLUMN_Y:
+    memcpy(&(point->Y), value, 4);
+    break;
+  case LAS_COLUMN_Z:
+    memcpy(&(point->Z), value, 4);
+    break;
+  case LAS_COLUMN_INTENSITY:
+    memcpy(&(point->intensity), value, 2);
+    break;
+  case LAS_COLUMN_RETURN_NUMBER:
+    point->return_number = value[0];
+    break;
+  case LAS_COLUMN_NUMBER_OF_RETURNS:
+    point->number_of_returns = value[0];
+    break;
+  case LAS_COLUMN_SCAN_DIRECTION_FLAG:
+    point->scan_direction_flag = value[0];
+    break;
+  case LAS_COLUMN_EDGE_OF_FLIGHT_LINE:
+    point->edge_of_flight_line = value[0];
+    break;
+  case LAS_COLUMN_CLASSIFICATION:
+    point->classification = value[0];
+    break;
+  case LAS_COLUMN_SYNTHETIC_FLAG:
+    point->synthetic_flag = value[0];
+    break;
+  case LAS_COLUMN_KEYPOINT_FLAG:
+    point->keypoint_flag = value[0];
+    break;
+  case LAS_COLUMN_WITHHELD_FLAG:
+    point->withheld_flag = value[0];
+    break;
+  case LAS_COLUMN_SCAN_ANGLE_RANK:
+    point->scan_angle_rank = (I8)value[0];
+    break;
+  case LAS_COLUMN_USER_DATA:
+    point->user_data = value[0];
+    break;
+  case LAS_COLUMN_POINT_SOURCE_ID:
+    memcpy(&(point->point_source_ID), value, 2);
+    break;
+  case LAS_COLUMN_GPS_TIME:
+    memcpy(&(point->gps_time), value, 8);
+    break;
+  case LAS_COLUMN_RED:
+  case LAS_COLUMN_GREEN:
+  case LAS_COLUMN_BLUE:
+  case LAS_COLUMN_NIR:
+    memcpy(&(point->rgb[field - LAS_COLUMN_RED]), value, 2);
+    break;
+  case LAS_COLUMN_WAVEPACKET:
+    memcpy(&(point->wavepacket), value, width);
+    break;
+  default:
+    memcpy(point->extra_bytes + start, value, width);
+  }
+}
+
+bool LASwriterCOL::open(const char* file_name, const LASheader* header, U32 chunk_size, U32 io_buffer_size)
+{
+  if (file_name == 0)
+  {
+    fprintf(stderr,"ERROR: file name pointer is zero\n");
+    return FALSE;
+  }
+
+  file = fopen(file_name, "wb");
+
+  if (file == 0)
+  {
+    fprintf(stderr, "ERROR: cannot open file '%s'\n", file_name);
+    return FALSE;
+  }
+
+  if (setvbuf(file, NULL, _IOFBF, io_buffer_size) != 0)
+  {
+    fprintf(stderr, "WARNING: setvbuf() failed with buffer size %u\n", io_buffer_size);
+  }
+
+  ByteStreamOut* out;
+  if (IS_LITTLE_ENDIAN())
+    out = new ByteStreamOutFileLE(file);
+  else
+    out = new ByteStreamOutFileBE(file);
+
+  return open(out, header, chunk_size);
+}
+
+bool LASwriterCOL::open(FILE* file, const LASheader* header, U32 chunk_size)
+{
+  if (file == 0)
+  {
+    fprintf(stderr,"ERROR: file pointer is zero\n");
+    return FALSE;
+  }
+
+#ifdef _WIN32
+  if (file == stdout)
+  {
+    if(_setmode( _fileno( stdout ), _O_BINARY ) == -1 )
+    {
+      fprintf(stderr, "ERROR: cannot set stdout to binary (untranslated) mode\n");
+    }
+  }
+#endif
+
+  ByteStreamOut* out;
+  if (IS_LITTLE_ENDIAN())
+    out = new ByteStreamOutFileLE(file);
+  else
+    out = new ByteStreamOutFileBE(file);
+
+  return open(out, header, chunk_size);
+}
+
+bool LASwriterCOL::open(ByteStreamOut* stream, const LASheader* header, U32 chunk_size)
+{
+  U32 i;
+
+  if (stream == 0)
+  {
+    fprintf(stderr,"ERROR: ByteStreamOut pointer is zero\n");
+    return FALSE;
+  }
+  this->stream = stream;
+
+  if (header == 0)
+  {
+    fprintf(stderr,"ERROR: LASheader pointer is zero\n");
+    return FALSE;
+  }
+
+  if (!IS_LITTLE_ENDIAN())
+  {
+    fprintf(stderr,"ERROR: columnar files need a little-endian machine\n");
+    return FALSE;
+  }
+
+  // the header with all its VLRs is kept exactly as a LAS file would have it
+
+  headerstream = new ostringstream();
+  headerwriter = new LASwriterLAS();
+  if (!headerwriter->open(*headerstream, header))
+  {
+    fprintf(stderr,"ERROR: cannot write LAS header of columnar file\n");
+    return FALSE;
+  }
+
+  quantizer = *header;
+  npoints = header->number_of_point_records;
+  p_count = 0;
+
+  // which fields the points have follows from their format
+
+  LASpoint point;
+  if (!point.init(header, header->point_data_format, header->point_data_record_length, header)) return FALSE;
+
+  if (!add_column("X", LAS_ATTRIBUTE_I32, 4, TRUE, header)) return FALSE;
+  if (!add_column("Y", LAS_ATTRIBUTE_I32, 4, TRUE, header)) return FALSE;
+  if (!add_column("Z", LAS_ATTRIBUTE_I32, 4, TRUE, header)) return FALSE;
+  if (!add_column("intensity", LAS_ATTRIBUTE_U16, 2, FALSE, header)) return FALSE;
+  if (!add_column("return_number", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("number_of_returns", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("scan_direction_flag", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("edge_of_flight_line", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("classification", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("synthetic_flag", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("keypoint_flag", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("withheld_flag", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("scan_angle_rank", LAS_ATTRIBUTE_I8, 1, FALSE, header)) return FALSE;
+  if (!add_column("user_data", LAS_ATTRIBUTE_U8, 1, FALSE, header)) return FALSE;
+  if (!add_column("point_source_ID", LAS_ATTRIBUTE_U16, 2, FALSE, header)) return FALSE;
+  if (point.have_gps_time)
+  {
+    // nearby doubles also have nearby bit patterns
+    if (!add_column("gps_time", LAS_ATTRIBUTE_F64, 8, TRUE, header)) return FALSE;
+  }
+  if (point.have_rgb)
+  {
+    if (!add_column("red", LAS_ATTRIBUTE_U16, 2, TRUE, header)) return FALSE;
+    if (!add_column("green", LAS_ATTRIBUTE_U16, 2, TRUE, header)) return FALSE;
+    if (!add_column("blue", LAS_ATTRIBUTE_U16, 2, TRUE, header)) return FALSE;
+    if (point.have_nir)
+    {
+      if (!add_column("NIR", LAS_ATTRIBUTE_U16, 2, TRUE, header)) return FALSE;
+    }
+  }
+  if (point.have_wavepacket)
+  {
+    if (!add_column("wavepacket", LAS_COLUMN_BYTES, 29, FALSE, header)) return FALSE;
+  }
+  for (i = 0; i < (U32)header->number_attributes; i++)
+  {
+    // only attributes with a single value get statistics
+    const LASattribute* attribute = &(header->attributes[i]);
+    U8 type = (((attribute->data_type >= 1) && (attribute->data_type <= 10)) ? (U8)(attribute->data_type - 1) : LAS_COLUMN_BYTES);
+    if (!add_column(attribute->name, type, (U16)header->attribute_sizes[i], FALSE, header)) return FALSE;
+  }
+  if (point.extra_bytes_number > header->get_attributes_size())
+  {
+    if (!add_column("extra_bytes", LAS_COLUMN_BYTES, (U16)(point.extra_bytes_number - header->get_attributes_size()), FALSE, header)) return FALSE;
+  }
+
+  // buffers for the values of one chunk
+
+  this->chunk_size = ((chunk_size == 0) || (chunk_size == U32_MAX) ? 50000 : chunk_size);
+  U32 max_width = 0;
+  values = (U8**)calloc(number_columns, sizeof(U8*));
+  if (values == 0) return FALSE;
+  for (i = 0; i < number_columns; i++)
+  {
+    values[i] = (U8*)malloc((size_t)this->chunk_size*columns[i].width);
+    if (values[i] == 0)
+    {
+      fprintf(stderr,"ERROR: cannot allocate column '%s' for chunks of %u points\n", columns[i].name, this->chunk_size);
+      return FALSE;
+    }
+    if (columns[i].width > max_width) max_width = columns[i].width;
+  }
+  planes = (U8*)malloc((size_t)this->chunk_size*max_width);
+  compressed = (U8*)malloc(this->chunk_size);
+  hash_table = (U32*)malloc(sizeof(U32) << LAS_FAST_HASH_BITS);
+  if ((planes == 0) || (compressed == 0) || (hash_table == 0))
+  {
+    fprintf(stderr,"ERROR: cannot allocate buffers for chunks of %u points\n", this->chunk_size);
+    return FALSE;
+  }
+  points_in_chunk = 0;
+
+  if (!stream->putBytes((U8*)LAS_COLUMN_MAGIC, 4)) return FALSE;
+  U32 version = LAS_COLUMN_VERSION;
+  if (!stream->put32bitsLE((U8*)&version)) return FALSE;
+  bytes_written = 8;
+  return TRUE;
+}
+
+bool LASwriterCOL::add_column(const CHAR* name, U8 type, U16 width, bool delta, const LASattributer* attributer)
+{
+  columns = (LAScolumn*)realloc(columns, sizeof(LAScolumn)*(number_columns+1));
+  if (columns == 0)
+  {
+    fprintf(stderr,"ERROR: cannot allocate column '%s'\n", name);
+    return FALSE;
+  }
+  LAScolumn* column = &(columns[number_columns]);
+  memset(column, 0, sizeof(LAScolumn));
+  strncpy(column->name, name, 32);
+  column->type = type;
+  column->delta = (delta ? 1 : 0);
+  column->width = width;
+  if (!column->set_field(attributer))
+  {
+    fprintf(stderr,"ERROR: no point field for column '%s'\n", name);
+    return FALSE;
+  }
+  number_columns++;
+  return TRUE;
+}
+
+bool LASwriterCOL::write_point(const LASpoint* point)
+{
+  U32 i;
+  for (i = 0; i < number_columns; i++)
+  {
+    columns[i].get(point, values[i] + points_in_chunk*columns[i].width);
+  }
+  p_count++;
+  points_in_chunk++;
+  if (points_in_chunk == chunk_size) return write_chunk();
+  return TRUE;
+}
+
+bool LASwriterCOL::chunk()
+{
+  return write_chunk();
+}
+
+bool LASwriterCOL::write_chunk()
+{
+  if (points_in_chunk == 0) return TRUE;
+  U32 i, c, b;
+  U32 number = points_in_chunk;
+
+  if (number_chunks == alloc_chunks)
+  {
+    alloc_chunks += 1024;
+    chunk_points = (U32*)realloc(chunk_points, sizeof(U32)*alloc_chunks);
+    column_chunks = (LAScolumnChunk*)realloc(column_chunks, sizeof(LAScolumnChunk)*alloc_chunks*number_columns);
+    if ((chunk_points == 0) || (column_chunks == 0))
+    {
+      fprintf(stderr,"ERROR: cannot allocate chunk table for %u chunks\n", alloc_chunks);
+      return FALSE;
+    }
+  }
+  chunk_points[number_chunks] = number;
+
+  for (c = 0; c < number_columns; c++)
+  {
+    const LAScolumn* column = &(columns[c]);
+    LAScolumnChunk* column_chunk = &(column_chunks[number_chunks*number_columns + c]);
+    U32 width = column->width;
+    U8* value = values[c];
+
+    // the statistics are taken before the deltas
+
+    column_chunk->min = column_chunk->max = 0.0;
+    if (column->type != LAS_COLUMN_BYTES)
+    {
+      column_chunk->min = column_chunk->max = column->get_value(value);
+      for (i = 1; i < number; i++)
+      {
+        F64 v = column->get_value(value + i*width);
+        if (v < column_chunk->min) column_chunk->min = v;
+        else if (v > column_chunk->max) column_chunk->max = v;
+      }
+    }
+    if (column->delta)
+    {
+      LASfastCoder::delta_encode(value, number, width, width);
+    }
+
+    // the i-th bytes of all values are compressed together
+
+    column_chunk->offset = bytes_written;
+    for (b = 0; b < width; b++)
+    {
+      U8* plane = planes + b*number;
+      const U8* v = value + b;
+      for (i = 0; i < number; i++, v += width) plane[i] = *v;
+      U32 size = LASfastCoder::compress(plane, number, compressed, hash_table);
+      if (size)
+      {
+        if (!stream->put32bitsLE((U8*)&size)) return FALSE;
+        if (!stream->putBytes(compressed, size)) return FALSE;
+        bytes_written += 4 + size;
+      }
+      else
+      {
+        size = number | LAS_FAST_RAW_COLUMN;
+        if (!stream->put32bitsLE((U8*)&size)) return FALSE;
+        if (!stream->putBytes(plane, number)) return FALSE;
+        bytes_written += 4 + number;
+      }
+    }
+    column_chunk->bytes = (U32)(bytes_written - column_chunk->offset);
+  }
+
+  number_chunks++;
+  points_in_chunk = 0;
+  return TRUE;
+}
+
+bool LASwriterCOL::write_footer()
+{
+  U32 i, c;
+  I64 footer_start = bytes_written;
+
+  string blob = headerstream->str();
+  U32 size = (U32)blob.size();
+  if (!stream->put32bitsLE((U8*)&size)) return FALSE;
+  if (!stream->putBytes((U8*)blob.data(), size)) return FALSE;
+
+  if (!stream->put32bitsLE((U8*)&number_columns)) return FALSE;
+  for (c = 0; c < number_columns; c++)
+  {
+    if (!stream->putBytes((U8*)columns[c].name, 32)) return FALSE;
+    if (!stream->putBytes(&(columns[c].type), 1)) return FALSE;
+    if (!stream->putBytes(&(columns[c].delta), 1)) return FALSE;
+    if (!stream->put16bitsLE((U8*)&(columns[c].width))) return FALSE;
+  }
+
+  if (!stream->put32bitsLE((U8*)&number_chunks)) return FALSE;
+  for (i = 0; i < number_chunks; i++)
+  {
+    if (!stream->put32bitsLE((U8*)&(chunk_points[i]))) return FALSE;
+    for (c = 0; c < number_columns; c++)
+    {
+      const LAScolumnChunk* column_chunk = &(column_chunks[i*number_columns + c]);
+      if (!stream->put64bitsLE((U8*)&(column_chunk->offset))) return FALSE;
+      if (!stream->put32bitsLE((U8*)&(column_chunk->bytes))) return FALSE;
+      if (!stream->put64bitsLE((U8*)&(column_chunk->min))) return FALSE;
+      if (!stream->put64bitsLE((U8*)&(column_chunk->max))) return FALSE;
+    }
+  }
+
+  // readers find the footer via the last twelve bytes
+  if (!stream->put64bitsLE((U8*)&footer_start)) return FALSE;
+  if (!stream->putBytes((U8*)LAS_COLUMN_MAGIC, 4)) return FALSE;
+  bytes_written += 4 + size + 4 + 36*number_columns + 4 + number_chunks*(4 + 28*number_columns) + 12;
+  return TRUE;
+}
+
+bool LASwriterCOL::update_header(const LASheader* header, bool use_inventory, bool update_extra_bytes)
+{
+  if (headerwriter == 0)
+  {
+    fprintf(stderr,"ERROR: header writer pointer is zero\n");
+    return FALSE;
+  }
+  headerwriter->inventory = inventory;
+  bool success = headerwriter->update_header(header, use_inventory, update_extra_bytes);
+  npoints = headerwriter->npoints;
+  return success;
+}
+
+I64 LASwriterCOL::close(bool update_npoints)
+{
+  I64 bytes = 0;
+  bool failed = FALSE;
+
+  if (stream)
+  {
+    if (!write_chunk())
+    {
+      fprintf(stderr, "ERROR: writing last chunk of columns failed\n");
+      failed = TRUE;
+    }
+    if (headerwriter)
+    {
+      // warns like the LAS writer when the number of points is off
+      headerwriter->p_count = p_count;
+      if (headerwriter->close(update_npoints) < 0)
+      {
+        fprintf(stderr, "ERROR: writing LAS header of columnar file failed\n");
+        failed = TRUE;
+      }
+      else if (!write_footer())
+      {
+        fprintf(stderr, "ERROR: writing footer of %u columns in %u chunks failed\n", number_columns, number_chunks);
+        failed = TRUE;
+      }
+    }
+    bytes = bytes_written;
+    delete stream;
+    stream = 0;
+  }
+
+  if (file)
+  {
+    fclose(file);
+    file = 0;
+  }
+
+  if (headerwriter)
+  {
+    delete headerwriter;
+    headerwriter = 0;
+  }
+  if (headerstream)
+  {
+    delete headerstream;
+    headerstream = 0;
+  }
+  if (values)
+  {
+    U32 i;
+    for (i = 0; i < number_columns; i++) if (values[i]) free(values[i]);
+    free(values);
+    values = 0;
+  }
+  if (columns) free(columns);
+  if (planes) free(planes);
+  if (compressed) free(compressed);
+  if (hash_table) free(hash_table);
+  if (chunk_points) free(chunk_points);
+  if (column_chunks) free(column_chunks);
+  columns = 0;
+  number_columns = 0;
+  planes = 0;
+  compressed = 0;
+  hash_table = 0;
+  chunk_points = 0;
+  column_chunks = 0;
+  number_chunks = 0;
+  alloc_chunks = 0;
+
+  npoints = p_count;
+  p_count = 0;
+
+  return (failed ? -1 : bytes);
+}
+
+LASwriterCOL::LASwriterCOL()
+{
+  stream = 0;
+  file = 0;
+  bytes_written = 0;
+  headerwriter = 0;
+  headerstream = 0;
+  chunk_size = 50000;
+  points_in_chunk = 0;
+  number_columns = 0;
+  columns = 0;
+  values = 0;
+  planes = 0;
+  compressed = 0;
+  hash_table = 0;
+  number_chunks = 0;
+  alloc_chunks = 0;
+  chunk_points = 0;
+  column_chunks = 0;
+}
+
+LASwriterCOL::~LASwriterCOL()
+{
+  if (stream || headerwriter) close();
+}
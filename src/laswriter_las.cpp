@@ -32,12 +32,22 @@
 
 #include "bytestreamout_nil.hpp"
 #include "bytestreamout_file.hpp"
+#include "bytestreamout_async.hpp"
 #include "bytestreamout_ostream.hpp"
 #include "laswritepoint.hpp"
+#include "laspointfast.hpp"
+#include "laspointraw.hpp"
+#include "arithmeticencoder.hpp"
+#include "integercompressor.hpp"
 
 #ifdef _WIN32
 #include <fcntl.h>
 #include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #include <stdlib.h>
@@ -46,7 +56,9 @@
 bool LASwriterLAS::refile(FILE* file)
 {
   if (stream == 0) return FALSE;
+  if (!flush_raw_points()) return FALSE;
   if (this->file) this->file = file;
+  if (async_stream) return async_stream->refile(file);
   return ((ByteStreamOutFile*)stream)->refile(file);
 }
 
@@ -64,23 +76,36 @@ bool LASwriterLAS::open(const char* file_name, const LASheader* header, U32 comp
     return FALSE;
   }
 
-  file = fopen(file_name, "wb");
+  // read access as well so that map_points() can map the file
+  file = fopen(file_name, "w+b");
   if (file == 0)
   {
     fprintf(stderr, "ERROR: cannot open file '%s'\n", file_name);
     return FALSE;
   }
 
-  if (setvbuf(file, NULL, _IOFBF, io_buffer_size) != 0)
+  ByteStreamOut* out;
+  if (async_buffers)
   {
-    fprintf(stderr, "WARNING: setvbuf() failed with buffer size %d\n", io_buffer_size);
+    // our blocks replace the stdio buffer
+    setvbuf(file, NULL, _IONBF, 0);
+    if (IS_LITTLE_ENDIAN())
+      async_stream = new ByteStreamOutFileAsyncLE(file, io_buffer_size, async_buffers);
+    else
+      async_stream = new ByteStreamOutFileAsyncBE(file, io_buffer_size, async_buffers);
+    out = async_stream;
   }
-
-  ByteStreamOut* out;
-  if (IS_LITTLE_ENDIAN())
-    out = new ByteStreamOutFileLE(file);
   else
-    out = new ByteStreamOutFileBE(file);
+  {
+    if (setvbuf(file, NULL, _IOFBF, io_buffer_size) != 0)
+    {
+      fprintf(stderr, "WARNING: setvbuf() failed with buffer size %d\n", io_buffer_size);
+    }
+    if (IS_LITTLE_ENDIAN())
+      out = new ByteStreamOutFileLE(file);
+    else
+      out = new ByteStreamOutFileBE(file);
+  }
 
   return open(out, header, compressor, requested_version, chunk_size);
 }
@@ -170,6 +195,18 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
     point_data_record_length = header->point_data_record_length;
   }
 
+  if (chunk_copy && (compressor != LASZIP_COMPRESSOR_CHUNKED))
+  {
+    fprintf(stderr,"ERROR: copying chunks needs chunked compression\n");
+    return FALSE;
+  }
+
+  if (fast_compression && ((compressor != LASZIP_COMPRESSOR_NONE) || chunk_copy || (point_is_standard == FALSE)))
+  {
+    fprintf(stderr,"ERROR: fast compression needs standard points and no LASzip compression\n");
+    return FALSE;
+  }
+
   // do we need a laszip VLR (because we compress or use non-standard points?) 
 
   LASzip* laszip = 0;
@@ -179,6 +216,7 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
     laszip = new LASzip();
     laszip->setup(point.num_items, point.items, compressor);
     if (chunk_size > -1) laszip->set_chunk_size((U32)chunk_size);
+    if (chunk_copy || variable_chunking) laszip->set_chunk_size(U32_MAX);
     if (compressor == LASZIP_COMPRESSOR_NONE) laszip->request_version(0);
     else if (chunk_size == 0) { fprintf(stderr,"ERROR: adaptive chunking is depricated\n"); return FALSE; }
     else if (requested_version) laszip->request_version(requested_version);
@@ -188,21 +226,33 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
 
   // create and setup the point writer
 
-  writer = new LASwritePoint();
-  if (laszip)
+  if (fast_compression)
   {
-    if (!writer->setup(laszip->num_items, laszip->items, laszip))
+    fastwriter = new LASwritePointFast();
+    if (!fastwriter->setup(point.num_items, point.items, (chunk_size > 0 ? (U32)chunk_size : 50000)))
     {
-      fprintf(stderr,"ERROR: point type not supported\n");
+      fprintf(stderr,"ERROR: point type not supported by fast compression\n");
       return FALSE;
     }
   }
   else
   {
-    if (!writer->setup(point.num_items, point.items))
+    writer = new LASwritePoint();
+    if (laszip)
     {
-      fprintf(stderr,"ERROR: point type not supported\n");
-      return FALSE;
+      if (!writer->setup(laszip->num_items, laszip->items, laszip))
+      {
+        fprintf(stderr,"ERROR: point type not supported\n");
+        return FALSE;
+      }
+    }
+    else
+    {
+      if (!writer->setup(point.num_items, point.items))
+      {
+        fprintf(stderr,"ERROR: point type not supported\n");
+        return FALSE;
+      }
     }
   }
 
@@ -310,6 +360,7 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
   }
   U32 offset_to_point_data = header->offset_to_point_data;
   if (laszip) offset_to_point_data += (54 + laszip_vlr_data_size);
+  if (fast_compression) offset_to_point_data += (54 + 8);
   if (header->vlr_lastiling) offset_to_point_data += (54 + 28);
   if (header->vlr_lasoriginal) offset_to_point_data += (54 + 176);
   if (!stream->put32bitsLE((U8*)&offset_to_point_data))
@@ -319,6 +370,7 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
   }
   U32 number_of_variable_length_records = header->number_of_variable_length_records;
   if (laszip) number_of_variable_length_records++;
+  if (fast_compression) number_of_variable_length_records++;
   if (header->vlr_lastiling) number_of_variable_length_records++;
   if (header->vlr_lasoriginal) number_of_variable_length_records++;
   if (!stream->put32bitsLE((U8*)&(number_of_variable_length_records)))
@@ -327,6 +379,7 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
     return FALSE;
   }
   if (compressor) point_data_format |= 128;
+  if (fast_compression) point_data_format |= 64;
   if (!stream->putByte(point_data_format))
   {
     fprintf(stderr,"ERROR: writing header->point_data_format\n");
@@ -695,6 +748,58 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
     laszip = 0;
   }
 
+  // write VLR that marks the points as fast compressed
+
+  if (fast_compression)
+  {
+    U16 reserved = 0xAABB;
+    if (!stream->put16bitsLE((U8*)&(reserved)))
+    {
+      fprintf(stderr,"ERROR: writing reserved %d\n", (I32)reserved);
+      return FALSE;
+    }
+    U8 user_id[16];
+    memset(user_id, 0, 16);
+    strcpy((char*)user_id, LAS_POINT_FAST_USER_ID);
+    if (!stream->putBytes((U8*)user_id, 16))
+    {
+      fprintf(stderr,"ERROR: writing user_id %s\n", user_id);
+      return FALSE;
+    }
+    U16 record_id = LAS_POINT_FAST_RECORD_ID;
+    if (!stream->put16bitsLE((U8*)&(record_id)))
+    {
+      fprintf(stderr,"ERROR: writing record_id %d\n", (I32)record_id);
+      return FALSE;
+    }
+    U16 record_length_after_header = 8;
+    if (!stream->put16bitsLE((U8*)&(record_length_after_header)))
+    {
+      fprintf(stderr,"ERROR: writing record_length_after_header %d\n", (I32)record_length_after_header);
+      return FALSE;
+    }
+    char description[32];
+    memset(description, 0, 32);
+    sprintf(description, "fast points by LASlib (%d)", LAS_TOOLS_VERSION);
+    if (!stream->putBytes((U8*)description, 32))
+    {
+      fprintf(stderr,"ERROR: writing description %s\n", description);
+      return FALSE;
+    }
+    // write the data following the header of the variable length record
+    //     U16  version                   2 bytes
+    //     U16  coder                     2 bytes
+    //     U32  chunk_size                4 bytes
+    U16 version = LAS_POINT_FAST_VERSION;
+    U16 coder = LAS_POINT_FAST_CODER_LZ;
+    U32 fast_chunk_size = (chunk_size > 0 ? (U32)chunk_size : 50000);
+    if (!stream->put16bitsLE((U8*)&version) || !stream->put16bitsLE((U8*)&coder) || !stream->put32bitsLE((U8*)&fast_chunk_size))
+    {
+      fprintf(stderr,"ERROR: writing payload of fast compression VLR\n");
+      return FALSE;
+    }
+  }
+
   // write lastiling VLR with the tile parameters
 
   if (header->vlr_lastiling)
@@ -882,9 +987,56 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
     }
   }
 
-  // initialize the point writer
+  // raw records of these items are exactly their bytes in the point
 
-  if (!writer->init(stream)) return FALSE;
+  points_mappable = (compressor == LASZIP_COMPRESSOR_NONE) && !fast_compression && IS_LITTLE_ENDIAN();
+  for (i = 0; i < point.num_items; i++)
+  {
+    if ((point.items[i].type != LASitem::POINT10) && (point.items[i].type != LASitem::GPSTIME11) && (point.items[i].type != LASitem::RGB12) && (point.items[i].type != LASitem::WAVEPACKET13) && (point.items[i].type != LASitem::BYTE))
+    {
+      points_mappable = FALSE;
+    }
+  }
+  point_format = point_data_format;
+  point_record_length = (U16)point.total_point_size;
+
+  // mappable points are packed into blocks of records with a routine for their format
+
+  if (rawwriter) delete rawwriter;
+  rawwriter = 0;
+  raw_number = 0;
+  if (points_mappable && !chunk_copy)
+  {
+    rawwriter = new LASpointRaw();
+    if (rawwriter->setup(&point, point_data_format, point_record_length))
+    {
+      if (raw_records) delete [] raw_records;
+      raw_records = new U8[LAS_POINT_RAW_BLOCK*rawwriter->record_size];
+    }
+    else
+    {
+      delete rawwriter;
+      rawwriter = 0;
+    }
+  }
+
+  // initialize the point writer or reserve the chunk table start
+
+  if (chunk_copy)
+  {
+    chunk_table_start_position = stream->tell();
+    I64 unknown = -1;
+    if (!stream->put64bitsLE((U8*)&unknown)) return FALSE;
+    number_chunks = 0;
+  }
+  else if (fastwriter)
+  {
+    if (!fastwriter->init(stream)) return FALSE;
+  }
+  else if (!writer->init(stream))
+  {
+    return FALSE;
+  }
 
   npoints = header->number_of_point_records;
   p_count = 0;
@@ -894,15 +1046,204 @@ bool LASwriterLAS::open(ByteStreamOut* stream, const LASheader* header, U32 comp
 
 bool LASwriterLAS::write_point(const LASpoint* point)
 {
+  if (chunk_copy) return FALSE;
   p_count++;
+  if (rawwriter)
+  {
+    rawwriter->pack(point, &(raw_records[raw_number*rawwriter->record_size]));
+    raw_number++;
+    if (raw_number == LAS_POINT_RAW_BLOCK) return flush_raw_points();
+    return TRUE;
+  }
+  if (fastwriter) return fastwriter->write(point->point);
   return writer->write(point->point);
 }
 
+bool LASwriterLAS::flush_raw_points()
+{
+  if (raw_number == 0) return TRUE;
+  U32 number = raw_number;
+  raw_number = 0;
+  return stream->putBytes(raw_records, number*rawwriter->record_size);
+}
+
 bool LASwriterLAS::chunk()
 {
+  if (fastwriter) return fastwriter->chunk();
   return writer->chunk();
 }
 
+bool LASwriterLAS::takes_raw_points(U8 point_data_format, U16 point_data_record_length) const
+{
+  // the raw records of mappable points are also what LASwritePoint writes
+  return points_mappable && (mapped == 0) && (stream != 0) && (point_data_format == point_format) && (point_data_record_length == point_record_length);
+}
+
+bool LASwriterLAS::write_raw_points(const U8* records, U32 number)
+{
+  if (!flush_raw_points()) return FALSE;
+  if (!stream->putBytes(records, number*point_record_length)) return FALSE;
+  p_count += number;
+  return TRUE;
+}
+
+bool LASwriterLAS::write_chunk(const U8* bytes, U32 number_bytes, U32 number_points)
+{
+  if (!chunk_copy || (stream == 0)) return FALSE;
+  if (number_chunks == alloc_chunks)
+  {
+    alloc_chunks += 1024;
+    chunk_points = (U32*)realloc(chunk_points, sizeof(U32)*alloc_chunks);
+    chunk_bytes = (U32*)realloc(chunk_bytes, sizeof(U32)*alloc_chunks);
+    if ((chunk_points == 0) || (chunk_bytes == 0))
+    {
+      fprintf(stderr,"ERROR: cannot allocate chunk table for %u chunks\n", alloc_chunks);
+      return FALSE;
+    }
+  }
+  if (!stream->putBytes(bytes, number_bytes)) return FALSE;
+  chunk_points[number_chunks] = number_points;
+  chunk_bytes[number_chunks] = number_bytes;
+  number_chunks++;
+  p_count += number_points;
+  return TRUE;
+}
+
+// encodes the chunk table of variable chunks in the same way as LASwritePoint does
+
+bool LASwriterLAS::write_chunk_table()
+{
+  U32 i;
+  I64 position = stream->tell();
+  if (stream->isSeekable())
+  {
+    if (!stream->seek(chunk_table_start_position)) return FALSE;
+    if (!stream->put64bitsLE((U8*)&position)) return FALSE;
+    if (!stream->seek(position)) return FALSE;
+  }
+  U32 version = 0;
+  if (!stream->put32bitsLE((U8*)&version)) return FALSE;
+  if (!stream->put32bitsLE((U8*)&number_chunks)) return FALSE;
+  if (number_chunks)
+  {
+    ArithmeticEncoder enc;
+    enc.init(stream);
+    IntegerCompressor ic(&enc, 32, 2);
+    ic.initCompressor();
+    for (i = 0; i < number_chunks; i++)
+    {
+      ic.compress((i ? chunk_points[i-1] : 0), chunk_points[i], 0);
+      ic.compress((i ? chunk_bytes[i-1] : 0), chunk_bytes[i], 1);
+    }
+    enc.done();
+  }
+  if (!stream->isSeekable())
+  {
+    // readers find the chunk table via the last eight bytes
+    if (!stream->put64bitsLE((U8*)&position)) return FALSE;
+  }
+  return TRUE;
+}
+
+bool LASwriterLAS::map_points(I64 npoints)
+{
+  if (!points_mappable || (file == 0) || (p_count != 0) || mapped)
+  {
+    fprintf(stderr,"ERROR: can only map uncompressed standard points right after opening a file\n");
+    return FALSE;
+  }
+  if (!flush_raw_points()) return FALSE;
+
+  // everything in front of the points has to be in the file
+
+  if (async_stream)
+  {
+    if (!async_stream->flush()) return FALSE;
+  }
+  else if (fflush(file) != 0)
+  {
+    return FALSE;
+  }
+
+  I64 start = stream->tell();
+  I64 end = start + npoints*point_record_length;
+
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  mapped_start = start - (start % info.dwAllocationGranularity);
+  mapped_size = end - mapped_start;
+  HANDLE mapping = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(file)), NULL, PAGE_READWRITE, (DWORD)(end >> 32), (DWORD)(end & 0xFFFFFFFF), NULL);
+  if (mapping == NULL)
+  {
+    fprintf(stderr,"ERROR: cannot create file mapping of %I64d bytes\n", end);
+    return FALSE;
+  }
+  mapped = (U8*)MapViewOfFile(mapping, FILE_MAP_WRITE, (DWORD)(mapped_start >> 32), (DWORD)(mapped_start & 0xFFFFFFFF), (SIZE_T)mapped_size);
+  if (mapped == 0)
+  {
+    fprintf(stderr,"ERROR: cannot map %I64d bytes of file\n", mapped_size);
+    CloseHandle(mapping);
+    return FALSE;
+  }
+  mapped_handle = mapping;
+#else
+  int fd = fileno(file);
+  I64 page_size = (I64)sysconf(_SC_PAGESIZE);
+  mapped_start = start - (start % page_size);
+  mapped_size = end - mapped_start;
+  // reserving the blocks makes a full disk fail here instead of in a worker
+#ifdef __linux__
+  if (posix_fallocate(fd, 0, (off_t)end) != 0)
+#else
+  if (ftruncate(fd, (off_t)end) != 0)
+#endif
+  {
+    fprintf(stderr,"ERROR: cannot allocate %lld bytes for file\n", end);
+    return FALSE;
+  }
+  void* map = mmap(0, (size_t)mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)mapped_start);
+  if (map == MAP_FAILED)
+  {
+    fprintf(stderr,"ERROR: cannot map %lld bytes of file\n", mapped_size);
+    return FALSE;
+  }
+  mapped = (U8*)map;
+#endif
+
+  mapped_points = mapped + (start - mapped_start);
+  mapped_npoints = npoints;
+  stream->seekEnd();
+  return TRUE;
+}
+
+bool LASwriterLAS::write_point_at(I64 index, const LASpoint* point)
+{
+  if ((index < 0) || (index >= mapped_npoints)) return FALSE;
+  if (point->total_point_size != point_record_length) return FALSE;
+  point->copy_to(mapped_points + index*point_record_length);
+  return TRUE;
+}
+
+bool LASwriterLAS::unmap_points()
+{
+  if (mapped == 0) return TRUE;
+  bool success = TRUE;
+#ifdef _WIN32
+  if (!FlushViewOfFile(mapped, 0)) success = FALSE;
+  UnmapViewOfFile(mapped);
+  CloseHandle((HANDLE)mapped_handle);
+  mapped_handle = 0;
+#else
+  if (munmap(mapped, (size_t)mapped_size) != 0) success = FALSE;
+#endif
+  p_count += mapped_npoints;
+  mapped = 0;
+  mapped_points = 0;
+  mapped_npoints = 0;
+  return success;
+}
+
 bool LASwriterLAS::update_header(const LASheader* header, bool use_inventory, bool update_extra_bytes)
 {
   I32 i;
@@ -911,6 +1252,11 @@ bool LASwriterLAS::update_header(const LASheader* header, bool use_inventory, bo
     fprintf(stderr,"ERROR: stream pointer is zero\n");
     return FALSE;
   }
+  if (!flush_raw_points())
+  {
+    fprintf(stderr,"ERROR: writing the last block of point records\n");
+    return FALSE;
+  }
   if (!stream->isSeekable())
   {
     fprintf(stderr,"WARNING: stream not seekable. cannot update header.\n");
@@ -1135,6 +1481,30 @@ bool LASwriterLAS::update_header(const LASheader* header, bool use_inventory, bo
 I64 LASwriterLAS::close(bool update_header)
 {
   I64 bytes = 0;
+  bool failed = FALSE;
+
+  if (!unmap_points())
+  {
+    fprintf(stderr, "ERROR: unmapping the point records failed\n");
+    failed = TRUE;
+  }
+
+  if (rawwriter)
+  {
+    if (!flush_raw_points())
+    {
+      fprintf(stderr, "ERROR: writing the last block of point records failed\n");
+      failed = TRUE;
+    }
+    delete rawwriter;
+    rawwriter = 0;
+  }
+  if (raw_records)
+  {
+    delete [] raw_records;
+    raw_records = 0;
+  }
+  raw_number = 0;
 
   if (p_count != npoints)
   {
@@ -1147,11 +1517,37 @@ I64 LASwriterLAS::close(bool update_header)
 
   if (writer) 
   {
-    writer->done();
+    if (!chunk_copy) writer->done();
     delete writer;
     writer = 0;
   }
 
+  if (fastwriter)
+  {
+    if (!fastwriter->done())
+    {
+      fprintf(stderr, "ERROR: writing last chunk and chunk table of fast compressed points failed\n");
+      failed = TRUE;
+    }
+    delete fastwriter;
+    fastwriter = 0;
+  }
+
+  if (chunk_copy && stream)
+  {
+    if (!write_chunk_table())
+    {
+      fprintf(stderr, "ERROR: cannot write chunk table of %u chunks\n", number_chunks);
+      failed = TRUE;
+    }
+    if (chunk_points) free(chunk_points);
+    if (chunk_bytes) free(chunk_bytes);
+    chunk_points = 0;
+    chunk_bytes = 0;
+    number_chunks = 0;
+    alloc_chunks = 0;
+  }
+
   if (stream)
   {
     if (update_header && p_count != npoints)
@@ -1180,6 +1576,16 @@ I64 LASwriterLAS::close(bool update_header)
       }
     }
     bytes = stream->tell() - header_start_position;
+    if (async_stream)
+    {
+      // errors of the I/O thread surface here
+      if (!async_stream->flush())
+      {
+        fprintf(stderr, "ERROR: writing blocks to file failed\n");
+        failed = TRUE;
+      }
+      async_stream = 0;
+    }
     delete stream;
     stream = 0;
   }
@@ -1193,18 +1599,41 @@ I64 LASwriterLAS::close(bool update_header)
   npoints = p_count;
   p_count = 0;
 
-  return bytes;
+  return (failed ? -1 : bytes);
 }
 
 LASwriterLAS::LASwriterLAS()
 {
   file = 0;
   stream = 0;
+  async_stream = 0;
+  async_buffers = 0;
   writer = 0;
+  fastwriter = 0;
+  fast_compression = FALSE;
+  rawwriter = 0;
+  raw_records = 0;
+  raw_number = 0;
   writing_las_1_4 = FALSE;
+  points_mappable = FALSE;
+  point_format = 0;
+  point_record_length = 0;
+  mapped = 0;
+  mapped_start = 0;
+  mapped_size = 0;
+  mapped_points = 0;
+  mapped_npoints = 0;
+  mapped_handle = 0;
+  chunk_copy = FALSE;
+  variable_chunking = FALSE;
+  chunk_table_start_position = -1;
+  number_chunks = 0;
+  alloc_chunks = 0;
+  chunk_points = 0;
+  chunk_bytes = 0;
 }
 
 LASwriterLAS::~LASwriterLAS()
 {
-  if (writer || stream) close();
+  if (writer || fastwriter || rawwriter || stream) close();
 }
@@ -31,6 +31,7 @@
 #include "laswriter_qfit.hpp"
 
 #include "bytestreamout_file.hpp"
+#include "bytestreamout_async.hpp"
 
 #ifdef _WIN32
 #include <fcntl.h>
@@ -44,6 +45,7 @@ bool LASwriterQFIT::refile(FILE* file)
 {
   if (stream == 0) return FALSE;
   if (this->file) this->file = file;
+  if (async_stream) return async_stream->refile(file);
   return ((ByteStreamOutFile*)stream)->refile(file);
 }
 
@@ -63,6 +65,23 @@ bool LASwriterQFIT::open(const char* file_name, const LASheader* header, I32 ver
     return FALSE;
   }
 
+  if (async_buffers)
+  {
+    // our blocks replace the stdio buffer
+    setvbuf(file, NULL, _IONBF, 0);
+    if (IS_LITTLE_ENDIAN())
+    {
+      async_stream = new ByteStreamOutFileAsyncLE(file, io_buffer_size, async_buffers);
+      endian_swap = FALSE;
+    }
+    else
+    {
+      async_stream = new ByteStreamOutFileAsyncBE(file, io_buffer_size, async_buffers);
+      endian_swap = TRUE;
+    }
+    return open(async_stream, header, version);
+  }
+
   if (setvbuf(file, NULL, _IOFBF, io_buffer_size) != 0)
   {
     fprintf(stderr, "WARNING: setvbuf() failed with buffer size %u\n", io_buffer_size);
@@ -272,10 +291,21 @@ bool LASwriterQFIT::update_header(const LASheader* header, bool use_inventory, b
 I64 LASwriterQFIT::close(bool update_header)
 {
   I64 bytes = 0;
+  bool failed = FALSE;
   
   if (stream)
   {
     bytes = stream->tell();
+    if (async_stream)
+    {
+      // errors of the I/O thread surface here
+      if (!async_stream->flush())
+      {
+        fprintf(stderr, "ERROR: writing blocks to file failed\n");
+        failed = TRUE;
+      }
+      async_stream = 0;
+    }
     delete stream;
     stream = 0;
   }
@@ -289,12 +319,14 @@ I64 LASwriterQFIT::close(bool update_header)
   npoints = p_count;
   p_count = 0;
 
-  return bytes;
+  return (failed ? -1 : bytes);
 }
 
 LASwriterQFIT::LASwriterQFIT()
 {
   stream = 0;
+  async_stream = 0;
+  async_buffers = 0;
   file = 0;
   version = 0;
   endian_swap = FALSE;